@@ -0,0 +1,577 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * ahead of time compiler: each function body and each loop of the
+ * program's linear bytecode is written as a c function. jumps are gotos,
+ * and ints that the compiler checked (constants, variables read by int
+ * operations and their results) are kept in c locals instead of on the
+ * operand stack, so int expressions, conditions, comparisons of variables
+ * and increments are plain c. other instructions call the interpreter's
+ * code for them, and errors go through it as well, so they are reported
+ * at the same positions as in the vm. the executable embeds the bytecode
+ * (for its constants, names and top-level code, which the interpreter
+ * runs) and is linked against the runtime in libmango.a.
+ */
+#include "aot.h"
+#include "interp.h"
+#include "compiler.h"
+#include "error.h"
+#include "names.h"
+#include "mangodl.h"
+#include "argparse.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <signal.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* ints kept in c at once (more are pushed onto the operand stack) */
+#define AOT_STACK 32
+
+typedef unsigned char u8;
+
+extern int is_at_end;
+extern FILE *debug_file;
+extern char *prog_name;
+extern int program_arg_idx;
+extern int argparse_argc;
+extern char **argparse_argv;
+
+/* int kept in c in place of an item on top of the operand stack */
+typedef struct {
+	int is_const; /* constant or local */
+	int val; /* value of constant or number of local */
+} aotValue;
+
+/* c function being written for a region */
+typedef struct {
+	FILE *f; /* body */
+	aotValue stack[AOT_STACK]; /* items above those on the operand stack */
+	unsigned int n;
+	unsigned int n_locals;
+} aotState;
+
+/* target of the jump in an instruction (NULL if it doesn't jump) */
+static u8 *aotTarget(u8 *code, u8 *p) {
+
+	if (*p == OP_JMP || *p == OP_JMPF) return code + OP_GETUINT(p + 1);
+	if (*p == OP_CMPJMPF) return code + OP_GETUINT(p + 18);
+
+	return NULL;
+}
+
+/* c operator of an int operation */
+static char *aotOperator(u8 op) {
+
+	switch (op) {
+
+		case OP_ADDINT: return "+";
+		case OP_SUBINT: return "-";
+		case OP_MULINT: return "*";
+		case OP_DIVINT: return "/";
+		case OP_MODINT: return "%";
+		case OP_EQINT: return "==";
+		case OP_NEINT: return "!=";
+		case OP_LTINT: return "<";
+		default: return ">";
+	}
+}
+
+/* write an int as a c expression */
+static char *aotExpr(aotValue *x, char *buf) {
+
+	if (!x->is_const) sprintf(buf, "s%d", x->val);
+	else if (x->val == INT_MIN) sprintf(buf, "(%d - 1)", INT_MIN + 1);
+	else sprintf(buf, "%d", x->val);
+
+	return buf;
+}
+
+/* push the ints kept in c onto the operand stack */
+static void aotFlush(aotState *s) {
+
+	char x[32];
+
+	for (unsigned int i = 0; i < s->n; i++)
+		fprintf(s->f, "\tinterpJitPushVal(%s);\n", aotExpr(&s->stack[i], x));
+
+	s->n = 0;
+}
+
+/* keep a constant or a new local in c */
+static aotValue *aotPush(aotState *s, int is_const, int val) {
+
+	if (s->n == AOT_STACK)
+		aotFlush(s);
+
+	s->stack[s->n].is_const = is_const;
+	s->stack[s->n].val = is_const? val: (int)s->n_locals++;
+
+	return &s->stack[s->n++];
+}
+
+/*
+ * find the LOADSLOTs whose values are only used by int operations, with
+ * nothing in between that could change them (these are read into locals)
+ */
+static void aotIntLoads(u8 *start, u8 *stop, u8 *target, u8 *int_use) {
+
+	unsigned int pushed[AOT_STACK]; /* LOADSLOT that pushed each item (+1, 0 if it wasn't one) */
+	unsigned int n = 0;
+	int pops;
+
+	for (u8 *p = start; p < stop; p += compilerOpLen(p)) {
+
+		if (target[p - start])
+			n = 0;
+
+		if (*p == OP_PUSHINT || *p == OP_LOADSLOT) pops = 0;
+		else if (*p == OP_NEGINT || *p == OP_ADDIMM) pops = 1;
+		else if (*p >= OP_ADDINT && *p <= OP_GTINT) pops = 2;
+
+		/* anything else may use or change the values */
+		else {
+
+			n = 0;
+			continue;
+		}
+
+		for (; pops > 0 && n > 0; pops--) {
+
+			if (pushed[--n])
+				int_use[pushed[n] - 1] = 1;
+		}
+
+		if (n == AOT_STACK)
+			n = 0;
+
+		pushed[n++] = (*p == OP_LOADSLOT)? (unsigned int)(p - start) + 1: 0;
+	}
+}
+
+/* write a jump to an instruction (a goto if it is in the region, a return to the interpreter if not) */
+static void aotWriteJump(FILE *f, u8 *code, u8 *start, u8 *stop, u8 *to) {
+
+	if (to >= start && to < stop) fprintf(f, "goto L%08x;\n", (unsigned int)(to - code));
+	else fprintf(f, "return c + %u;\n", (unsigned int)(to - code));
+}
+
+/* write an instruction as c, keeping ints in c where the compiler checked them (0 if it is left to aotWriteCall) */
+static int aotWriteC(aotState *s, u8 *code, u8 *start, u8 *stop, u8 *p, u8 *int_use) {
+
+	unsigned int pos = (unsigned int)(p - code);
+	char x[32], y[32];
+	aotValue *a;
+
+	switch (*p) {
+
+		case OP_PUSHINT:
+
+			aotPush(s, 1, OP_GETINT(p + 1));
+			return 1;
+
+		/* variable read by int operations */
+		case OP_LOADSLOT:
+
+			if (!int_use[p - start])
+				return 0;
+
+			a = aotPush(s, 0, 0);
+			fprintf(s->f, "\tif ((a = interpLoadSlot(v, c + %u)) == NULL) { interpJitLoadSlot(v, c + %u); return NULL; }\n", pos + 1, pos);
+			fprintf(s->f, "\ts%d = AOT_INTOF(a);\n", a->val);
+			return 1;
+
+		case OP_ADDINT: case OP_SUBINT: case OP_MULINT: case OP_DIVINT: case OP_MODINT:
+		case OP_EQINT: case OP_NEINT: case OP_LTINT: case OP_GTINT:
+
+			/* division by a constant zero traps in the interpreter */
+			if (s->n < 2 || ((*p == OP_DIVINT || *p == OP_MODINT) && s->stack[s->n - 1].is_const && s->stack[s->n - 1].val == 0))
+				return 0;
+
+			aotExpr(&s->stack[s->n - 2], x);
+			aotExpr(&s->stack[s->n - 1], y);
+			s->n -= 2;
+
+			a = aotPush(s, 0, 0);
+			fprintf(s->f, "\ts%d = %s %s %s;\n", a->val, x, aotOperator(*p), y);
+			return 1;
+
+		case OP_NEGINT:
+		case OP_ADDIMM:
+
+			if (s->n < 1)
+				return 0;
+
+			aotExpr(&s->stack[--s->n], x);
+			a = aotPush(s, 0, 0);
+
+			if (*p == OP_NEGINT) fprintf(s->f, "\ts%d = -%s;\n", a->val, x);
+			else fprintf(s->f, "\ts%d = %s + %d;\n", a->val, x, OP_GETINT(p + 1));
+			return 1;
+
+		case OP_POP:
+
+			if (s->n < 1)
+				return 0;
+
+			s->n--;
+			return 1;
+
+		/* condition computed in c (an int) */
+		case OP_JMPF:
+
+			if (s->n < 1)
+				return 0;
+
+			aotExpr(&s->stack[--s->n], x);
+			aotFlush(s);
+
+			fprintf(s->f, "\tif (%s == 0) ", x);
+			aotWriteJump(s->f, code, start, stop, aotTarget(code, p));
+			return 1;
+
+		/* comparison of two int or chr variables (errors are set by the interpreter) */
+		case OP_CMPJMPF:
+
+			aotFlush(s);
+			fprintf(s->f, "\ta = interpLoadSlot(v, c + %u);\n\tb = interpLoadSlot(v, c + %u);\n", pos + 2, pos + 10);
+			fprintf(s->f, "\tif (a == NULL || b == NULL) { interpCmpSlots(v, c + %u); return NULL; }\n", pos);
+			fprintf(s->f, "\tif (!(AOT_INTOF(a) %s AOT_INTOF(b))) ", aotOperator(p[1]));
+			aotWriteJump(s->f, code, start, stop, aotTarget(code, p));
+			return 1;
+
+		/* increment of an int variable (anything else is left to the interpreter) */
+		case OP_INCSLOT:
+		case OP_DECSLOT:
+
+			aotFlush(s);
+			fprintf(s->f, "\ta = interpLoadSlot(v, c + %u);\n", pos + 1);
+			fprintf(s->f, "\tif (a != NULL && !IMM_IS(a) && a->type == OBJECT_INT) O_INT(a)->val %s= 1;\n", (*p == OP_INCSLOT)? "+": "-");
+			fprintf(s->f, "\telse if (interpIncSlot(v, c + %u) < 0) return NULL;\n", pos);
+			return 1;
+	}
+
+	return 0;
+}
+
+/* write an instruction as a call of the interpreter's code for it */
+static void aotWriteCall(aotState *s, u8 *code, u8 *start, u8 *stop, u8 *p) {
+
+	unsigned int pos = (unsigned int)(p - code);
+	jitOp op = jitOpOf(*p);
+	FILE *f = s->f;
+
+	aotFlush(s);
+
+	/* jump */
+	if (*p == OP_JMP) {
+
+		fprintf(f, "\t");
+		aotWriteJump(f, code, start, stop, aotTarget(code, p));
+	}
+
+	/* left to the interpreter */
+	else if (op.fn == NULL) fprintf(f, "\treturn c + %u;\n", pos);
+
+	/* call (linear functions are called by the interpreter) */
+	else if (*p == OP_CALL) fprintf(f, "\tif ((st = %s(v, c + %u)) == -2) return c + %u;\n\tif (st) return NULL;\n", op.name, pos, pos);
+
+	/* jump if false */
+	else if (*p == OP_JMPF) {
+
+		fprintf(f, "\tif ((st = %s(v, c + %u)) == 0) ", op.name, pos);
+		aotWriteJump(f, code, start, stop, aotTarget(code, p));
+		fprintf(f, "\tif (st < 0) return NULL;\n");
+	}
+
+	else fprintf(f, "\tif (%s(v, c + %u)) return NULL;\n", op.name, pos);
+}
+
+/* write the code of a region as a c function */
+static void aotWriteRegion(FILE *f, u8 *code, u8 *start, u8 *end, unsigned int n) {
+
+	u8 *target = (u8 *)calloc(end - start, 1); /* instructions jumped to */
+	u8 *int_use = (u8 *)calloc(end - start, 1); /* LOADSLOTs read into locals */
+	u8 *stop, *p, *to;
+	int ch;
+
+	/* code after an invalid instruction is left to the interpreter */
+	for (stop = start; stop < end && *stop < OP_COUNT; stop += compilerOpLen(stop)) {
+
+		if ((to = aotTarget(code, stop)) != NULL && to >= start && to < end)
+			target[to - start] = 1;
+	}
+
+	aotIntLoads(start, stop, target, int_use);
+
+	/* body is written first, locals are declared once it is known how many there are */
+	aotState s = {tmpfile(), {{0, 0}}, 0, 0};
+
+	if (s.f == NULL) {
+
+		fprintf(stderr, "Could not create temporary file!\n");
+		exit(1);
+	}
+
+	for (p = start; p < stop; p += compilerOpLen(p)) {
+
+		/* items kept in c are on the operand stack at jump targets */
+		if (target[p - start]) {
+
+			aotFlush(&s);
+			fprintf(s.f, "L%08x:;\n", (unsigned int)(p - code));
+		}
+
+		if (!aotWriteC(&s, code, start, stop, p, int_use))
+			aotWriteCall(&s, code, start, stop, p);
+	}
+
+	aotFlush(&s);
+	fprintf(s.f, "\treturn c + %u;\n}\n\n", (unsigned int)(stop - code));
+
+	fprintf(f, "/* %08x-%08x */\n", (unsigned int)(start - code), (unsigned int)(end - code));
+	fprintf(f, "static unsigned char *r%u(vm *v) {\n\n\tunsigned char *c = v->code;\n\tobject *a, *b;\n\tint st;\n", n);
+
+	for (unsigned int i = 0; i < s.n_locals; i++)
+		fprintf(f, "%s s%u", (i % 16)? ",": (i? ";\n\tint": "\tint"), i);
+
+	fprintf(f, "%s\n", s.n_locals? ";\n": "");
+
+	rewind(s.f);
+
+	while ((ch = fgetc(s.f)) != EOF)
+		fputc(ch, f);
+
+	fclose(s.f);
+	free(int_use);
+	free(target);
+}
+
+/* write a region unless one with the same first instruction was written */
+static void aotAddRegion(FILE *f, u8 *code, u8 *start, u8 *end, unsigned int **starts, unsigned int *n) {
+
+	unsigned int i;
+	for (i = 0; i < *n && (*starts)[i] != start - code; i++);
+
+	if (i < *n)
+		return;
+
+	*starts = (unsigned int *)realloc(*starts, sizeof(unsigned int) * (*n + 1));
+	(*starts)[*n] = (unsigned int)(start - code);
+
+	aotWriteRegion(f, code, start, end, (*n)++);
+}
+
+/* directory with the runtime: $MANGO_AOT_DIR, the directory of the mango executable if it was built there, or where it is installed */
+static char *aotRuntimeDir() {
+
+	static char dir[4096];
+	char *env = getenv("MANGO_AOT_DIR");
+	ssize_t len;
+
+	if (env != NULL && *env != '\0')
+		return env;
+
+	/* path of the executable (from argv[0] if /proc isn't there) */
+	if ((len = readlink("/proc/self/exe", dir, sizeof(dir) - 16)) > 0) dir[len] = '\0';
+	else if (strlen(prog_name) < sizeof(dir) - 16) strcpy(dir, prog_name);
+	else dir[0] = '\0';
+
+	char *slash = strrchr(dir, '/');
+
+	if (slash != NULL) {
+
+		strcpy(slash, "/libmango.a");
+
+		if (access(dir, R_OK) == 0) {
+
+			*slash = '\0';
+			return dir;
+		}
+	}
+
+	return AOT_DIR;
+}
+
+/* run a program with arguments (no shell is involved, so file names are passed as they are) */
+static int aotRun(char **args) {
+
+	int status;
+	pid_t pid = fork();
+
+	if (pid == 0) {
+
+		execvp(args[0], args);
+		_exit(127);
+	}
+
+	if (pid < 0 || waitpid(pid, &status, 0) < 0)
+		return -1;
+
+	return (WIFEXITED(status) && WEXITSTATUS(status) == 0)? 0: -1;
+}
+
+/* write linear bytecode as a c file and build an executable from it */
+extern void aotWrite(bytecode *bc, char *fname) {
+
+	unsigned int code_off, code_len, fn_off, fn_len;
+
+	/* tree bytecode is run by vmHandle */
+	if (bc->is_tree || bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_CODE, &code_off, &code_len) < 0) {
+
+		fprintf(stderr, "Only linear bytecode can be compiled to C (don't use '-t')\n");
+		return;
+	}
+
+	FILE *f = fopen(fname, "w");
+
+	if (f == NULL) {
+
+		fprintf(stderr, "Could not open file '%s'!\n", fname);
+		return;
+	}
+
+	u8 *code = &bc->bytes[code_off];
+	u8 *code_end = code + code_len;
+
+	fprintf(f, "/* compiled by mango from '%s' */\n#include \"aot.h\"\n#include \"interp.h\"\n\n", bc->curr_fname);
+
+	/* bytecode */
+	fprintf(f, "static unsigned char bc[] = {");
+
+	for (unsigned int i = 0; i < bc->len; i++)
+		fprintf(f, "%s0x%02x,", (i % 12)? " ": "\n\t", bc->bytes[i]);
+
+	fprintf(f, "\n};\n\n");
+
+	unsigned int *starts = NULL;
+	unsigned int n = 0;
+
+	/* function bodies (from the function table) */
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_FUNCS, &fn_off, &fn_len);
+
+	for (unsigned int i = 0; i + 8 <= fn_len; i += 8) {
+
+		u8 *start = code + OP_GETUINT(&bc->bytes[fn_off + i]);
+		u8 *end = code + OP_GETUINT(&bc->bytes[fn_off + i + 4]);
+
+		aotAddRegion(f, code, start, end, &starts, &n);
+	}
+
+	/* loops */
+	for (u8 *p = code; p < code_end && *p < OP_COUNT; p += compilerOpLen(p)) {
+
+		u8 *start;
+
+		if (*p == OP_JMP && (start = aotTarget(code, p)) <= p)
+			aotAddRegion(f, code, start, p + 5, &starts, &n);
+	}
+
+	/* list of regions and entry point */
+	fprintf(f, "static aotRegion regions[] = {\n");
+
+	for (unsigned int i = 0; i < n; i++)
+		fprintf(f, "\t{%u, r%u},\n", starts[i], i);
+
+	fprintf(f, "\t{0, NULL}\n};\n\nint main(int argc, char **argv) {\n\n\treturn aotMain(argc, argv, bc, sizeof(bc), regions);\n}\n");
+
+	fclose(f);
+	free(starts);
+
+	/* build executable next to the c file */
+	char *exe = (char *)malloc(strlen(fname) + 1);
+	strcpy(exe, fname);
+
+	char *dot = strrchr(exe, '.');
+	if (dot != NULL) *dot = '\0';
+
+	char *dir = aotRuntimeDir();
+	char *lib = (char *)malloc(strlen(dir) + 16);
+	sprintf(lib, "%s/libmango.a", dir);
+
+	/* ints in compiled code wrap around as they do in the interpreter */
+	char *args[] = {AOT_CC, "-O2", "-fwrapv", fname, "-I", dir, lib, "-ldl", "-o", exe, NULL};
+
+	printf("building '%s'...\n", exe);
+
+	if (aotRun(args) < 0)
+		fprintf(stderr, "Could not build '%s' from '%s'!\n", exe, fname);
+
+	free(lib);
+	free(exe);
+}
+
+/* free everything at exit (as mango itself does) */
+static void aotEnd() {
+
+	is_at_end = 1;
+
+	argparse_free();
+	vmFreeAll();
+	mangodlCloseAll();
+	objectFreeAll();
+	namesFreeAtoms();
+	argparse_close_debug_file();
+}
+
+/* run a program that was compiled to c */
+extern int aotMain(int argc, char **argv, unsigned char *bc, unsigned int len, aotRegion *regions) {
+
+	prog_name = argv[0];
+	debug_file = stdout;
+
+	atexit(aotEnd);
+
+	signal(SIGINT, objectIntHandler);
+	signal(SIGSEGV, objectSegvHandler);
+
+	/* all arguments are passed to the program */
+	argparse_argv = argv;
+	argparse_argc = argc;
+	program_arg_idx = 1;
+
+	/* create a vm for the bytecode */
+	vm *v = vmNew(NULL);
+
+	v->bc = malloc(len);
+	v->bc_len = len;
+	v->ctx->fn = argv[0];
+	memcpy(v->bc, bc, len);
+
+	/* compiled regions are entered by the interpreter in place of jit code (the jit stays off) */
+	for (aotRegion *r = regions; r->fn != NULL; r++)
+		jitAdd(v, r->pos, r->fn);
+
+	/* execute code */
+	vmExec(v);
+
+	if (errorIsSet()) {
+
+		errorPrint();
+		return -1;
+	}
+
+	return 0;
+}
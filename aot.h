@@ -0,0 +1,51 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* aot.h -- compile linear bytecode to c and build it against the runtime */
+#ifndef _AOT_H
+#define _AOT_H
+
+#include "bytecode.h"
+#include "jit.h"
+
+/* c compiler and installed directory of the runtime (libmango.a and headers), set by the makefile */
+#ifndef AOT_CC
+#define AOT_CC "cc"
+#endif
+
+#ifndef AOT_DIR
+#define AOT_DIR "."
+#endif
+
+/* value of an int or chr that compiled code reads from a variable */
+#define AOT_INTOF(o) (IMM_IS(o)? IMM_VAL(o): ((o)->type == OBJECT_CHR)? O_CHR(o)->val: O_INT(o)->val)
+
+/* region of code compiled to c */
+typedef struct {
+	unsigned int pos; /* position of the first instruction in the code */
+	jitFunc fn; /* compiled code (NULL ends a list of regions) */
+} aotRegion;
+
+/* functions */
+extern void aotWrite(bytecode *bc, char *fname); /* write linear bytecode as a c file and build an executable from it */
+extern int aotMain(int argc, char **argv, unsigned char *bc, unsigned int len, aotRegion *regions); /* run a program that was compiled to c */
+
+#endif /* _AOT_H */
@@ -33,11 +33,16 @@ int filename_len = 0; /* length of filename list */
 int program_arg_idx = -1; /* program argument index */
 char **argparse_argv = NULL; /* argv */
 int argparse_argc = 0; /* argc */
+char *prog_name; /* program name */
 
 /* help information */
-static char *hlp_inf = "usage: %s [filename] [options]\n\noptions:\n    -cl       compile library\n    -cm       compile bytecode executable\n    -i        idata mode\n    -h        display help\n    --help    same as '-h'\n    -l [lib]  specify a library to run with\n    -d        print debug info\n    -df [f]   specify an output file for the debug log\n    --        pass following arguments to program\n\n";
-extern char *prog_name;
+static char *hlp_inf = "usage: %s [filename] [options]\n\noptions:\n    -cl       compile library\n    -cm       compile bytecode executable\n    -cc       compile to c and build a native executable\n    -i        store constants in a constant pool (with '-t')\n    -t        compile tree bytecode (old format)\n    -h        display help\n    --help    same as '-h'\n    -l [lib]  specify a library to run with\n    -d        print debug info\n    -df [f]   specify an output file for the debug log\n    -gc [n]   number of new objects before garbage is collected\n    -gcstep [n] number of objects checked per collection step (0 = all)\n    --max-stack [n] maximum depth of function calls\n    -O [n]    optimization level (0 = none, 1 = fold constants)\n    -jit      compile hot loops and functions to native code (x86-64 linux)\n    -jitcheck run with and without -jit and check that the output is the same\n    --        pass following arguments to program\n\n";
 extern FILE *debug_file;
+extern int gbc_len;
+extern int gbc_step;
+extern int vm_max_stack;
+extern int opt_level;
+extern int jit_enabled;
 
 /* set flag */
 extern int argparse_set_flag(unsigned int flag) {
@@ -53,6 +58,7 @@ extern int argparse_set_flag(unsigned int flag) {
 
 	/* set flag */
 	status_flags |= (1 << flag);
+	return 0;
 }
 
 /* get a flag */
@@ -82,6 +88,18 @@ extern int argparse_flag2bcm() {
 		return -1;
 	}
 
+	else if (argparse_get_flag(FLAG_COMP_C) &&
+			 (argparse_get_flag(FLAG_COMP_LIB) || argparse_get_flag(FLAG_COMP_BIN))) {
+
+		/* print error and return */
+		fprintf(stderr, "Invalid combination of options 'cc' and '%s'\n", argparse_get_flag(FLAG_COMP_LIB)? "cl": "cm");
+		return -1;
+	}
+
+	/* compile to c */
+	else if (argparse_get_flag(FLAG_COMP_C))
+		return BYTECODE_CC;
+
 	/* compile a library */
 	else if (argparse_get_flag(FLAG_COMP_LIB))
 		return BYTECODE_CLIB;
@@ -130,9 +148,13 @@ extern int argparse(int argc, char **argv) {
 		/* one argument */
 		if (!strcmp(argv[argidx], "-cl") ||
 			!strcmp(argv[argidx], "-cm") ||
+			!strcmp(argv[argidx], "-cc") ||
 			!strcmp(argv[argidx], "-i")  ||
+			!strcmp(argv[argidx], "-t")  ||
 			!strcmp(argv[argidx], "-h")  ||
 			!strcmp(argv[argidx], "-d")  ||
+			!strcmp(argv[argidx], "-jit") ||
+			!strcmp(argv[argidx], "-jitcheck") ||
 			!strcmp(argv[argidx], "--help")) {
 
 			int agp_res; /* result of argparse_one function */
@@ -149,7 +171,9 @@ extern int argparse(int argc, char **argv) {
 		}
 
 		/* two arguments */
-		else if (!strcmp(argv[argidx], "-l") || !strcmp(argv[argidx], "-df")) {
+		else if (!strcmp(argv[argidx], "-l") || !strcmp(argv[argidx], "-df") ||
+				 !strcmp(argv[argidx], "-gc") || !strcmp(argv[argidx], "-gcstep") ||
+				 !strcmp(argv[argidx], "--max-stack") || !strcmp(argv[argidx], "-O")) {
 
 			/* not enough arguments */
 			if ((argidx + 1) >= argc) {
@@ -217,6 +241,14 @@ extern int argparse_one(char *a) {
 			return -1;
 	}
 
+	/* tree bytecode */
+	else if (!strcmp(a, "-t")) {
+
+		/* set flag */
+		if (argparse_set_flag(FLAG_TREE) <= -1)
+			return -1;
+	}
+
 	/* compile library */
 	else if (!strcmp(a, "-cl")) {
 
@@ -233,6 +265,14 @@ extern int argparse_one(char *a) {
 			return -1;
 	}
 
+	/* compile c file */
+	else if (!strcmp(a, "-cc")) {
+
+		/* set flag */
+		if (argparse_set_flag(FLAG_COMP_C) <= -1)
+			return -1;
+	}
+
 	/* print help info and exit */
 	else if (!strcmp(a, "-h") || !strcmp(a, "--help")) {
 
@@ -250,6 +290,21 @@ extern int argparse_one(char *a) {
 		DEBUG = 1;
 	}
 
+	/* jit */
+	else if (!strcmp(a, "-jit")) {
+
+		/* set value */
+		jit_enabled = 1;
+	}
+
+	/* compare runs with and without the jit */
+	else if (!strcmp(a, "-jitcheck")) {
+
+		/* set flag */
+		if (argparse_set_flag(FLAG_JITCHECK) <= -1)
+			return -1;
+	}
+
 	return 0;
 }
 
@@ -285,6 +340,25 @@ extern int argparse_two(char *a, char *b) {
 		}
 	}
 
+	/* garbage collection, call depth and optimization level */
+	else if (!strcmp(a, "-gc") || !strcmp(a, "-gcstep") || !strcmp(a, "--max-stack") || !strcmp(a, "-O")) {
+
+		char *end;
+		long n = strtol(b, &end, 10);
+
+		/* not a number */
+		if (*b == '\0' || *end != '\0' || n < 0 || n > 0x7fffffff) {
+
+			fprintf(stderr, "Expected a number (%s)\n", a);
+			return -1;
+		}
+
+		if (!strcmp(a, "-gc")) gbc_len = (int)n;
+		else if (!strcmp(a, "-gcstep")) gbc_step = (int)n;
+		else if (!strcmp(a, "-O")) opt_level = (int)n;
+		else vm_max_stack = (int)n;
+	}
+
 	return 0;
 }
 
@@ -26,6 +26,9 @@
 #define FLAG_COMP_LIB (unsigned int)(0)
 #define FLAG_COMP_BIN (unsigned int)(1)
 #define FLAG_IDATA (unsigned int)(2)
+#define FLAG_TREE (unsigned int)(3)
+#define FLAG_JITCHECK (unsigned int)(4)
+#define FLAG_COMP_C (unsigned int)(5)
 
 /* functions */
 extern int argparse_set_flag(unsigned int); /* set a flag */
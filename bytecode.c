@@ -21,8 +21,10 @@
 
 /* header */
 #include "bytecode.h"
+#include "compiler.h" /* linear bytecode */
 #include "error.h" /* errors */
 #include "run.h" /* runlp */
+#include "names.h" /* namesIntern */
 #include <stdlib.h> /* malloc, realloc, free */
 #include <string.h> /* strcmp */
 #include <sys/stat.h> /* stat */
@@ -57,10 +59,15 @@ extern bytecode *bytecodeNew(node *n, unsigned int mode) {
 	bc->mode = mode;
 	bc->n = n;
 	bc->f = NULL;
-	bc->idata = (char **)malloc(8);
-	bc->i_len = 0;
-	bc->i_cap = 8;
+	bc->pool = (bytecodeConst *)malloc(sizeof(bytecodeConst) * 8);
+	bc->p_len = 0;
+	bc->p_cap = 8;
+	bc->p_index = (unsigned int *)calloc(16, sizeof(unsigned int));
+	bc->lines = (unsigned int *)malloc(sizeof(unsigned int) * 3 * 8);
+	bc->l_len = 0;
+	bc->l_cap = 8;
 	bc->is_idat = 0;
+	bc->is_tree = 0;
 
 	/* return */
 	return bc;
@@ -80,87 +87,183 @@ extern void bytecodeAdd(bytecode *bc, unsigned char b) {
 	bc->bytes[bc->len++] = b;
 }
 
-/* add idata info */
-extern void bytecodeAddIdat(bytecode *bc, char *s) {
+/* hash of a constant (strings by the hash namesIntern keeps with them) */
+static unsigned int bytecodeHashConst(unsigned char type, char *s, int val) {
+
+	if (type == 0x9B)
+		return (unsigned int)val * 2654435761u;
+
+	return NAMES_HASH(namesIntern(s)) ^ type;
+}
+
+/* position in the hash index of the pool where a constant is or would be added */
+static unsigned int bytecodeFindConst(bytecode *bc, unsigned int h, unsigned char type, char *s, int val) {
+
+	unsigned int mask = bc->p_cap * 2 - 1;
+	unsigned int i = h & mask;
+
+	for (; bc->p_index[i]; i = (i + 1) & mask) {
+
+		bytecodeConst *k = &bc->pool[bc->p_index[i] - 1];
+
+		if (k->type == type && ((type == 0x9B)? k->val == val: !strcmp(k->s, s)))
+			break;
+	}
+
+	return i;
+}
+
+/* add a constant to the pool and get its index (constants that are already in it are reused) */
+extern unsigned int bytecodeAddConst(bytecode *bc, unsigned char type, char *s, int val) {
+
+	/* search for existing constant */
+	unsigned int h = bytecodeHashConst(type, s, val);
+	unsigned int i = bytecodeFindConst(bc, h, type, s, val);
+
+	if (bc->p_index[i])
+		return bc->p_index[i] - 1;
+
+	/* resize (and rebuild index) */
+	if (bc->p_len >= bc->p_cap) {
+
+		bc->p_cap *= 2;
+		bc->pool = (bytecodeConst *)realloc(bc->pool, sizeof(bytecodeConst) * bc->p_cap);
+
+		free(bc->p_index);
+		bc->p_index = (unsigned int *)calloc(bc->p_cap * 2, sizeof(unsigned int));
+
+		for (unsigned int j = 0; j < bc->p_len; j++) {
+
+			bytecodeConst *k = &bc->pool[j];
+			bc->p_index[bytecodeFindConst(bc, bytecodeHashConst(k->type, k->s, k->val), k->type, k->s, k->val)] = j + 1;
+		}
+
+		i = bytecodeFindConst(bc, h, type, s, val);
+	}
+
+	bc->p_index[i] = bc->p_len + 1;
+
+	/* add constant */
+	bytecodeConst *k = &bc->pool[bc->p_len];
+
+	k->type = type;
+	k->val = val;
+	k->s = NULL;
+
+	if (type != 0x9B) {
+
+		k->s = (char *)malloc(strlen(s) + 1);
+		strcpy(k->s, s);
+	}
+
+	return bc->p_len++;
+}
+
+/* add the position of the node that starts at the end of the code to the line table */
+extern void bytecodeAddLine(bytecode *bc, unsigned int lineno, unsigned int colno) {
 
 	/* resize */
-	if (bc->i_len >= bc->i_cap) {
+	if (bc->l_len >= bc->l_cap) {
 
-		bc->i_cap *= 2;
-		bc->idata = (char **)realloc(bc->idata, bc->i_cap);
+		bc->l_cap *= 2;
+		bc->lines = (unsigned int *)realloc(bc->lines, sizeof(unsigned int) * 3 * bc->l_cap);
 	}
 
-	/* malloc data */
-	char *s2 = (char *)malloc(strlen(s)+2);
-	strcpy(s2, s);
+	/* entries are added in order of offset, as nodes start */
+	unsigned int *l = &bc->lines[(bc->l_len++) * 3];
 
-	/* add data */
-	bc->idata[bc->i_len++] = s2;
+	l[0] = bc->len;
+	l[1] = lineno;
+	l[2] = colno;
 }
 
-/* compile node */
-extern void bytecodeComp(bytecode *bc) {
+/* write the line table (differences from the previous entry's offset and line, and the column of each entry) */
+static void bytecodeWriteLines(bytecode *bc) {
 
-	/* set current and previous filenames */
-	bc->curr_fname = bc->n->fname;
-	bc->prev_fname = bc->n->fname;
+	unsigned int pos = 0, lineno = 0;
 
-	/* write header */
-	bytecodeWriteHeader(bc);
+	for (unsigned int i = 0; i < bc->l_len; i++) {
 
-	/* write filename */
-	bytecodeWriteFileInf(bc, bc->curr_fname);
+		unsigned int *l = &bc->lines[i * 3];
+		int d = (int)(l[1] - lineno);
 
-	/* libraries */
-	if (lib_fnames != NULL) {
+		bytecodeWriteVarint(bc, l[0] - pos);
+		bytecodeWriteVarint(bc, ((unsigned int)d << 1) ^ (unsigned int)(d >> 31));
+		bytecodeWriteVarint(bc, l[2]);
 
-		for (int i = 0; i < lib_fnames_len; i++) {
+		pos = l[0];
+		lineno = l[1];
+	}
+}
 
-			/* write string */
-			bytecodeAdd(bc, 0xE0);
+/* write the constant pool (each entry is written the way its node is written outside of pool mode) */
+static void bytecodeWritePool(bytecode *bc) {
 
-			for (int k = 0; k < strlen(lib_fnames[i]); k++)
-				bytecodeAdd(bc, lib_fnames[i][k]);
+	bytecodeWriteVarint(bc, bc->p_len);
 
-			bytecodeAdd(bc, '.');
-			bytecodeAdd(bc, 'm');
-			bytecodeAdd(bc, 'l');
-			bytecodeAdd(bc, 0);
+	for (unsigned int i = 0; i < bc->p_len; i++) {
+
+		/* integer */
+		if (bc->pool[i].type == 0x9B) {
+
+			bytecodeWriteInt(bc, bc->pool[i].val);
+			continue;
 		}
+
+		/* string or identifier */
+		bytecodeAdd(bc, bc->pool[i].type);
+
+		for (char *s = bc->pool[i].s; *s; s++)
+			bytecodeAdd(bc, (unsigned char)*s);
+
+		bytecodeAdd(bc, 0x00);
 	}
+}
 
-	/* compile */
-	bytecodeWrite(bc, bc->n);
+/* compile node */
+extern void bytecodeComp(bytecode *bc) {
 
-	/* idata byte */
-	if (bc->is_idat) {
+	/* linear bytecode */
+	if (!bc->is_tree) {
 
-		bytecodeAdd(bc, 0xFD);
+		compiler *c = compilerNew(bc);
+		compilerComp(c);
+		compilerFree(c);
+		return;
+	}
 
-		/* idata table */
-		unsigned int idat_table = bc->len; /* position of idata table */
-		unsigned int idat_table_len = (bc->i_len) * 6; /* each entry takes 6 bytes */
-		unsigned int idat_pos = idat_table + idat_table_len; /* position in idata table */
+	/* set current and previous filenames */
+	bc->curr_fname = bc->n->fname;
+	bc->prev_fname = bc->n->fname;
 
-		for (unsigned int i = 0; i < bc->i_len; i++) {
+	/* write header */
+	bytecodeWriteHeader(bc);
 
-			/* add bytes */
-			bytecodeAdd(bc, (unsigned int)i);
-			bytecodeWriteInt(bc, idat_pos);
+	unsigned int pos = bc->len; /* start of current section */
 
-			/* add to idat_pos */
-			idat_pos += strlen(bc->idata[i]) + 2;
-		}
+	/* write filename */
+	bytecodeWriteFileInf(bc, bc->curr_fname);
 
-		/* write idata */
-		for (unsigned int i = 0; i < bc->i_len; i++) {
+	/* compile */
+	bytecodeWrite(bc, bc->n);
 
-			bytecodeWriteStrI(bc, bc->idata[i]);
-		}
-	}
+	if (errorIsSet())
+		return;
+
+	bytecodeSetSection(bc, BYTECODE_SECT_CODE, pos, bc->len - pos);
+
+	/* constant pool */
+	pos = bc->len;
+	bytecodeWritePool(bc);
+	bytecodeSetSection(bc, BYTECODE_SECT_POOL, pos, bc->len - pos);
 
-	/* add EOF byte */
-	bytecodeAdd(bc, BYTECODE_EOF);
+	/* line table */
+	pos = bc->len;
+	bytecodeWriteLines(bc);
+	bytecodeSetSection(bc, BYTECODE_SECT_LINES, pos, bc->len - pos);
+
+	/* libraries */
+	bytecodeWriteLibs(bc);
 }
 
 /* write node */
@@ -177,12 +280,21 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 		bytecodeWriteFileInf(bc, bc->curr_fname);
 	}
 
+	/* position of node (found by its offset if an error occurs) */
+	if (n->type != NODE_STATEMENTS && n->type != NODE_INCLUDE)
+		bytecodeAddLine(bc, n->lineno, n->colno);
+
+	/* value folded into a constant */
+	if (n->is_const) {
+
+		bytecodeWriteIntConst(bc, n->const_val);
+	}
+
 	/* integer */
-	if (n->type == NODE_INT) {
+	else if (n->type == NODE_INT) {
 
 		/* write integer */
-		bytecodeWriteInt(bc, atoi(n->tokens[0]->t_value));
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
+		bytecodeWriteIntConst(bc, atoi(n->tokens[0]->t_value));
 	}
 
 	/* string */
@@ -190,7 +302,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write string */
 		bytecodeWriteStr(bc, n->tokens[0]->t_value);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* statements */
@@ -208,7 +319,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteVarAcc(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* function call */
@@ -216,7 +326,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteCall(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* increment operator */
@@ -224,7 +333,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteInc(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* decrement operator */
@@ -232,7 +340,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteDec(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* binary operation */
@@ -240,7 +347,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteBinOp(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* unary operation */
@@ -248,7 +354,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteUnOp(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* getitem */
@@ -256,7 +361,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteGetItem(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* setitem */
@@ -264,7 +368,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteSetItem(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* undefined variable */
@@ -272,7 +375,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteVarUndefined(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* new variable */
@@ -280,7 +382,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteVarNew(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* if statement */
@@ -288,7 +389,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteIfStatement(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* while loop */
@@ -296,7 +396,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteWhile(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* for loop */
@@ -304,7 +403,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteFor(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* function declaration */
@@ -312,7 +410,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteFuncDec(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* function definition */
@@ -320,7 +417,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 		
 		/* write node */
 		bytecodeWriteFuncDef(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* extern */
@@ -328,7 +424,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteExtern(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* typedef */
@@ -336,7 +431,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteTypeDef(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* struct */
@@ -344,7 +438,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteStruct(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* variable assignment */
@@ -352,7 +445,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteVarAsg(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* else node */
@@ -360,7 +452,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteElse(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	/* include a file */
@@ -387,7 +478,6 @@ extern void bytecodeWrite(bytecode *bc, node *n) {
 
 		/* write node */
 		bytecodeWriteCUR(bc, n);
-		bytecodeWriteErrInf(bc, n->lineno, n->colno);
 	}
 
 	else {
@@ -429,21 +519,70 @@ extern void bytecodeWriteHeader(bytecode *bc) {
 		bytecodeAdd(bc, 0x0E);
 	}
 
-	/* idata inf */
-	bytecodeAdd(bc, 0x00);
+	/* version and flags */
+	bytecodeAdd(bc, BYTECODE_VERSION);
 	bytecodeAdd(bc, 0x00);
 	bytecodeAdd(bc, 0x00);
-	bytecodeAdd(bc, (unsigned char)bc->is_idat);
+	bytecodeAdd(bc, bc->is_tree? (unsigned char)bc->is_idat: BYTECODE_FLAG_LINEAR);
+
+	/* section directory (filled in as sections are written) */
+	bytecodeWriteIntNS(bc, BYTECODE_SECT_COUNT);
+
+	for (int i = 0; i < BYTECODE_SECT_COUNT * 8; i++)
+		bytecodeAdd(bc, 0x00);
+}
+
+/* write the library section */
+extern void bytecodeWriteLibs(bytecode *bc) {
+
+	unsigned int pos = bc->len;
+
+	/* file name of each library */
+	for (int i = 0; i < lib_fnames_len; i++) {
+
+		for (char *s = lib_fnames[i]; *s; s++)
+			bytecodeAdd(bc, (unsigned char)*s);
+
+		bytecodeAdd(bc, '.');
+		bytecodeAdd(bc, 'm');
+		bytecodeAdd(bc, 'l');
+		bytecodeAdd(bc, 0);
+	}
+
+	bytecodeSetSection(bc, BYTECODE_SECT_LIBS, pos, bc->len - pos);
 }
 
-/* write error info */
-extern void bytecodeWriteErrInf(bytecode *bc, unsigned int lineno, unsigned int colno) {
+/* set the offset and size of a section in the header */
+extern void bytecodeSetSection(bytecode *bc, unsigned int sect, unsigned int off, unsigned int size) {
+
+	bytecodeInsertInt(bc, 12 + sect * 8, off);
+	bytecodeInsertInt(bc, 16 + sect * 8, size);
+}
+
+/* get the offset and size of a section of a file (-1 if it is out of bounds) */
+extern int bytecodeGetSection(unsigned char *b, unsigned int len, unsigned int sect, unsigned int *off, unsigned int *size) {
+
+	*off = 0;
+	*size = 0;
+
+	/* directory */
+	if (len < BYTECODE_HEADER_SIZE)
+		return -1;
 
-	/* write signature byte and line, column */
-	bytecodeAdd(bc, 0xFE);
+	/* number of sections */
+	unsigned int n = (b[8]<<24) | (b[9]<<16) | (b[10]<<8) | (b[11]);
+	if (n < BYTECODE_SECT_COUNT || sect >= BYTECODE_SECT_COUNT)
+		return -1;
 
-	bytecodeWriteIntNS(bc, lineno);
-	bytecodeWriteIntNS(bc, colno);
+	unsigned char *d = &b[12 + sect * 8];
+
+	*off = (d[0]<<24) | (d[1]<<16) | (d[2]<<8) | (d[3]);
+	*size = (d[4]<<24) | (d[5]<<16) | (d[6]<<8) | (d[7]);
+
+	if (*off > len || *size > len - *off)
+		return -1;
+
+	return 0;
 }
 
 /* write filename info */
@@ -457,17 +596,60 @@ extern void bytecodeWriteFileInf(bytecode *bc, char *fname) {
 	bytecodeWriteIdt(bc, fname);
 }
 
-/* write an integer */
+/* write an integer (zigzag encoded so small negative numbers are short too) */
 extern void bytecodeWriteInt(bytecode *bc, int i) {
 
 	/* write integer signature */
 	bytecodeAdd(bc, 0x9B);
 
 	/* write integer bytes */
-	bytecodeAdd(bc, (i >> 24) & 0xFF);
-	bytecodeAdd(bc, (i >> 16) & 0xFF);
-	bytecodeAdd(bc, (i >> 8) & 0xFF);
-	bytecodeAdd(bc, i & 0xFF);
+	bytecodeWriteVarint(bc, ((unsigned int)i << 1) ^ (unsigned int)(i >> 31));
+}
+
+/* write an integer value (a reference to the constant pool in pool mode) */
+extern void bytecodeWriteIntConst(bytecode *bc, int i) {
+
+	if (bc->is_idat) {
+
+		bytecodeAdd(bc, 0x9E);
+		bytecodeWriteVarint(bc, bytecodeAddConst(bc, 0x9B, NULL, i));
+		return;
+	}
+
+	bytecodeWriteInt(bc, i);
+}
+
+/* write an unsigned integer in as few bytes as it needs (LEB128, 7 bits per byte, low bits first) */
+extern void bytecodeWriteVarint(bytecode *bc, unsigned int i) {
+
+	while (i >= 0x80) {
+
+		bytecodeAdd(bc, (i & 0x7F) | 0x80);
+		i >>= 7;
+	}
+
+	bytecodeAdd(bc, i);
+}
+
+/* read an unsigned integer written by bytecodeWriteVarint and get the number of bytes it takes */
+extern unsigned int bytecodeGetVarint(unsigned char *p, unsigned int *len) {
+
+	unsigned int i = 0;
+	unsigned int n = 0;
+
+	do i |= (p[n] & 0x7F) << (7 * n);
+	while (p[n++] & 0x80 && n < 5);
+
+	*len = n;
+	return i;
+}
+
+/* read the value of an integer written by bytecodeWriteInt (after its signature byte) */
+extern int bytecodeGetInt(unsigned char *p, unsigned int *len) {
+
+	unsigned int i = bytecodeGetVarint(p, len);
+
+	return (int)(i >> 1) ^ -(int)(i & 1);
 }
 
 /* integer */
@@ -480,6 +662,26 @@ extern void bytecodeInsertInt(bytecode *bc, unsigned int l, int i) {
 	bc->bytes[l+3] = (i & 0xFF);
 }
 
+/* insert an unsigned integer (LEB128) at location, moving the bytes after it */
+extern void bytecodeInsertVarint(bytecode *bc, unsigned int l, unsigned int i) {
+
+	unsigned int end = bc->len;
+
+	/* write at the end and move into place */
+	bytecodeWriteVarint(bc, i);
+
+	unsigned int n = bc->len - end;
+	unsigned char b[5];
+
+	memcpy(b, &bc->bytes[end], n);
+	memmove(&bc->bytes[l + n], &bc->bytes[l], end - l);
+	memcpy(&bc->bytes[l], b, n);
+
+	/* nodes after it have moved */
+	for (unsigned int k = bc->l_len; k > 0 && bc->lines[(k - 1) * 3] >= l; k--)
+		bc->lines[(k - 1) * 3] += n;
+}
+
 /* write an integer without signature byte */
 extern void bytecodeWriteIntNS(bytecode *bc, int i) {
 
@@ -496,25 +698,10 @@ extern void bytecodeWriteStr(bytecode *bc, char *s) {
 	/* add signature */
 	bytecodeAdd(bc, 0x9E);
 
-	/* idata */
-	if (bc->is_idat == 1) {
-
-		/* get idx */
-		int idx;
-		for (idx = 0; idx < bc->i_len; idx++) {
-
-			/* break */
-			if (!strcmp(bc->idata[idx], s))
-				break;
-		}
-
-		/* need to add */
-		if (idx == bc->i_len)
-			bytecodeAddIdat(bc, s);
-
-		/* add byte */
-		bytecodeAdd(bc, (unsigned char)idx);
+	/* reference to constant pool */
+	if (bc->is_idat) {
 
+		bytecodeWriteVarint(bc, bytecodeAddConst(bc, 0x9E, s, 0));
 		return;
 	}
 
@@ -529,38 +716,11 @@ extern void bytecodeWriteStr(bytecode *bc, char *s) {
 	bytecodeAdd(bc, 0x00);
 }
 
-/* write a string and ignore idata mode */
-extern void bytecodeWriteStrI(bytecode *bc, char *s) {
-
-	/* add signature */
-	bytecodeAdd(bc, 0x9E);
-
-	/* loop through string */
-	char c;
-	while (c = *s++) {
-
-		bytecodeAdd(bc, (unsigned char)c); /* add char */
-	}
-
-	/* add null term char */
-	bytecodeAdd(bc, 0x00);
-}
-
 /* write an identifier */
 extern void bytecodeWriteIdt(bytecode *bc, char *s) {
 
-	/* add signature */
-	bytecodeAdd(bc, 0x9F);
-
-	/* loop through string */
-	char c;
-	while (c = *s++) {
-
-		bytecodeAdd(bc, (unsigned char)c); /* add char */
-	}
-
-	/* add null term char */
-	bytecodeAdd(bc, 0x00);
+	/* reference to constant pool */
+	bytecodeWriteVarint(bc, bytecodeAddConst(bc, 0x9F, s, 0));
 }
 
 /* write a function call */
@@ -577,7 +737,7 @@ extern void bytecodeWriteCall(bytecode *bc, node *n) {
 		return;
 
 	/* write number of arguments */
-	bytecodeWriteInt(bc, n->n_of_children-1);
+	bytecodeWriteVarint(bc, n->n_of_children-1);
 
 	/* write arguments */
 	for (unsigned int i = 1; i < n->n_of_children; i++) {
@@ -597,7 +757,7 @@ extern void bytecodeWriteVarAcc(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0xD6);
 
 	/* write number of tokens */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write each name */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -613,7 +773,7 @@ extern void bytecodeWriteInc(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0xD3);
 
 	/* write number of tokens */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write each name */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -629,7 +789,7 @@ extern void bytecodeWriteDec(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0xD4);
 
 	/* write number of tokens */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write each name */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -672,7 +832,7 @@ extern void bytecodeWriteGetItem(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0x9A);
 
 	/* write number of tokens */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write each name */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -691,7 +851,7 @@ extern void bytecodeWriteSetItem(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0xDD);
 
 	/* write number of tokens */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write each name */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -763,35 +923,31 @@ extern void bytecodeWriteIfStatement(bytecode *bc, node *n) {
 	bytecodeWrite(bc, n->children[0]);
 
 	/* write number of body nodes */
-	bytecodeWriteInt(bc, n->n_of_children-1);
+	bytecodeWriteVarint(bc, n->n_of_children-1);
 
-	/* integer for length of body nodes */
-	unsigned int bcl_n = (bc->len + 1);
-	bytecodeWriteInt(bc, 0);
+	/* length of body nodes is inserted before them */
 	unsigned int bcl = bc->len;
 
 	/* write body nodes */
 	for (unsigned int i = 1; i < n->n_of_children - n->values[0]; i++)
 		bytecodeWrite(bc, n->children[i]);
 
-	/* change original number */
-	bytecodeInsertInt(bc, bcl_n, bc->len - bcl);
+	/* insert length */
+	bytecodeInsertVarint(bc, bcl, bc->len - bcl);
 
 	/* else block */
 	bytecodeAdd(bc, n->values[0]);
 
 	if (n->values[0]) {
 
-		/* integer for length of else node */
-		bcl_n = (bc->len + 1);
-		bytecodeWriteInt(bc, 0);
+		/* length of else node is inserted before it */
 		bcl = bc->len;
 
 		/* node */
 		bytecodeWrite(bc, n->children[n->n_of_children - 1]);
 
-		/* change number */
-		bytecodeInsertInt(bc, bcl_n, bc->len - bcl);
+		/* insert length */
+		bytecodeInsertVarint(bc, bcl, bc->len - bcl);
 	}
 }
 
@@ -805,19 +961,17 @@ extern void bytecodeWriteWhile(bytecode *bc, node *n) {
 	bytecodeWrite(bc, n->children[0]);
 
 	/* write number of body nodes */
-	bytecodeWriteInt(bc, n->n_of_children-1);
+	bytecodeWriteVarint(bc, n->n_of_children-1);
 
-	/* integer for length of body nodes */
-	unsigned int bcl_n = (bc->len + 1);
-	bytecodeWriteInt(bc, 0);
+	/* length of body nodes is inserted before them */
 	unsigned int bcl = bc->len;
 
 	/* write body nodes */
 	for (unsigned int i = 1; i < n->n_of_children; i++)
 		bytecodeWrite(bc, n->children[i]);
 
-	/* change original number */
-	bytecodeInsertInt(bc, bcl_n, bc->len - bcl);
+	/* insert length */
+	bytecodeInsertVarint(bc, bcl, bc->len - bcl);
 }
 
 /* write a for loop */
@@ -831,11 +985,9 @@ extern void bytecodeWriteFor(bytecode *bc, node *n) {
 		bytecodeWrite(bc, n->children[i]);
 
 	/* write number of body nodes */
-	bytecodeWriteInt(bc, n->n_of_children-3);
+	bytecodeWriteVarint(bc, n->n_of_children-3);
 
-	/* write size of nodes in for loop body */
-	unsigned int bcl_n = (bc->len + 1);
-	bytecodeWriteInt(bc, 0);
+	/* size of nodes in for loop body is inserted before them */
 	unsigned int bcl = bc->len;
 
 	/* write body nodes */
@@ -845,8 +997,8 @@ extern void bytecodeWriteFor(bytecode *bc, node *n) {
 	/* write increment node */
 	bytecodeWrite(bc, n->children[2]);
 
-	/* add number */
-	bytecodeInsertInt(bc, bcl_n, bc->len - bcl);
+	/* insert size */
+	bytecodeInsertVarint(bc, bcl, bc->len - bcl);
 }
 
 /* write function declaration */
@@ -863,7 +1015,7 @@ extern void bytecodeWriteFuncDec(bytecode *bc, node *n) {
 	bytecodeAdd(bc, (unsigned char)n->values[0]);
 
 	/* write number of arguments */
-	bytecodeWriteInt(bc, (n->n_of_tokens - 2) / 2);
+	bytecodeWriteVarint(bc, (n->n_of_tokens - 2) / 2);
 
 	/* write arguments */
 	for (unsigned int i = 2; i < n->n_of_tokens; i += 2) {
@@ -887,11 +1039,9 @@ extern void bytecodeWriteFuncDef(bytecode *bc, node *n) {
 	bytecodeWrite(bc, n->children[0]);
 
 	/* write number of body nodes */
-	bytecodeWriteInt(bc, n->n_of_children-1);
+	bytecodeWriteVarint(bc, n->n_of_children-1);
 
-	/* add an integer that will be used to determine how many bytes will the function body use */
-	unsigned int bcl_n = (bc->len + 1);
-	bytecodeWriteInt(bc, 0);
+	/* number of bytes the function body uses is inserted before it */
 	unsigned int bcl = bc->len;
 
 	/* write body nodes */
@@ -899,7 +1049,7 @@ extern void bytecodeWriteFuncDef(bytecode *bc, node *n) {
 		bytecodeWrite(bc, n->children[i]);
 
 	/* insert value */
-	bytecodeInsertInt(bc, bcl_n, bc->len - bcl);
+	bytecodeInsertVarint(bc, bcl, bc->len - bcl);
 }
 
 /* write an external reference */
@@ -932,7 +1082,7 @@ extern void bytecodeWriteStruct(bytecode *bc, node *n) {
 	bytecodeWriteIdt(bc, n->tokens[0]->t_value);
 
 	/* write number of nodes */
-	bytecodeWriteInt(bc, n->n_of_children);
+	bytecodeWriteVarint(bc, n->n_of_children);
 
 	/* struct value nodes */
 	for (unsigned int i = 0; i < n->n_of_children; i++) {
@@ -970,7 +1120,7 @@ extern void bytecodeWriteVarAsg(bytecode *bc, node *n) {
 	bytecodeAdd(bc, 0xD2);
 
 	/* number of names */
-	bytecodeWriteInt(bc, n->n_of_tokens);
+	bytecodeWriteVarint(bc, n->n_of_tokens);
 
 	/* write variable name tokens */
 	for (unsigned int i = 0; i < n->n_of_tokens; i++) {
@@ -1006,14 +1156,441 @@ extern void bytecodeWriteInclude(bytecode *bc, node *n, char *fname) {
 	nodeFree(pn);
 }
 
+/* file written before the header had a version (a pre-order dump of the node tree with fixed size integers and a position after each node) */
+typedef struct {
+	unsigned char *b; /* bytes of file */
+	unsigned int len; /* number of bytes */
+	unsigned int p; /* current position */
+	char **idata; /* strings of the idata table (idata mode) */
+	unsigned int n_idata; /* number of strings */
+} bytecodeOld;
+
+static int bytecodeOldNode(bytecode *bc, bytecodeOld *o);
+
+/* read a byte of an old file (-1 at the end) */
+static int bytecodeOldByte(bytecodeOld *o) {
+
+	if (o->p >= o->len)
+		return -1;
+
+	return o->b[o->p++];
+}
+
+/* read an integer of an old file, with or without its signature byte */
+static int bytecodeOldInt(bytecodeOld *o, int sig, int *i) {
+
+	if (sig && bytecodeOldByte(o) != 0x9B)
+		return -1;
+
+	if (o->len - o->p < 4)
+		return -1;
+
+	unsigned char *p = &o->b[o->p];
+	*i = (p[0]<<24) | (p[1]<<16) | (p[2]<<8) | (p[3]);
+
+	o->p += 4;
+	return 0;
+}
+
+/* read a string of an old file after a signature byte (none if sig is 0) */
+static char *bytecodeOldStr(bytecodeOld *o, unsigned char sig) {
+
+	if (sig && bytecodeOldByte(o) != sig)
+		return NULL;
+
+	char *s = (char *)&o->b[o->p];
+	unsigned char *end = (unsigned char *)memchr(s, 0, o->len - o->p);
+
+	if (end == NULL)
+		return NULL;
+
+	o->p = end - o->b + 1;
+	return s;
+}
+
+/* copy a number of names and the names */
+static int bytecodeOldNames(bytecode *bc, bytecodeOld *o) {
+
+	int n;
+	char *s;
+
+	if (bytecodeOldInt(o, 1, &n) < 0)
+		return -1;
+
+	bytecodeWriteVarint(bc, n);
+
+	for (int i = 0; i < n; i++) {
+
+		if ((s = bytecodeOldStr(o, 0x9F)) == NULL)
+			return -1;
+
+		bytecodeWriteIdt(bc, s);
+	}
+
+	return 0;
+}
+
+/* copy a number of nodes and nodes that take a number of bytes, inserting their new length */
+static int bytecodeOldBody(bytecode *bc, bytecodeOld *o, int count) {
+
+	int n, size;
+
+	if ((count && bytecodeOldInt(o, 1, &n) < 0) || bytecodeOldInt(o, 1, &size) < 0 || (unsigned int)size > o->len - o->p)
+		return -1;
+
+	if (count)
+		bytecodeWriteVarint(bc, n);
+
+	unsigned int end = o->p + size;
+	unsigned int bcl = bc->len;
+
+	while (o->p < end) {
+
+		if (bytecodeOldNode(bc, o) < 0)
+			return -1;
+	}
+
+	bytecodeInsertVarint(bc, bcl, bc->len - bcl);
+
+	return (o->p == end)? 0: -1;
+}
+
+/* copy a node of an old file (-1 if it is invalid) */
+static int bytecodeOldNode(bytecode *bc, bytecodeOld *o) {
+
+	int t, n, k;
+	char *s, *s2;
+
+	/* file names before the node */
+	while (o->p < o->len && o->b[o->p] == 0xFF) {
+
+		o->p++;
+
+		if ((s = bytecodeOldStr(o, 0x9F)) == NULL)
+			return -1;
+
+		bytecodeWriteFileInf(bc, s);
+	}
+
+	/* position of node (read after it) */
+	unsigned int l = bc->l_len;
+	bytecodeAddLine(bc, 0, 0);
+
+	/* signature byte (integers and strings are written by their functions) */
+	if ((t = bytecodeOldByte(o)) != 0x9B && t != 0x9E)
+		bytecodeAdd(bc, t);
+
+	switch (t) {
+
+		/* integer */
+		case 0x9B:
+
+			if (bytecodeOldInt(o, 0, &n) < 0)
+				return -1;
+
+			bytecodeWriteInt(bc, n);
+			break;
+
+		/* string */
+		case 0x9E:
+
+			/* string from idata table */
+			if (bc->is_idat) {
+
+				if ((n = bytecodeOldByte(o)) < 0 || (unsigned int)n >= o->n_idata)
+					return -1;
+
+				bytecodeWriteStr(bc, o->idata[n]);
+				break;
+			}
+
+			if ((s = bytecodeOldStr(o, 0)) == NULL)
+				return -1;
+
+			bytecodeWriteStr(bc, s);
+			break;
+
+		/* names */
+		case 0xD6: case 0xD3: case 0xD4:
+
+			if (bytecodeOldNames(bc, o) < 0)
+				return -1;
+			break;
+
+		/* names and a value */
+		case 0xD2: case 0x9A:
+
+			if (bytecodeOldNames(bc, o) < 0 || bytecodeOldNode(bc, o) < 0)
+				return -1;
+			break;
+
+		/* names, index and value */
+		case 0xDD:
+
+			if (bytecodeOldNames(bc, o) < 0 || bytecodeOldNode(bc, o) < 0 || bytecodeOldNode(bc, o) < 0)
+				return -1;
+			break;
+
+		/* function call */
+		case 0xD5:
+
+			if (bytecodeOldNode(bc, o) < 0 || bytecodeOldInt(o, 1, &n) < 0)
+				return -1;
+
+			bytecodeWriteVarint(bc, n);
+
+			for (int i = 0; i < n; i++) {
+
+				if (bytecodeOldNode(bc, o) < 0)
+					return -1;
+			}
+			break;
+
+		/* binary and unary operations */
+		case 0x9D: case 0x9C:
+
+			if ((n = bytecodeOldByte(o)) < 0)
+				return -1;
+
+			bytecodeAdd(bc, n);
+
+			if (bytecodeOldNode(bc, o) < 0 || (t == 0x9D && bytecodeOldNode(bc, o) < 0))
+				return -1;
+			break;
+
+		/* variables */
+		case 0xD1: case 0xD7:
+
+			if ((n = bytecodeOldByte(o)) < 0 || (s = bytecodeOldStr(o, 0x9F)) == NULL || (s2 = bytecodeOldStr(o, 0x9F)) == NULL)
+				return -1;
+
+			bytecodeAdd(bc, n);
+			bytecodeWriteIdt(bc, s);
+			bytecodeWriteIdt(bc, s2);
+
+			/* array and pointer */
+			if ((n = bytecodeOldByte(o)) < 0 || (k = bytecodeOldByte(o)) < 0)
+				return -1;
+
+			bytecodeAdd(bc, n);
+			bytecodeAdd(bc, k);
+
+			/* size of array and value */
+			if ((n && bytecodeOldNode(bc, o) < 0) || (t == 0xD1 && bytecodeOldNode(bc, o) < 0))
+				return -1;
+			break;
+
+		/* if statement */
+		case 0xD8:
+
+			if (bytecodeOldNode(bc, o) < 0 || bytecodeOldBody(bc, o, 1) < 0 || (n = bytecodeOldByte(o)) < 0)
+				return -1;
+
+			bytecodeAdd(bc, n);
+
+			/* else node */
+			if (n && bytecodeOldBody(bc, o, 0) < 0)
+				return -1;
+			break;
+
+		/* while loop and function definition */
+		case 0xD9: case 0xDC:
+
+			if (bytecodeOldNode(bc, o) < 0 || bytecodeOldBody(bc, o, 1) < 0)
+				return -1;
+			break;
+
+		/* for loop */
+		case 0xDA:
+
+			if (bytecodeOldNode(bc, o) < 0 || bytecodeOldNode(bc, o) < 0 || bytecodeOldBody(bc, o, 1) < 0)
+				return -1;
+			break;
+
+		/* function declaration */
+		case 0xDB:
+
+			if ((s = bytecodeOldStr(o, 0x9F)) == NULL || (s2 = bytecodeOldStr(o, 0x9F)) == NULL || (k = bytecodeOldByte(o)) < 0 || bytecodeOldInt(o, 1, &n) < 0)
+				return -1;
+
+			bytecodeWriteIdt(bc, s);
+			bytecodeWriteIdt(bc, s2);
+			bytecodeAdd(bc, k);
+			bytecodeWriteVarint(bc, n);
+
+			/* arguments */
+			for (int i = 0; i < n; i++) {
+
+				if ((s = bytecodeOldStr(o, 0x9F)) == NULL || (s2 = bytecodeOldStr(o, 0x9F)) == NULL || (k = bytecodeOldByte(o)) < 0)
+					return -1;
+
+				bytecodeWriteIdt(bc, s);
+				bytecodeWriteIdt(bc, s2);
+				bytecodeAdd(bc, k);
+			}
+			break;
+
+		/* extern, const, unsigned, return and else */
+		case 0xC1: case 0xDE: case 0xDF: case 0xC0: case 0xC4:
+
+			if (bytecodeOldNode(bc, o) < 0)
+				return -1;
+			break;
+
+		/* struct */
+		case 0xC2:
+
+			if ((s = bytecodeOldStr(o, 0x9F)) == NULL || bytecodeOldInt(o, 1, &n) < 0)
+				return -1;
+
+			bytecodeWriteIdt(bc, s);
+			bytecodeWriteVarint(bc, n);
+
+			for (int i = 0; i < n; i++) {
+
+				if (bytecodeOldNode(bc, o) < 0)
+					return -1;
+			}
+			break;
+
+		/* typedef */
+		case 0xC3:
+
+			if ((n = bytecodeOldByte(o)) < 0 || (s = bytecodeOldStr(o, 0x9F)) == NULL || (s2 = bytecodeOldStr(o, 0x9F)) == NULL)
+				return -1;
+
+			bytecodeAdd(bc, n);
+			bytecodeWriteIdt(bc, s);
+			bytecodeWriteIdt(bc, s2);
+			break;
+
+		default:
+			return -1;
+	}
+
+	/* position */
+	int lineno, colno;
+
+	if (bytecodeOldByte(o) != 0xFE || bytecodeOldInt(o, 0, &lineno) < 0 || bytecodeOldInt(o, 0, &colno) < 0)
+		return -1;
+
+	bc->lines[l * 3 + 1] = lineno;
+	bc->lines[l * 3 + 2] = colno;
+
+	return 0;
+}
+
+/* convert a file written before the header had a version to tree bytecode of the current version (NULL if it is invalid) */
+extern bytecode *bytecodeUpgrade(unsigned char *b, unsigned int len) {
+
+	bytecodeOld o = {b, len, 8, NULL, 0};
+	char **libs = NULL; /* library names (with their extension) */
+	unsigned int n_libs = 0;
+	int err = (len < 8);
+
+	bytecode *bc = bytecodeNew(NULL, (!err && b[2] == 'l')? BYTECODE_CLIB: BYTECODE_CMP);
+	bc->is_tree = 1;
+	bc->is_idat = !err && (b[7] & 1);
+
+	/* idata table (after 0xFD, each entry is an index and the position of a string) */
+	if (bc->is_idat) {
+
+		unsigned char *t = (unsigned char *)memchr(&b[8], 0xFD, len - 8);
+
+		for (unsigned int i = (t == NULL)? len: t - b + 1; i + 6 <= len && b[i + 1] == 0x9B; i += 6) {
+
+			unsigned int loc = (b[i+2]<<24) | (b[i+3]<<16) | (b[i+4]<<8) | (b[i+5]);
+
+			if (loc + 1 >= len || memchr(&b[loc + 1], 0, len - loc - 1) == NULL)
+				break;
+
+			o.idata = (char **)realloc(o.idata, sizeof(char *) * (o.n_idata + 1));
+			o.idata[o.n_idata++] = (char *)&b[loc + 1];
+		}
+	}
+
+	bytecodeWriteHeader(bc);
+
+	unsigned int pos = bc->len;
+
+	/* code ends at the idata table or EOF byte */
+	while (!err && o.p < len && b[o.p] != 0x00 && b[o.p] != 0xFD) {
+
+		char *s;
+
+		/* file name */
+		if (b[o.p] == 0xFF) {
+
+			o.p++;
+
+			if ((s = bytecodeOldStr(&o, 0x9F)) == NULL) err = 1;
+			else bytecodeWriteFileInf(bc, s);
+		}
+
+		/* library (loaded before the code runs) */
+		else if (b[o.p] == 0xE0) {
+
+			o.p++;
+
+			if ((s = bytecodeOldStr(&o, 0)) == NULL) err = 1;
+			else {
+
+				libs = (char **)realloc(libs, sizeof(char *) * (n_libs + 1));
+				libs[n_libs++] = s;
+			}
+		}
+
+		else err = (bytecodeOldNode(bc, &o) < 0);
+	}
+
+	if (!err) {
+
+		bytecodeSetSection(bc, BYTECODE_SECT_CODE, pos, bc->len - pos);
+
+		/* constant pool */
+		pos = bc->len;
+		bytecodeWritePool(bc);
+		bytecodeSetSection(bc, BYTECODE_SECT_POOL, pos, bc->len - pos);
+
+		/* line table */
+		pos = bc->len;
+		bytecodeWriteLines(bc);
+		bytecodeSetSection(bc, BYTECODE_SECT_LINES, pos, bc->len - pos);
+
+		/* libraries */
+		pos = bc->len;
+
+		for (unsigned int i = 0; i < n_libs; i++) {
+
+			for (char *s = libs[i]; *s; s++)
+				bytecodeAdd(bc, (unsigned char)*s);
+
+			bytecodeAdd(bc, 0);
+		}
+
+		bytecodeSetSection(bc, BYTECODE_SECT_LIBS, pos, bc->len - pos);
+	}
+
+	free(o.idata);
+	free(libs);
+
+	if (err) {
+
+		bytecodeFree(bc);
+		return NULL;
+	}
+
+	return bc;
+}
+
 /* finish with bytecode */
 extern void bytecodeFinish(bytecode *bc) {
 
 	/* all we really have to do in this situation is check if we are in a mode which requires us to write to a file, which in this case, we will */
-	if (bc->mode == BYTECODE_CLIB || bc->mode == BYTECODE_CMP) {
+	if (bc->mode == BYTECODE_CLIB || bc->mode == BYTECODE_CMP || bc->mode == BYTECODE_CC) {
 
 		/* get final file extension */
-		char *ext = (bc->mode == BYTECODE_CLIB)? "ml": "mc";
+		char *ext = (bc->mode == BYTECODE_CLIB)? "ml": (bc->mode == BYTECODE_CC)? "c": "mc";
 
 		/* get position of last dot */
 		int dotcnt = 0; /* number of dots counted */
@@ -1042,14 +1619,27 @@ extern void bytecodeFinish(bytecode *bc) {
 
 		printf("compiling to '%s'...\n", mb);
 
-		/* open file */
-		FILE *fp = fopen(mb, "wb");
+		/* c file and executable */
+		if (bc->mode == BYTECODE_CC)
+			aotWrite(bc, mb);
 
-		/* write to file */
-		fwrite(bc->bytes, 1, bc->len, fp);
+		else {
 
-		/* close file */
-		fclose(fp);
+			/* linear bytecode is written with packed operands (expanded again by vmNewFromFile) */
+			bytecode *out = bc->is_tree? bc: compilerPack(bc);
+
+			/* open file */
+			FILE *fp = fopen(mb, "wb");
+
+			/* write to file */
+			fwrite(out->bytes, 1, out->len, fp);
+
+			/* close file */
+			fclose(fp);
+
+			if (out != bc)
+				bytecodeFree(out);
+		}
 
 		/* free buffer and print highly important message */
 		free(mb);
@@ -1137,10 +1727,12 @@ extern void bytecodeFree(bytecode *bc) {
 	/* free */
 	free(bc->bytes);
 
-	/* free idata */
-	for (unsigned int i = 0; i < bc->i_len; i++)
-		free(bc->idata[i]);
+	/* free constant pool */
+	for (unsigned int i = 0; i < bc->p_len; i++)
+		free(bc->pool[i].s);
 
-	free(bc->idata);
+	free(bc->pool);
+	free(bc->p_index);
+	free(bc->lines);
 	free(bc);
 }
\ No newline at end of file
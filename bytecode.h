@@ -32,17 +32,50 @@
 #define BYTECODE_CLIB	2 /* compile to bytecode library */
 #define BYTECODE_LIB	3 /* bytecode library */
 #define BYTECODE_BC		4 /* run from file */
+#define BYTECODE_CC		5 /* compile to c and build an executable */
 
-/* eof byte */
-#define BYTECODE_EOF	0x00
+/* header flags */
+#define BYTECODE_FLAG_IDATA		0x01 /* strings and integers are stored in the constant pool (tree bytecode, names always are) */
+#define BYTECODE_FLAG_LINEAR	0x02 /* linear bytecode (see opcode.h) */
+#define BYTECODE_FLAG_PACKED	0x04 /* operands, line table and function table of linear bytecode are varints (files only, see compilerPack) */
+
+/* version of the file format (byte 4 of the header), files of other versions are not loaded (except version 2, whose linear bytecode isn't packed) */
+#define BYTECODE_VERSION	3
+
+/*
+ * the header is followed by a section directory: the number of sections
+ * and the offset and size in bytes of each section. sections that a file
+ * doesn't use have a size of 0
+ */
+#define BYTECODE_SECT_CODE	0 /* code */
+#define BYTECODE_SECT_POOL	1 /* constant pool of tree bytecode, string table of linear bytecode */
+#define BYTECODE_SECT_LINES	2 /* line table (fixed size entries in linear bytecode, delta compressed in files and in tree bytecode) */
+#define BYTECODE_SECT_FUNCS	3 /* function table: start and end of each function body in the code (linear bytecode) */
+#define BYTECODE_SECT_LIBS	4 /* names of libraries to load before the code runs */
+#define BYTECODE_SECT_COUNT	5
+
+/* size of the header with the section directory */
+#define BYTECODE_HEADER_SIZE	(12 + BYTECODE_SECT_COUNT * 8)
+
+/* constant pool entry */
+typedef struct {
+	unsigned char type; /* signature byte of the constant (0x9E = string, 0x9B = integer, 0x9F = identifier) */
+	char *s; /* string or identifier */
+	int val; /* integer */
+} bytecodeConst;
 
 /* bytecode struct */
 typedef struct {
 	unsigned char *bytes; /* actual bytes */
-	char **idata; /* for independant data mode */
+	bytecodeConst *pool; /* constant pool of tree bytecode */
 	unsigned int is_idat; /* is in independant data mode */
-	unsigned int i_len; /* idata length */
-	unsigned int i_cap; /* idata cap */
+	unsigned int is_tree; /* write tree bytecode instead of linear bytecode */
+	unsigned int p_len; /* number of constants in pool */
+	unsigned int p_cap; /* capacity of pool */
+	unsigned int *p_index; /* open addressing hash index of pool (entry index + 1, 0 if empty), twice the capacity of the pool */
+	unsigned int *lines; /* line table of tree bytecode (offset, line and column of each node) */
+	unsigned int l_len; /* number of line table entries */
+	unsigned int l_cap; /* capacity of line table */
 	unsigned int len; /* number of bytes stored */
 	unsigned int cap; /* capacity of byte array */
 	unsigned int mode; /* mode of bytecode */
@@ -59,17 +92,23 @@ extern unsigned int bytecodeGetc(unsigned char);
 extern bytecode *bytecodeNew(node *, unsigned int); /* create new bytecode object */
 
 extern void bytecodeAdd(bytecode *, unsigned char); /* add byte to byte array */
-extern void bytecodeAddIdat(bytecode *, char *); /* idata (independant data) mode only */
+extern unsigned int bytecodeAddConst(bytecode *, unsigned char, char *, int); /* add a constant to the pool and get its index */
+extern void bytecodeAddLine(bytecode *, unsigned int, unsigned int); /* add the position of the node that starts at the end of the code to the line table */
 extern void bytecodeComp(bytecode *); /* compile node */
 extern void bytecodeWrite(bytecode *, node *); /* write node */
 extern void bytecodeWriteHeader(bytecode *); /* write bytecode file header */
-extern void bytecodeWriteErrInf(bytecode *, unsigned int, unsigned int); /* write error info */
+extern void bytecodeWriteLibs(bytecode *); /* write the library section */
+extern void bytecodeSetSection(bytecode *, unsigned int, unsigned int, unsigned int); /* set the offset and size of a section in the header */
+extern int bytecodeGetSection(unsigned char *, unsigned int, unsigned int, unsigned int *, unsigned int *); /* get the offset and size of a section of a file (-1 if it is out of bounds) */
 extern void bytecodeWriteFileInf(bytecode *, char *); /* write a file name to change current file attribute */
-extern void bytecodeWriteInt(bytecode *, int); /* write integer */
+extern void bytecodeWriteInt(bytecode *, int); /* write integer (0x9B and a zigzag encoded varint) */
+extern void bytecodeWriteIntConst(bytecode *, int); /* write an integer value (a reference to the constant pool in idata mode) */
+extern void bytecodeWriteVarint(bytecode *, unsigned int); /* write an unsigned integer in as few bytes as it needs (LEB128) */
+extern unsigned int bytecodeGetVarint(unsigned char *, unsigned int *); /* read an unsigned integer written by bytecodeWriteVarint */
+extern int bytecodeGetInt(unsigned char *, unsigned int *); /* read the value of an integer written by bytecodeWriteInt (after its signature byte) */
 extern void bytecodeWriteIntNS(bytecode *, int); /* write integer without signature byte in beginning */
 extern void bytecodeWriteStr(bytecode *, char *); /* write string */
-extern void bytecodeWriteStrI(bytecode *, char *); /* write string and ignore idata mode */
-extern void bytecodeWriteIdt(bytecode *, char *); /* same as bytecodeWriteStr, uses different signature byte */
+extern void bytecodeWriteIdt(bytecode *, char *); /* write a reference to an identifier in the constant pool */
 extern void bytecodeWriteCall(bytecode *, node *); /* write a function call */
 extern void bytecodeWriteVarAcc(bytecode *, node *); /* write a variable access node */
 extern void bytecodeWriteVarAsg(bytecode *, node *); /* write a variable assign node */
@@ -93,6 +132,8 @@ extern void bytecodeWriteTypeDef(bytecode *, node *); /* type definition */
 extern void bytecodeWriteElse(bytecode *, node *); /* else */
 extern void bytecodeWriteInclude(bytecode *, node *, char *); /* include a file */
 extern void bytecodeInsertInt(bytecode *, unsigned int, int); /* insert an integer at location */
+extern void bytecodeInsertVarint(bytecode *, unsigned int, unsigned int); /* insert an unsigned integer (LEB128) at location, moving the bytes after it */
+extern bytecode *bytecodeUpgrade(unsigned char *, unsigned int); /* convert a file written before the header had a version to tree bytecode (NULL if it is invalid) */
 extern void bytecodeFinish(bytecode *); /* finish bytecode */
 
 extern void bytecodePrintf(bytecode *); /* print bytecode data in hexdump style */
@@ -0,0 +1,904 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+/* static type checker */
+#include "check.h" /* header */
+#include "names.h" /* namesIntern */
+#include "obhead.h" /* object types */
+#include "bytecode.h" /* lib_fnames */
+#include "error.h" /* errors */
+#include <stdlib.h> /* malloc, realloc, free */
+#include <string.h> /* strcmp */
+#include <stdio.h> /* fopen, fread, fclose */
+#include <limits.h> /* INT_MIN */
+
+/* maximum depth of included files and typedefs (deeper ones aren't checked) */
+#define CHECK_MAX_DEPTH 16
+
+/* names and types of the whole program */
+static checkTable assigned = {NULL, 0, 0, NULL}; /* names that are assigned a value somewhere */
+static checkTable externs = {NULL, 0, 0, NULL}; /* names declared in extern blocks */
+static checkTable types = {NULL, 0, 0, NULL}; /* struct and typedef names */
+static checkTable decls = {NULL, 0, 0, NULL}; /* number of declarations of each name, including arguments */
+static checkTable mutated = {NULL, 0, 0, NULL}; /* names that are incremented, decremented or pointed to */
+static checkTable consts = {NULL, 0, 0, NULL}; /* constants folded so far */
+static int is_foreign = 0; /* code of other files (libraries or files run before) shares the global names and types */
+static unsigned int n_of_files = 0; /* number of files checked */
+
+int opt_level = 0; /* optimization level (-O) */
+
+/* included files */
+static checkIncluded *incs = NULL;
+static unsigned int n_of_incs = 0;
+static unsigned int cap_incs = 0;
+
+/* check the types of a tree */
+extern void checkTree(node *n) {
+
+	if (n == NULL)
+		return;
+
+	/* types and global names of other files can't be known */
+	is_foreign = (lib_fnames != NULL && lib_fnames_len > 0) || (n_of_files++ > 0);
+
+	/* included files that can't be parsed are reported by the compiler, so nothing is checked */
+	if (checkExpand(n, 0) == 0) {
+
+		checkCollect(n, 0);
+
+		/* top level scope */
+		checkScope s = {{NULL, 0, 0, NULL}, CHECK_UNKNOWN, 1, 1};
+
+		checkBody(&s, n, 0, n->n_of_children);
+		checkFree(&s.t);
+	}
+
+	/* free tables */
+	checkFree(&assigned);
+	checkFree(&externs);
+	checkFree(&types);
+	checkFree(&decls);
+	checkFree(&mutated);
+	checkFree(&consts);
+	assigned = externs = types = decls = mutated = consts = (checkTable){NULL, 0, 0, NULL};
+
+	/* free included files */
+	for (unsigned int i = 0; i < n_of_incs; i++) {
+
+		node *pn = incs[i].p->pn;
+		parserFree(incs[i].p);
+		lexerFree(incs[i].l);
+		nodeFree(pn);
+	}
+
+	free(incs);
+
+	incs = NULL;
+	n_of_incs = 0;
+	cap_incs = 0;
+}
+
+/* position in the hash index of a table where a name is or would be added */
+static unsigned int checkSlot(checkTable *t, char *atom) {
+
+	unsigned int mask = t->cap_names * 2 - 1;
+	unsigned int i = NAMES_HASH(atom) & mask;
+
+	while (t->index[i] && t->names[t->index[i] - 1].name != atom)
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+/* find a name in a table */
+extern checkName *checkFind(checkTable *t, char *name) {
+
+	if (t->n_of_names == 0)
+		return NULL;
+
+	unsigned int i = t->index[checkSlot(t, namesIntern(name))];
+
+	return i? &t->names[i - 1]: NULL;
+}
+
+/* find a name in a table or add it */
+extern checkName *checkAdd(checkTable *t, char *name) {
+
+	checkName *e = checkFind(t, name);
+
+	if (e != NULL)
+		return e;
+
+	/* resize list (and rebuild index) */
+	if (t->n_of_names >= t->cap_names) {
+
+		t->cap_names = t->cap_names? t->cap_names * 2: 8;
+		t->names = (checkName *)realloc(t->names, sizeof(checkName) * t->cap_names);
+
+		free(t->index);
+		t->index = (unsigned int *)calloc(t->cap_names * 2, sizeof(unsigned int));
+
+		for (unsigned int i = 0; i < t->n_of_names; i++)
+			t->index[checkSlot(t, t->names[i].name)] = i + 1;
+	}
+
+	e = &t->names[t->n_of_names];
+
+	e->name = namesIntern(name);
+	t->index[checkSlot(t, e->name)] = ++t->n_of_names;
+	e->decl = NULL;
+	e->n_decls = 0;
+	e->known = 1;
+	e->type = CHECK_UNKNOWN;
+	e->a_type = CHECK_UNKNOWN;
+	e->val = 0;
+
+	return e;
+}
+
+/* free the lists of a table */
+extern void checkFree(checkTable *t) {
+
+	free(t->names);
+	free(t->index);
+}
+
+/* get the parsed tree of an included file */
+extern node *checkInclude(node *n) {
+
+	/* already parsed */
+	for (unsigned int i = 0; i < n_of_incs; i++) {
+
+		if (incs[i].n == n)
+			return incs[i].p->pn;
+	}
+
+	/* read file */
+	char *fname = n->tokens[0]->t_value;
+	FILE *f = fopen(fname, "r");
+
+	if (f == NULL)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	int flen = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	char *text = (char *)malloc(flen + 1);
+	fread(text, 1, flen, f);
+	text[flen] = 0;
+
+	fclose(f);
+
+	/* lex and parse it (errors are left to the compiler) */
+	lexer *l = lexerNew(text, fname);
+
+	lexerLex(l);
+	free(text);
+
+	if (errorIsSet()) {
+
+		errorClear();
+		lexerFree(l);
+		return NULL;
+	}
+
+	parser *p = parserNew(l->tokens, l->n_of_tokens);
+
+	parserParse(p);
+
+	if (errorIsSet()) {
+
+		errorClear();
+		parserFree(p);
+		lexerFree(l);
+		return NULL;
+	}
+
+	/* add to list */
+	if (n_of_incs >= cap_incs) {
+
+		cap_incs = cap_incs? cap_incs * 2: 8;
+		incs = (checkIncluded *)realloc(incs, sizeof(checkIncluded) * cap_incs);
+	}
+
+	incs[n_of_incs++] = (checkIncluded){n, l, p};
+	return p->pn;
+}
+
+/* parse every included file of a tree */
+extern int checkExpand(node *n, unsigned int depth) {
+
+	if (n == NULL)
+		return 0;
+
+	if (n->type == NODE_INCLUDE) {
+
+		/* files that include themselves never finish compiling */
+		if (depth >= CHECK_MAX_DEPTH)
+			return -1;
+
+		node *pn = checkInclude(n);
+
+		if (pn == NULL)
+			return -1;
+
+		return checkExpand(pn, depth + 1);
+	}
+
+	for (unsigned int i = 0; i < n->n_of_children; i++) {
+
+		if (checkExpand(n->children[i], depth) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* collect names and types of the whole program */
+extern void checkCollect(node *n, int in_extern) {
+
+	if (n == NULL)
+		return;
+
+	checkName *e;
+
+	switch (n->type) {
+
+		/* assigning a function can change its arguments */
+		case NODE_VARASSIGN:
+
+			if (n->n_of_tokens == 1)
+				checkAdd(&assigned, n->tokens[0]->t_value);
+			break;
+
+		/* names declared in extern blocks change global names */
+		case NODE_VARNEW:
+		case NODE_VARUN:
+		case NODE_FUNCDEC:
+
+			if (in_extern)
+				checkAdd(&externs, n->tokens[1]->t_value);
+
+			checkAdd(&decls, n->tokens[1]->t_value)->n_decls++;
+
+			/* arguments */
+			if (n->type == NODE_FUNCDEC) {
+
+				for (unsigned int i = 3; i < n->n_of_tokens; i += 2)
+					checkAdd(&decls, n->tokens[i]->t_value)->n_decls++;
+			}
+			break;
+
+		case NODE_INC:
+		case NODE_DEC:
+
+			if (n->n_of_tokens == 1)
+				checkAdd(&mutated, n->tokens[0]->t_value);
+			break;
+
+		case NODE_UNOP:
+
+			if (n->tokens[0]->t_type != TOKEN_MINUS && n->children[0]->type == NODE_VARACCESS && n->children[0]->n_of_tokens == 1)
+				checkAdd(&mutated, n->children[0]->tokens[0]->t_value);
+			break;
+
+		case NODE_EXTERN:
+
+			in_extern = 1;
+			break;
+
+		/* types */
+		case NODE_STRUCT:
+		case NODE_TYPEDEF:
+
+			e = checkAdd(&types, n->tokens[(n->type == NODE_STRUCT)? 0: 1]->t_value);
+
+			if (!e->n_decls++)
+				e->decl = n;
+
+			checkAdd(&decls, e->name)->n_decls++;
+
+			if (in_extern && n->type == NODE_STRUCT)
+				checkAdd(&externs, n->tokens[0]->t_value);
+			break;
+
+		case NODE_INCLUDE:
+
+			checkCollect(checkInclude(n), in_extern);
+			return;
+	}
+
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		checkCollect(n->children[i], in_extern);
+}
+
+/* declare a name in a scope */
+static void checkDeclareName(checkScope *s, char *name, int top) {
+
+	checkName *e = checkAdd(&s->t, name);
+
+	/* declarations in blocks and loops might not run */
+	if (!top)
+		e->known = 0;
+
+	e->n_decls++;
+}
+
+/* count the declarations of a scope */
+extern void checkDeclare(checkScope *s, node *n, int top) {
+
+	if (n == NULL)
+		return;
+
+	switch (n->type) {
+
+		case NODE_VARNEW:
+		case NODE_VARUN:
+		case NODE_FUNCDEC:
+
+			checkDeclareName(s, n->tokens[1]->t_value, top);
+			return;
+
+		/* function and struct bodies have their own scopes */
+		case NODE_FUNCDEF:
+
+			checkDeclare(s, n->children[0], top);
+			return;
+
+		case NODE_STRUCT:
+
+			checkDeclareName(s, n->tokens[0]->t_value, top);
+			return;
+
+		/* extern blocks declare global names */
+		case NODE_EXTERN:
+			return;
+
+		case NODE_INCLUDE:
+
+			checkDeclare(s, checkInclude(n), top);
+			return;
+
+		/* statements of the same level */
+		case NODE_STATEMENTS:
+		case NODE_CONST:
+		case NODE_UNSIGNED:
+			break;
+
+		/* start of a for loop always runs */
+		case NODE_FORNODE:
+
+			checkDeclare(s, n->children[0], top);
+
+			for (unsigned int i = 1; i < n->n_of_children; i++)
+				checkDeclare(s, n->children[i], 0);
+			return;
+
+		/* nested statements */
+		default:
+
+			top = 0;
+			break;
+	}
+
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		checkDeclare(s, n->children[i], top);
+}
+
+/* get the type of a type name */
+extern unsigned char checkTypeName(char *tp_name, int depth) {
+
+	/* builtin types */
+	if (!strcmp(tp_name, "int")) return OBJECT_INT;
+	if (!strcmp(tp_name, "chr")) return OBJECT_CHR;
+	if (!strcmp(tp_name, "function")) return OBJECT_FUNC;
+
+	if (is_foreign || depth >= CHECK_MAX_DEPTH)
+		return CHECK_UNKNOWN;
+
+	/* only types defined once are known */
+	checkName *e = checkFind(&types, tp_name);
+
+	if (e == NULL || e->n_decls != 1)
+		return CHECK_UNKNOWN;
+
+	if (e->decl->type == NODE_STRUCT)
+		return OBJECT_STRUCT;
+
+	/* typedef */
+	unsigned char tp = checkTypeName(e->decl->tokens[0]->t_value, depth + 1);
+
+	if (tp == CHECK_UNKNOWN)
+		return CHECK_UNKNOWN;
+
+	return tp | (e->decl->values[0]? OBJECT_POINTER: 0);
+}
+
+/* get a name with a known declaration at this point */
+static checkName *checkKnown(checkScope *s, node *n) {
+
+	if (n->n_of_tokens != 1)
+		return NULL;
+
+	checkName *e = checkFind(&s->t, n->tokens[0]->t_value);
+
+	if (e == NULL || !e->known || e->decl == NULL)
+		return NULL;
+
+	return e;
+}
+
+/* set the type of a declared name */
+static void checkSet(checkScope *s, node *n, char *name, unsigned char tp, unsigned char a_type) {
+
+	checkName *e = checkFind(&s->t, name);
+
+	if (e == NULL || !e->known)
+		return;
+
+	e->decl = n;
+	e->type = tp;
+	e->a_type = a_type;
+}
+
+/* get the type of a name */
+extern unsigned char checkNameType(checkScope *s, char *name) {
+
+	checkName *e = checkFind(&s->t, name);
+
+	if (e == NULL || !e->known || e->decl == NULL)
+		return CHECK_UNKNOWN;
+
+	return e->type;
+}
+
+/* check a node and return the type of its value */
+extern unsigned char checkNode(checkScope *s, node *n) {
+
+	if (n == NULL || errorIsSet())
+		return CHECK_UNKNOWN;
+
+	unsigned char a, b, tp;
+	checkName *e;
+
+	switch (n->type) {
+
+		case NODE_INT:
+			return OBJECT_INT;
+
+		/* pointer to an array of chr */
+		case NODE_STRING:
+			return OBJECT_CHR | OBJECT_POINTER;
+
+		case NODE_VARACCESS:
+
+			if (n->n_of_tokens != 1)
+				return CHECK_UNKNOWN;
+
+			/* folded constant that has been declared at this point (in this scope, or globally if the scope doesn't declare it) */
+			if ((e = checkFind(&consts, n->tokens[0]->t_value)) != NULL) {
+
+				checkName *d = checkFind(&s->t, e->name);
+
+				if ((d != NULL && d->decl == e->decl) || (d == NULL && e->known)) {
+
+					n->is_const = 1;
+					n->const_val = e->val;
+					return OBJECT_INT;
+				}
+			}
+
+			return checkNameType(s, n->tokens[0]->t_value);
+
+		/* old value of an int or chr */
+		case NODE_INC:
+		case NODE_DEC:
+
+			a = (n->n_of_tokens == 1)? checkNameType(s, n->tokens[0]->t_value): CHECK_UNKNOWN;
+			return (a == OBJECT_INT || a == OBJECT_CHR)? a: CHECK_UNKNOWN;
+
+		case NODE_UNOP:
+
+			a = checkNode(s, n->children[0]);
+
+			if (a == CHECK_UNKNOWN)
+				return CHECK_UNKNOWN;
+
+			switch (n->tokens[0]->t_type) {
+
+				case TOKEN_MINUS:
+
+					if (a != OBJECT_INT && a != OBJECT_CHR)
+						return CHECK_UNKNOWN;
+
+					n->checked = 1;
+
+					/* fold negative constant */
+					if (opt_level >= 1 && (n->children[0]->is_const || n->children[0]->type == NODE_INT))
+						n->is_const = checkFoldOp(TOKEN_MINUS, 0, CHECK_INT(n->children[0]), &n->const_val) == 0;
+
+					return OBJECT_INT;
+
+				case TOKEN_INC:
+				case TOKEN_DEC: return (a == OBJECT_INT || a == OBJECT_CHR)? a: CHECK_UNKNOWN;
+				case TOKEN_AMP: return a | OBJECT_POINTER;
+			}
+
+			return CHECK_UNKNOWN;
+
+		/* operations on int and chr give an int (int op chr is not allowed) */
+		case NODE_BINOP:
+
+			a = checkNode(s, n->children[0]);
+			b = checkNode(s, n->children[1]);
+
+			if (!((a == OBJECT_INT || a == OBJECT_CHR) && (b == OBJECT_INT || (b == OBJECT_CHR && a == OBJECT_CHR))))
+				return CHECK_UNKNOWN;
+
+			switch (n->tokens[0]->t_type) {
+
+				case TOKEN_PLUS:
+				case TOKEN_MINUS:
+				case TOKEN_MUL:
+				case TOKEN_DIV:
+				case TOKEN_MOD:
+				case TOKEN_EE:
+				case TOKEN_NE:
+				case TOKEN_LT:
+				case TOKEN_GT:
+
+					n->checked = 1;
+
+					/* fold operations on constants */
+					if (opt_level >= 1 && (n->children[0]->is_const || n->children[0]->type == NODE_INT) &&
+						(n->children[1]->is_const || n->children[1]->type == NODE_INT)) {
+
+						n->is_const = checkFoldOp(n->tokens[0]->t_type, CHECK_INT(n->children[0]), CHECK_INT(n->children[1]), &n->const_val) == 0;
+					}
+					return OBJECT_INT;
+			}
+
+			return CHECK_UNKNOWN;
+
+		/* items of arrays declared with a size */
+		case NODE_GETITEM:
+
+			checkNode(s, n->children[0]);
+
+			e = checkKnown(s, n);
+			return (e != NULL)? e->a_type: CHECK_UNKNOWN;
+
+		case NODE_SETITEM:
+
+			checkNode(s, n->children[0]);
+			a = checkNode(s, n->children[1]);
+
+			e = checkKnown(s, n);
+
+			if (e != NULL && e->a_type != CHECK_UNKNOWN && a != CHECK_UNKNOWN) {
+
+				if (a != e->a_type) checkError(n, "Mismatched types");
+				else n->checked = 1;
+			}
+
+			return a;
+
+		/* variable keeps the type of its value */
+		case NODE_VARNEW:
+
+			if (n->values[0])
+				checkNode(s, n->children[0]);
+
+			a = checkNode(s, n->children[n->values[0]]);
+			tp = checkTypeName(n->tokens[0]->t_value, 0);
+
+			if (a != CHECK_UNKNOWN && tp != CHECK_UNKNOWN) {
+
+				/* errors are reported at the value */
+				if ((a & 0x3) != (tp & 0x3)) {
+
+					checkError(n->children[n->values[0]], "Mismatched types");
+					return CHECK_UNKNOWN;
+				}
+
+				n->checked = 1;
+			}
+
+			checkSet(s, n, n->tokens[1]->t_value, a, CHECK_UNKNOWN);
+			return a;
+
+		case NODE_VARUN:
+
+			if (n->values[0])
+				checkNode(s, n->children[0]);
+
+			tp = checkTypeName(n->tokens[0]->t_value, 0);
+			a = CHECK_UNKNOWN;
+			b = CHECK_UNKNOWN;
+
+			if (tp != CHECK_UNKNOWN) {
+
+				/* arrays and pointers */
+				if (n->values[0] || n->values[1] || (tp & OBJECT_POINTER)) {
+
+					a = (tp & 0x3) | OBJECT_POINTER;
+
+					if (n->values[0] && ((tp & 0x3) == OBJECT_INT || (tp & 0x3) == OBJECT_CHR))
+						b = tp & 0x3;
+				}
+
+				/* structs, ints and chrs */
+				else if (tp != OBJECT_FUNC) a = tp;
+			}
+
+			checkSet(s, n, n->tokens[1]->t_value, a, b);
+			return a;
+
+		/* assigning doesn't change the type of a name */
+		case NODE_VARASSIGN:
+
+			a = checkNode(s, n->children[0]);
+			e = checkKnown(s, n);
+
+			if (e != NULL && e->type != CHECK_UNKNOWN && a != CHECK_UNKNOWN && a != e->type)
+				checkError(n, "Mismatched types");
+
+			return a;
+
+		case NODE_CALL: {
+
+			unsigned char *arg_types = (unsigned char *)malloc(n->n_of_children);
+
+			for (unsigned int i = 0; i < n->n_of_children; i++)
+				arg_types[i] = checkNode(s, n->children[i]);
+
+			tp = checkCall(s, n, arg_types);
+
+			free(arg_types);
+			return tp;
+		}
+
+		case NODE_FUNCDEC:
+
+			checkSet(s, n, n->tokens[1]->t_value, OBJECT_FUNC, CHECK_UNKNOWN);
+			return OBJECT_FUNC;
+
+		/* function body has the arguments as its first names */
+		case NODE_FUNCDEF: {
+
+			node *fd = n->children[0];
+			checkNode(s, fd);
+
+			tp = checkTypeName(fd->tokens[0]->t_value, 0);
+
+			checkScope fs = {{NULL, 0, 0, NULL}, (tp == CHECK_UNKNOWN)? tp: tp | (fd->values[0]? OBJECT_POINTER: 0), 0, 1};
+
+			for (unsigned int i = 2; i < fd->n_of_tokens; i += 2) {
+
+				e = checkAdd(&fs.t, fd->tokens[i+1]->t_value);
+
+				/* arguments with the same name */
+				if (e->n_decls++) {
+
+					e->known = 0;
+					continue;
+				}
+
+				tp = checkTypeName(fd->tokens[i]->t_value, 0);
+
+				e->decl = n;
+				e->type = (tp == CHECK_UNKNOWN)? tp: tp | (fd->values[((i - 2) / 2) + 1]? OBJECT_POINTER: 0);
+			}
+
+			checkBody(&fs, n, 1, n->n_of_children);
+			checkFree(&fs.t);
+
+			return OBJECT_FUNC;
+		}
+
+		case NODE_STRUCT: {
+
+			checkScope ss = {{NULL, 0, 0, NULL}, CHECK_UNKNOWN, 0, 0};
+
+			checkBody(&ss, n, 0, n->n_of_children);
+			checkFree(&ss.t);
+
+			return CHECK_UNKNOWN;
+		}
+
+		/* extern blocks run in the global scope of the function */
+		case NODE_EXTERN: {
+
+			checkScope es = {{NULL, 0, 0, NULL}, s->rt_type, 1, 0};
+
+			checkBody(&es, n, 0, 1);
+			checkFree(&es.t);
+
+			return CHECK_UNKNOWN;
+		}
+
+		case NODE_RETURN:
+
+			a = checkNode(s, n->children[0]);
+
+			if (a != CHECK_UNKNOWN && s->rt_type != CHECK_UNKNOWN) {
+
+				/* errors are reported at the value */
+				if (a != s->rt_type) checkError(n->children[0], "Mismatched types");
+				else n->checked = 1;
+			}
+
+			return CHECK_UNKNOWN;
+
+		case NODE_INCLUDE:
+
+			checkNode(s, checkInclude(n));
+			return CHECK_UNKNOWN;
+
+		case NODE_CONST:
+
+			tp = checkNode(s, n->children[0]);
+			checkConst(s, n->children[0]);
+			return tp;
+
+		/* unsigned only wraps its child */
+		case NODE_UNSIGNED:
+
+			return checkNode(s, n->children[0]);
+	}
+
+	/* blocks and loops */
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		checkNode(s, n->children[i]);
+
+	return CHECK_UNKNOWN;
+}
+
+/* check statements of a node in a scope */
+extern void checkBody(checkScope *s, node *n, unsigned int start, unsigned int end) {
+
+	for (unsigned int i = start; i < end; i++)
+		checkDeclare(s, n->children[i], 1);
+
+	/* global names can be changed by extern blocks and other files */
+	if (s->is_global) {
+
+		for (unsigned int i = 0; i < s->t.n_of_names; i++) {
+
+			if (is_foreign || checkFind(&externs, s->t.names[i].name) != NULL)
+				s->t.names[i].known = 0;
+		}
+	}
+
+	for (unsigned int i = start; i < end; i++)
+		checkNode(s, n->children[i]);
+}
+
+/* check a call to a function that keeps its declaration */
+extern unsigned char checkCall(checkScope *s, node *n, unsigned char *arg_types) {
+
+	node *fn = n->children[0];
+
+	if (fn->type != NODE_VARACCESS)
+		return CHECK_UNKNOWN;
+
+	checkName *e = checkKnown(s, fn);
+
+	if (e == NULL || e->decl->type != NODE_FUNCDEC || checkFind(&assigned, e->name) != NULL)
+		return CHECK_UNKNOWN;
+
+	node *fd = e->decl;
+
+	/* number of arguments */
+	if ((fd->n_of_tokens - 2) / 2 != n->n_of_children - 1) {
+
+		checkError(n, "Invalid number of arguments passed to function");
+		return CHECK_UNKNOWN;
+	}
+
+	/* types of arguments */
+	for (unsigned int i = 1; i < n->n_of_children; i++) {
+
+		unsigned char a = arg_types[i];
+		unsigned char tp = checkTypeName(fd->tokens[i * 2]->t_value, 0);
+
+		if (a == CHECK_UNKNOWN || tp == CHECK_UNKNOWN)
+			continue;
+
+		if (a != (tp | (fd->values[i]? OBJECT_POINTER: 0))) {
+
+			checkError(n, "Mismatched types");
+			return CHECK_UNKNOWN;
+		}
+	}
+
+	/* functions without a return statement return an int */
+	return (checkTypeName(fd->tokens[0]->t_value, 0) == OBJECT_INT && !fd->values[0])? OBJECT_INT: CHECK_UNKNOWN;
+}
+
+/* fold a constant declared in a scope */
+extern void checkConst(checkScope *s, node *n) {
+
+	if (opt_level < 1 || is_foreign || !s->can_fold || n->type != NODE_VARNEW || n->values[0] || errorIsSet())
+		return;
+
+	node *v = n->children[0];
+	char *name = n->tokens[1]->t_value;
+
+	if (!(v->is_const || v->type == NODE_INT) || checkTypeName(n->tokens[0]->t_value, 0) != OBJECT_INT)
+		return;
+
+	/* declared once as a statement that always runs, and never changed */
+	checkName *e = checkFind(&s->t, name);
+	checkName *d = checkFind(&decls, name);
+
+	if (e == NULL || !e->known || e->decl != n || d == NULL || d->n_decls != 1 ||
+		checkFind(&assigned, name) != NULL || checkFind(&mutated, name) != NULL || checkFind(&externs, name) != NULL)
+		return;
+
+	e = checkAdd(&consts, name);
+
+	e->decl = n;
+	e->known = s->is_global; /* globals are used by functions too */
+	e->val = CHECK_INT(v);
+}
+
+/* fold an operation on two ints */
+extern int checkFoldOp(int op, int x, int y, int *r) {
+
+	/* overflow wraps around like it does when the code runs */
+	unsigned int ux = (unsigned int)x, uy = (unsigned int)y;
+
+	switch (op) {
+
+		case TOKEN_PLUS: *r = (int)(ux + uy); return 0;
+		case TOKEN_MINUS: *r = (int)(ux - uy); return 0;
+		case TOKEN_MUL: *r = (int)(ux * uy); return 0;
+		case TOKEN_EE: *r = x == y; return 0;
+		case TOKEN_NE: *r = x != y; return 0;
+		case TOKEN_LT: *r = x < y; return 0;
+		case TOKEN_GT: *r = x > y; return 0;
+
+		/* errors are left to run time */
+		case TOKEN_DIV:
+		case TOKEN_MOD:
+
+			if (y == 0 || (x == INT_MIN && y == -1))
+				return -1;
+
+			*r = (op == TOKEN_DIV)? x / y: x % y;
+			return 0;
+	}
+
+	return -1;
+}
+
+/* set a type error */
+extern void checkError(node *n, char *msg) {
+
+	if (errorIsSet())
+		return;
+
+	errorSet(ERROR_TYPE_TYPE, ERROR_CODE_INVALIDTYPE, msg);
+	errorSetPos(n->lineno, n->colno, n->fname);
+}
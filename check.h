@@ -0,0 +1,89 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+/* check.h -- static type checker */
+#ifndef _CHECK_H
+#define _CHECK_H
+
+#include "node.h" /* parsed nodes */
+#include "lexer.h" /* lexer */
+#include "parser.h" /* parser */
+
+/* type that isn't known before the code runs */
+#define CHECK_UNKNOWN 0xFF
+
+/* value of an int literal or folded constant */
+#define CHECK_INT(n) ((n)->is_const? (n)->const_val: atoi((n)->tokens[0]->t_value))
+
+/* name declared in a scope */
+typedef struct {
+	char *name; /* interned name */
+	node *decl; /* declaration that has run last at this point of the scope (first declaration for types) */
+	unsigned int n_decls; /* number of declarations */
+	int known; /* every declaration is a statement that always runs in order, so the type of the name is known */
+	unsigned char type; /* type of value (CHECK_UNKNOWN if unknown) */
+	unsigned char a_type; /* type of items if the name is an array declared with a size (CHECK_UNKNOWN otherwise) */
+	int val; /* value of a name folded into a constant */
+} checkName;
+
+/* list of names */
+typedef struct {
+	checkName *names; /* names */
+	unsigned int n_of_names; /* number of names */
+	unsigned int cap_names; /* capacity of list */
+	unsigned int *index; /* open addressing hash index of names (entry index + 1, 0 if empty), twice the capacity of the list */
+} checkTable;
+
+/* scope that names are declared in */
+typedef struct {
+	checkTable t; /* names declared in scope */
+	unsigned char rt_type; /* return type of function (CHECK_UNKNOWN if unknown or not in a function) */
+	int is_global; /* names are in the global name table, where extern blocks and libraries can change them */
+	int can_fold; /* constants declared in the scope can be folded (not fields of structs or names of extern blocks) */
+} checkScope;
+
+/* file included by the program */
+typedef struct {
+	node *n; /* include node */
+	lexer *l; /* lexer of file */
+	parser *p; /* parser of file, holding its parsed tree */
+} checkIncluded;
+
+/* functions */
+extern void checkTree(node *n); /* check the types of a parsed tree before it is compiled, marking nodes that don't need checks at run time */
+extern checkName *checkFind(checkTable *t, char *name); /* find a name in a table (NULL if it isn't there) */
+extern checkName *checkAdd(checkTable *t, char *name); /* find a name in a table, adding it if it isn't there */
+extern void checkFree(checkTable *t); /* free the lists of a table */
+extern node *checkInclude(node *n); /* get the parsed tree of an included file (NULL if it can't be parsed) */
+extern int checkExpand(node *n, unsigned int depth); /* parse every included file of a tree, return -1 if one can't be parsed */
+extern void checkCollect(node *n, int in_extern); /* collect assigned names, names declared in extern blocks and user types of a tree */
+extern void checkDeclare(checkScope *s, node *n, int top); /* count the declarations of a scope */
+extern unsigned char checkTypeName(char *tp_name, int depth); /* get the type of a type name (CHECK_UNKNOWN if unknown) */
+extern unsigned char checkNameType(checkScope *s, char *name); /* get the type of a name at this point of a scope */
+extern unsigned char checkNode(checkScope *s, node *n); /* check a node and return the type of its value */
+extern void checkBody(checkScope *s, node *n, unsigned int start, unsigned int end); /* check statements start to end of a node, declaring their names in a scope */
+extern unsigned char checkCall(checkScope *s, node *n, unsigned char *arg_types); /* check a call to a function that keeps its declaration and return the type of its value */
+extern void checkConst(checkScope *s, node *n); /* fold a constant declared in a scope if its value never changes */
+extern int checkFoldOp(int op, int x, int y, int *r); /* fold an operation on two ints, return -1 if it can't be folded */
+extern void checkError(node *n, char *msg); /* set type error at the position of a node */
+
+#endif /* _CHECK_H */
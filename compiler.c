@@ -0,0 +1,1635 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* linear bytecode compiler */
+#include "compiler.h"
+#include "error.h" /* errors */
+#include "run.h" /* runlp */
+#include "names.h" /* namesIntern */
+#include "typedef.h" /* type ids */
+#include <stdlib.h> /* malloc, realloc, free */
+#include <string.h> /* strcmp, strlen, memcpy */
+#include <stdio.h> /* printf */
+#include <limits.h> /* INT_MIN */
+
+/* instruction names and operand formats for compilerPrint */
+static char *op_names[OP_COUNT] = {
+	[OP_END] = "END",
+	[OP_POP] = "POP",
+	[OP_DUP] = "DUP",
+	[OP_DUPX1] = "DUPX1",
+	[OP_PUSHINT] = "PUSHINT",
+	[OP_PUSHSTR] = "PUSHSTR",
+	[OP_LOADNAME] = "LOADNAME",
+	[OP_LOADFIELD] = "LOADFIELD",
+	[OP_STORENAME] = "STORENAME",
+	[OP_STOREFIELD] = "STOREFIELD",
+	[OP_GETITEM] = "GETITEM",
+	[OP_SETITEM] = "SETITEM",
+	[OP_POSTINC] = "POSTINC",
+	[OP_POSTDEC] = "POSTDEC",
+	[OP_UNOP] = "UNOP",
+	[OP_BINOP] = "BINOP",
+	[OP_DECLARE] = "DECLARE",
+	[OP_DECLUNDEF] = "DECLUNDEF",
+	[OP_JMP] = "JMP",
+	[OP_JMPF] = "JMPF",
+	[OP_LOOP] = "LOOP",
+	[OP_CALL] = "CALL",
+	[OP_RETURN] = "RETURN",
+	[OP_LEAVE] = "LEAVE",
+	[OP_FUNCDEC] = "FUNCDEC",
+	[OP_FUNCBODY] = "FUNCBODY",
+	[OP_EXTERN] = "EXTERN",
+	[OP_STRUCT] = "STRUCT",
+	[OP_TYPEDEF] = "TYPEDEF",
+	[OP_COLLECT] = "COLLECT",
+	[OP_LOADSLOT] = "LOADSLOT",
+	[OP_STORESLOT] = "STORESLOT",
+	[OP_TAILCALL] = "TAILCALL",
+	[OP_CRETURN] = "CRETURN",
+	[OP_CSETITEM] = "CSETITEM",
+	[OP_ADDINT] = "ADDINT",
+	[OP_SUBINT] = "SUBINT",
+	[OP_MULINT] = "MULINT",
+	[OP_DIVINT] = "DIVINT",
+	[OP_MODINT] = "MODINT",
+	[OP_EQINT] = "EQINT",
+	[OP_NEINT] = "NEINT",
+	[OP_LTINT] = "LTINT",
+	[OP_GTINT] = "GTINT",
+	[OP_NEGINT] = "NEGINT",
+	[OP_INCSLOT] = "INCSLOT",
+	[OP_DECSLOT] = "DECSLOT",
+	[OP_ADDIMM] = "ADDIMM",
+	[OP_CMPJMPF] = "CMPJMPF",
+	[OP_LOADSLOTF] = "LOADSLOTF",
+	[OP_LOADFIELDREF] = "LOADFIELDREF",
+};
+
+static char *op_formats[OP_COUNT] = {
+	[OP_PUSHINT] = "i",
+	[OP_PUSHSTR] = "s",
+	[OP_LOADNAME] = "s",
+	[OP_LOADFIELD] = "s",
+	[OP_STORENAME] = "s",
+	[OP_STOREFIELD] = "s",
+	[OP_UNOP] = "b",
+	[OP_BINOP] = "b",
+	[OP_DECLARE] = "tssbu",
+	[OP_DECLUNDEF] = "tssbu",
+	[OP_JMP] = "j",
+	[OP_JMPF] = "j",
+	[OP_CALL] = "i",
+	[OP_FUNCDEC] = "tssba",
+	[OP_FUNCBODY] = "j",
+	[OP_EXTERN] = "j",
+	[OP_STRUCT] = "sj",
+	[OP_TYPEDEF] = "btss",
+	[OP_LOADSLOT] = "us",
+	[OP_STORESLOT] = "us",
+	[OP_TAILCALL] = "i",
+	[OP_INCSLOT] = "us",
+	[OP_DECSLOT] = "us",
+	[OP_ADDIMM] = "i",
+	[OP_CMPJMPF] = "bususj",
+	[OP_LOADSLOTF] = "uss",
+	[OP_LOADFIELDREF] = "s",
+};
+
+/* instructions for operations on ints and chrs by operator token */
+static unsigned char int_ops[] = {
+	[TOKEN_PLUS] = OP_ADDINT,
+	[TOKEN_MINUS] = OP_SUBINT,
+	[TOKEN_MUL] = OP_MULINT,
+	[TOKEN_DIV] = OP_DIVINT,
+	[TOKEN_MOD] = OP_MODINT,
+	[TOKEN_EE] = OP_EQINT,
+	[TOKEN_NE] = OP_NEINT,
+	[TOKEN_LT] = OP_LTINT,
+	[TOKEN_GT] = OP_GTINT,
+};
+
+/* create a new compiler */
+extern compiler *compilerNew(bytecode *bc) {
+
+	/* malloc compiler */
+	compiler *c = (compiler *)malloc(sizeof(compiler));
+
+	if (c == NULL)
+		return NULL;
+
+	/* values */
+	c->bc = bc;
+	c->strs = (unsigned char *)malloc(64);
+	c->s_len = 0;
+	c->s_cap = 64;
+	c->s_index = NULL;
+	c->n_strs = 0;
+	c->cap_index = 0;
+	c->fname = NULL;
+	c->fname_off = 0;
+	c->lines = (unsigned char *)malloc(16 * 8);
+	c->n_lines = 0;
+	c->l_cap = 8;
+	c->code_start = 0;
+	c->depth = 0;
+	c->global = compilerScopeNew(0);
+	c->scope = c->global;
+
+	/* return */
+	return c;
+}
+
+/* compile root node */
+extern void compilerComp(compiler *c) {
+
+	bytecode *bc = c->bc;
+
+	/* set current and previous filenames */
+	bc->curr_fname = bc->n->fname;
+	bc->prev_fname = bc->n->fname;
+
+	/* write header */
+	bytecodeWriteHeader(bc);
+
+	c->code_start = bc->len;
+
+	/* compile */
+	compilerWrite(c, bc->n, 0);
+
+	if (errorIsSet())
+		return;
+
+	compilerWriteOp(c, bc->n, OP_END);
+	compilerPeephole(c);
+
+	/* code section */
+	unsigned int code_len = compilerPos(c);
+	bytecodeSetSection(bc, BYTECODE_SECT_CODE, c->code_start, code_len);
+
+	/* string table */
+	bytecodeSetSection(bc, BYTECODE_SECT_POOL, bc->len, c->s_len);
+
+	for (unsigned int i = 0; i < c->s_len; i++)
+		bytecodeAdd(bc, c->strs[i]);
+
+	/* line table */
+	bytecodeSetSection(bc, BYTECODE_SECT_LINES, bc->len, c->n_lines * 16);
+
+	for (unsigned int i = 0; i < c->n_lines * 16; i++)
+		bytecodeAdd(bc, c->lines[i]);
+
+	/* function table (bodies are found after the peephole pass has moved them) */
+	unsigned int pos = bc->len;
+
+	for (unsigned int pc = 0; pc < code_len; pc += compilerOpLen(&bc->bytes[c->code_start + pc])) {
+
+		unsigned char *p = &bc->bytes[c->code_start + pc];
+
+		if (*p == OP_FUNCBODY) {
+
+			unsigned int end = OP_GETUINT(p + 1);
+
+			bytecodeWriteIntNS(bc, pc + 5);
+			bytecodeWriteIntNS(bc, end);
+		}
+	}
+
+	bytecodeSetSection(bc, BYTECODE_SECT_FUNCS, pos, bc->len - pos);
+
+	/* libraries */
+	bytecodeWriteLibs(bc);
+}
+
+/* write node */
+extern void compilerWrite(compiler *c, node *n, int keep) {
+
+	bc_write:
+
+	/* error */
+	if (errorIsSet())
+		return;
+
+	/* value folded into a constant */
+	if (n->is_const) {
+
+		if (!keep)
+			return;
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, n->const_val);
+	}
+
+	/* integer */
+	else if (n->type == NODE_INT) {
+
+		if (!keep)
+			return;
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, atoi(n->tokens[0]->t_value));
+	}
+
+	/* string */
+	else if (n->type == NODE_STRING) {
+
+		if (!keep)
+			return;
+
+		compilerWriteOp(c, n, OP_PUSHSTR);
+		compilerWriteStr(c, n->tokens[0]->t_value);
+	}
+
+	/* statements */
+	else if (n->type == NODE_STATEMENTS) {
+
+		for (unsigned int i = 0; i < n->n_of_children; i++) {
+
+			compilerWrite(c, n->children[i], 0);
+
+			/* garbage collect after each top level statement */
+			if (c->depth == 0 && n->children[i]->type != NODE_INCLUDE)
+				compilerWriteOp(c, n->children[i], OP_COLLECT);
+		}
+
+		if (keep) {
+
+			compilerWriteOp(c, n, OP_PUSHINT);
+			compilerWriteInt(c, 0);
+		}
+	}
+
+	/* access a variable's value (which may be stored or changed elsewhere, see compilerWriteValue) */
+	else if (n->type == NODE_VARACCESS) {
+
+		compilerWriteRef(c, n);
+
+		if (!keep) compilerWriteOp(c, n, OP_POP);
+	}
+
+	/* function call */
+	else if (n->type == NODE_CALL) {
+
+		compilerWriteCall(c, n, keep);
+	}
+
+	/* increment and decrement operators */
+	else if (n->type == NODE_INC || n->type == NODE_DEC) {
+
+		compilerWriteRef(c, n);
+		compilerWriteOp(c, n, (n->type == NODE_INC)? OP_POSTINC: OP_POSTDEC);
+
+		if (!keep) compilerWriteOp(c, n, OP_POP);
+	}
+
+	/* binary operation */
+	else if (n->type == NODE_BINOP) {
+
+		compilerWriteValue(c, n->children[0]);
+		compilerWriteValue(c, n->children[1]);
+
+		/* operands are known to be ints or chrs */
+		if (n->checked) compilerWriteOp(c, n, int_ops[n->tokens[0]->t_type]);
+		else {
+
+			compilerWriteOp(c, n, OP_BINOP);
+			bytecodeAdd(c->bc, n->tokens[0]->t_type);
+		}
+
+		if (!keep) compilerWriteOp(c, n, OP_POP);
+	}
+
+	/* unary operation */
+	else if (n->type == NODE_UNOP) {
+
+		/* negating only reads its operand */
+		if (n->tokens[0]->t_type == TOKEN_MINUS) compilerWriteValue(c, n->children[0]);
+		else compilerWrite(c, n->children[0], 1);
+
+		/* negating an int or chr */
+		if (n->checked) compilerWriteOp(c, n, OP_NEGINT);
+		else {
+
+			compilerWriteOp(c, n, OP_UNOP);
+			bytecodeAdd(c->bc, n->tokens[0]->t_type);
+		}
+
+		if (!keep) compilerWriteOp(c, n, OP_POP);
+	}
+
+	/* getitem */
+	else if (n->type == NODE_GETITEM) {
+
+		compilerWriteNames(c, n, n->n_of_tokens);
+		compilerWrite(c, n->children[0], 1);
+		compilerWriteOp(c, n, OP_GETITEM);
+
+		if (!keep) compilerWriteOp(c, n, OP_POP);
+	}
+
+	/* setitem */
+	else if (n->type == NODE_SETITEM) {
+
+		compilerWriteSetItem(c, n, keep);
+	}
+
+	/* undefined variable */
+	else if (n->type == NODE_VARUN) {
+
+		compilerWriteVarUndefined(c, n, keep);
+	}
+
+	/* new variable */
+	else if (n->type == NODE_VARNEW) {
+
+		compilerWriteVarNew(c, n, keep);
+	}
+
+	/* if statement */
+	else if (n->type == NODE_IFNODE) {
+
+		compilerWriteIfStatement(c, n, keep);
+	}
+
+	/* while loop */
+	else if (n->type == NODE_WHILENODE) {
+
+		compilerWriteWhile(c, n, keep);
+	}
+
+	/* for loop */
+	else if (n->type == NODE_FORNODE) {
+
+		compilerWriteFor(c, n, keep);
+	}
+
+	/* function declaration */
+	else if (n->type == NODE_FUNCDEC) {
+
+		compilerWriteFuncDec(c, n, keep);
+	}
+
+	/* function definition */
+	else if (n->type == NODE_FUNCDEF) {
+
+		compilerWriteFuncDef(c, n, keep);
+	}
+
+	/* extern */
+	else if (n->type == NODE_EXTERN) {
+
+		compilerWriteExtern(c, n, keep);
+	}
+
+	/* typedef */
+	else if (n->type == NODE_TYPEDEF) {
+
+		compilerWriteTypeDef(c, n, keep);
+	}
+
+	/* struct */
+	else if (n->type == NODE_STRUCT) {
+
+		compilerWriteStruct(c, n, keep);
+	}
+
+	/* variable assignment */
+	else if (n->type == NODE_VARASSIGN) {
+
+		compilerWriteVarAsg(c, n, keep);
+	}
+
+	/* include a file */
+	else if (n->type == NODE_INCLUDE) {
+
+		compilerWriteInclude(c, n, keep);
+	}
+
+	/* return */
+	else if (n->type == NODE_RETURN) {
+
+		/* a returned call can use the frame of the function */
+		if (n->children[0]->type == NODE_CALL) compilerWriteTailCall(c, n->children[0]);
+		else compilerWrite(c, n->children[0], 1);
+
+		/* position of returned value is used for errors */
+		compilerWriteOp(c, n->children[0], n->checked? OP_CRETURN: OP_RETURN);
+	}
+
+	/* else, const and unsigned only wrap their child */
+	else if (n->type == NODE_ELSENODE || n->type == NODE_CONST || n->type == NODE_UNSIGNED) {
+
+		n = n->children[0];
+		goto bc_write;
+	}
+
+	else {
+
+		/* unimplemented */
+		errorSet(ERROR_TYPE_BYTECODE,
+				 ERROR_CODE_BYTECODEUNIMPL,
+				 "Unimplemented");
+		errorSetPos(n->lineno,
+					n->colno,
+					n->fname);
+	}
+}
+
+/* write opcode */
+extern void compilerWriteOp(compiler *c, node *n, unsigned char op) {
+
+	/* record position of node */
+	compilerAddLine(c, n->lineno, n->colno, n->fname);
+
+	bytecodeAdd(c->bc, op);
+}
+
+/* write integer operand */
+extern void compilerWriteInt(compiler *c, int i) {
+
+	bytecodeWriteIntNS(c->bc, i);
+}
+
+/* write string operand */
+extern void compilerWriteStr(compiler *c, char *s) {
+
+	bytecodeWriteIntNS(c->bc, compilerAddStr(c, s));
+}
+
+/* write type id and type name operands */
+extern void compilerWriteType(compiler *c, char *tp_name) {
+
+	/* builtin types are known, others are looked up when the instruction first runs */
+	if (!strcmp(tp_name, "int")) compilerWriteInt(c, TYPE_INT);
+	else if (!strcmp(tp_name, "chr")) compilerWriteInt(c, TYPE_CHR);
+	else compilerWriteInt(c, TYPE_NONE);
+
+	compilerWriteStr(c, tp_name);
+}
+
+/* load value of a name */
+extern void compilerWriteLoad(compiler *c, node *n, char *name) {
+
+	unsigned int slot = compilerSlot(c, name);
+
+	/* names that aren't local to a function can come from the caller */
+	if (slot == c->scope->n_of_names && c->scope->is_func) {
+
+		compilerWriteOp(c, n, OP_LOADNAME);
+		compilerWriteStr(c, name);
+		return;
+	}
+
+	compilerWriteOp(c, n, OP_LOADSLOT);
+	compilerWriteInt(c, slot);
+	compilerWriteStr(c, name);
+}
+
+/* assign value on stack to a name */
+extern void compilerWriteStore(compiler *c, node *n, char *name) {
+
+	unsigned int slot = compilerSlot(c, name);
+
+	if (slot == c->scope->n_of_names && c->scope->is_func) {
+
+		compilerWriteOp(c, n, OP_STORENAME);
+		compilerWriteStr(c, name);
+	}
+	else {
+
+		compilerWriteOp(c, n, OP_STORESLOT);
+		compilerWriteInt(c, slot);
+		compilerWriteStr(c, name);
+	}
+
+	/* assignment sets the name in the current scope */
+	compilerDeclare(c, name);
+}
+
+/* load names of a chain (a->b->c) */
+extern void compilerWriteNames(compiler *c, node *n, unsigned int cnt) {
+
+	for (unsigned int i = 0; i < cnt; i++) {
+
+		if (!i) {
+
+			compilerWriteLoad(c, n, n->tokens[0]->t_value);
+			continue;
+		}
+
+		compilerWriteOp(c, n, OP_LOADFIELD);
+		compilerWriteStr(c, n->tokens[i]->t_value);
+	}
+}
+
+/* load a name chain whose value may be changed in place or shared with another name (the last field is boxed if it is stored inline) */
+extern void compilerWriteRef(compiler *c, node *n) {
+
+	unsigned int cnt = n->n_of_tokens;
+
+	/* variables always hold objects */
+	if (cnt < 2) {
+
+		compilerWriteNames(c, n, cnt);
+		return;
+	}
+
+	compilerWriteNames(c, n, cnt - 1);
+	compilerWriteOp(c, n, OP_LOADFIELDREF);
+	compilerWriteStr(c, n->tokens[cnt - 1]->t_value);
+}
+
+/* write an operand that is only read, so an inline field doesn't need to be boxed */
+extern void compilerWriteValue(compiler *c, node *n) {
+
+	if (n->type == NODE_VARACCESS) compilerWriteNames(c, n, n->n_of_tokens);
+	else compilerWrite(c, n, 1);
+}
+
+/* write a function call */
+extern void compilerWriteCall(compiler *c, node *n, int keep) {
+
+	/* function and arguments */
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 1);
+
+	compilerWriteOp(c, n, OP_CALL);
+	compilerWriteInt(c, n->n_of_children - 1);
+
+	if (!keep) compilerWriteOp(c, n, OP_POP);
+}
+
+/* write a function call whose result is returned */
+extern void compilerWriteTailCall(compiler *c, node *n) {
+
+	/* function and arguments */
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 1);
+
+	compilerWriteOp(c, n, OP_TAILCALL);
+	compilerWriteInt(c, n->n_of_children - 1);
+}
+
+/* write variable assignment */
+extern void compilerWriteVarAsg(compiler *c, node *n, int keep) {
+
+	/* value */
+	compilerWrite(c, n->children[0], 1);
+
+	if (keep) compilerWriteOp(c, n, OP_DUP);
+
+	/* single name */
+	if (n->n_of_tokens == 1) {
+
+		compilerWriteStore(c, n, n->tokens[0]->t_value);
+		return;
+	}
+
+	/* struct field */
+	compilerWriteNames(c, n, n->n_of_tokens - 1);
+
+	compilerWriteOp(c, n, OP_STOREFIELD);
+	compilerWriteStr(c, n->tokens[n->n_of_tokens - 1]->t_value);
+}
+
+/* write setitem */
+extern void compilerWriteSetItem(compiler *c, node *n, int keep) {
+
+	/* index and value */
+	compilerWrite(c, n->children[0], 1);
+	compilerWrite(c, n->children[1], 1);
+
+	if (keep) compilerWriteOp(c, n, OP_DUPX1);
+
+	/* array */
+	compilerWriteNames(c, n, n->n_of_tokens);
+	compilerWriteOp(c, n, n->checked? OP_CSETITEM: OP_SETITEM);
+}
+
+/* write a new variable */
+extern void compilerWriteVarNew(compiler *c, node *n, int keep) {
+
+	/* array size is evaluated but not used */
+	if (n->values[0])
+		compilerWrite(c, n->children[0], 0);
+
+	/* value */
+	node *val = n->children[n->values[0]];
+	compilerWrite(c, val, 1);
+
+	if (keep) compilerWriteOp(c, n, OP_DUP);
+
+	/* errors are reported at the value */
+	compilerWriteOp(c, val, OP_DECLARE);
+	compilerWriteType(c, n->tokens[0]->t_value);
+	compilerWriteStr(c, n->tokens[1]->t_value);
+	bytecodeAdd(c->bc, (n->values[0]? OP_DECL_ARRAY: 0) | (n->values[1]? OP_DECL_POINTER: 0) | (n->checked? OP_DECL_CHECKED: 0));
+	compilerWriteInt(c, compilerDeclare(c, n->tokens[1]->t_value));
+}
+
+/* write an undefined variable */
+extern void compilerWriteVarUndefined(compiler *c, node *n, int keep) {
+
+	/* array size */
+	if (n->values[0])
+		compilerWrite(c, n->children[0], 1);
+
+	compilerWriteOp(c, n, OP_DECLUNDEF);
+	compilerWriteType(c, n->tokens[0]->t_value);
+	compilerWriteStr(c, n->tokens[1]->t_value);
+	bytecodeAdd(c->bc, (n->values[0]? OP_DECL_ARRAY: 0) | (n->values[1]? OP_DECL_POINTER: 0));
+	compilerWriteInt(c, compilerDeclare(c, n->tokens[1]->t_value));
+
+	if (keep) compilerWriteLoad(c, n, n->tokens[1]->t_value);
+}
+
+/* write an if statement */
+extern void compilerWriteIfStatement(compiler *c, node *n, int keep) {
+
+	c->depth++;
+
+	/* condition */
+	compilerWrite(c, n->children[0], 1);
+	unsigned int l_else = compilerJump(c, n, OP_JMPF);
+
+	/* body */
+	for (unsigned int i = 1; i < n->n_of_children - n->values[0]; i++)
+		compilerWrite(c, n->children[i], 0);
+
+	/* else block */
+	if (n->values[0]) {
+
+		unsigned int l_end = compilerJump(c, n, OP_JMP);
+		compilerPatch(c, l_else);
+
+		compilerWrite(c, n->children[n->n_of_children - 1], 0);
+		compilerPatch(c, l_end);
+	}
+	else compilerPatch(c, l_else);
+
+	c->depth--;
+
+	if (keep) {
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, 0);
+	}
+}
+
+/* write a while loop */
+extern void compilerWriteWhile(compiler *c, node *n, int keep) {
+
+	c->depth++;
+
+	/* condition */
+	unsigned int l_cond = compilerPos(c);
+	compilerWrite(c, n->children[0], 1);
+	unsigned int l_end = compilerJump(c, n, OP_JMPF);
+
+	/* body */
+	for (unsigned int i = 1; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 0);
+
+	/* jump back to condition */
+	compilerWriteOp(c, n, OP_LOOP);
+	compilerWriteOp(c, n, OP_JMP);
+	compilerWriteInt(c, l_cond);
+	compilerPatch(c, l_end);
+
+	c->depth--;
+
+	if (keep) {
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, 0);
+	}
+}
+
+/* write a for loop */
+extern void compilerWriteFor(compiler *c, node *n, int keep) {
+
+	c->depth++;
+
+	/* start and condition */
+	compilerWrite(c, n->children[0], 0);
+
+	unsigned int l_cond = compilerPos(c);
+	compilerWrite(c, n->children[1], 1);
+	unsigned int l_end = compilerJump(c, n, OP_JMPF);
+
+	/* body */
+	for (unsigned int i = 3; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 0);
+
+	/* increment and jump back to condition */
+	compilerWrite(c, n->children[2], 0);
+
+	compilerWriteOp(c, n, OP_LOOP);
+	compilerWriteOp(c, n, OP_JMP);
+	compilerWriteInt(c, l_cond);
+	compilerPatch(c, l_end);
+
+	c->depth--;
+
+	if (keep) {
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, 0);
+	}
+}
+
+/* write function declaration */
+extern void compilerWriteFuncDec(compiler *c, node *n, int keep) {
+
+	compilerDeclare(c, n->tokens[1]->t_value);
+
+	compilerWriteOp(c, n, OP_FUNCDEC);
+
+	/* return type, name and pointer */
+	compilerWriteType(c, n->tokens[0]->t_value);
+	compilerWriteStr(c, n->tokens[1]->t_value);
+	bytecodeAdd(c->bc, (unsigned char)n->values[0]);
+
+	/* arguments */
+	compilerWriteInt(c, (n->n_of_tokens - 2) / 2);
+
+	for (unsigned int i = 2; i < n->n_of_tokens; i += 2) {
+
+		compilerWriteType(c, n->tokens[i]->t_value);
+		compilerWriteStr(c, n->tokens[i+1]->t_value);
+		bytecodeAdd(c->bc, (unsigned char)n->values[((i - 2) / 2) + 1]);
+	}
+
+	if (!keep) compilerWriteOp(c, n, OP_POP);
+}
+
+/* write a function definition */
+extern void compilerWriteFuncDef(compiler *c, node *n, int keep) {
+
+	/* declaration */
+	compilerWrite(c, n->children[0], 1);
+
+	unsigned int l_end = compilerJump(c, n, OP_FUNCBODY);
+
+	/* body has its own scope with the arguments in the first slots */
+	compilerScope *outer = c->scope;
+	c->scope = compilerScopeNew(1);
+
+	for (unsigned int i = 3; i < n->children[0]->n_of_tokens; i += 2)
+		compilerDeclare(c, n->children[0]->tokens[i]->t_value);
+
+	c->depth++;
+
+	for (unsigned int i = 1; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 0);
+
+	c->depth--;
+
+	compilerScopeFree(c->scope);
+	c->scope = outer;
+
+	compilerWriteOp(c, n, OP_LEAVE);
+	compilerPatch(c, l_end);
+
+	if (!keep) compilerWriteOp(c, n, OP_POP);
+}
+
+/* write an external reference */
+extern void compilerWriteExtern(compiler *c, node *n, int keep) {
+
+	unsigned int l_end = compilerJump(c, n, OP_EXTERN);
+
+	/* names are in the top level scope */
+	compilerScope *outer = c->scope;
+	c->scope = c->global;
+
+	c->depth++;
+	compilerWrite(c, n->children[0], keep);
+	c->depth--;
+
+	c->scope = outer;
+
+	compilerWriteOp(c, n, OP_END);
+	compilerPatch(c, l_end);
+}
+
+/* write struct */
+extern void compilerWriteStruct(compiler *c, node *n, int keep) {
+
+	compilerWriteOp(c, n, OP_STRUCT);
+	compilerWriteStr(c, n->tokens[0]->t_value);
+
+	unsigned int l_end = c->bc->len;
+	compilerWriteInt(c, 0);
+
+	/* struct body has its own scope */
+	compilerScope *outer = c->scope;
+	c->scope = compilerScopeNew(0);
+
+	c->depth++;
+
+	for (unsigned int i = 0; i < n->n_of_children; i++)
+		compilerWrite(c, n->children[i], 0);
+
+	c->depth--;
+
+	compilerScopeFree(c->scope);
+	c->scope = outer;
+
+	compilerWriteOp(c, n, OP_END);
+	compilerPatch(c, l_end);
+
+	compilerDeclare(c, n->tokens[0]->t_value);
+
+	if (!keep) compilerWriteOp(c, n, OP_POP);
+}
+
+/* write typedef */
+extern void compilerWriteTypeDef(compiler *c, node *n, int keep) {
+
+	compilerWriteOp(c, n, OP_TYPEDEF);
+	bytecodeAdd(c->bc, (unsigned char)n->values[0]);
+	compilerWriteType(c, n->tokens[0]->t_value);
+	compilerWriteStr(c, n->tokens[1]->t_value);
+
+	if (keep) {
+
+		compilerWriteOp(c, n, OP_PUSHINT);
+		compilerWriteInt(c, 0);
+	}
+}
+
+/* write include file */
+extern void compilerWriteInclude(compiler *c, node *n, int keep) {
+
+	/* run code */
+	mango_ctx ctx = runlp(n->tokens[0]->t_value, n->fname, n->lineno, n->colno);
+
+	/* error */
+	if (ctx.e) {
+
+		/* raise error to stop system */
+		errorSet(ERROR_TYPE_BREAK, 0, NULL);
+		return;
+	}
+
+	/* write node */
+	compilerWrite(c, ctx.parse->pn, keep);
+
+	/* free l and p */
+	node *pn = ctx.parse->pn;
+	parserFree(ctx.parse);
+	lexerFree(ctx.lex);
+	nodeFree(pn);
+}
+
+/* create a new scope */
+extern compilerScope *compilerScopeNew(int is_func) {
+
+	compilerScope *s = (compilerScope *)malloc(sizeof(compilerScope));
+
+	s->names = (unsigned int *)malloc(sizeof(unsigned int) * 8);
+	s->n_of_names = 0;
+	s->cap_names = 8;
+	s->index = (unsigned int *)calloc(16, sizeof(unsigned int));
+	s->is_func = is_func;
+
+	return s;
+}
+
+/* position in the hash index of a scope where a name is or would be added */
+static unsigned int compilerScopeFind(compilerScope *s, unsigned int off) {
+
+	unsigned int mask = s->cap_names * 2 - 1;
+	unsigned int i = (off * 2654435761u) & mask;
+
+	while (s->index[i] && s->names[s->index[i] - 1] != off)
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+/* get the slot of a name in the current scope */
+extern unsigned int compilerSlot(compiler *c, char *name) {
+
+	compilerScope *s = c->scope;
+	unsigned int i = s->index[compilerScopeFind(s, compilerAddStr(c, name))];
+
+	return i? i - 1: s->n_of_names;
+}
+
+/* declare a name in the current scope */
+extern unsigned int compilerDeclare(compiler *c, char *name) {
+
+	unsigned int i = compilerSlot(c, name);
+
+	/* already declared */
+	if (i < c->scope->n_of_names)
+		return i;
+
+	compilerScope *s = c->scope;
+
+	/* resize (and rebuild index) */
+	if (s->n_of_names >= s->cap_names) {
+
+		s->cap_names *= 2;
+		s->names = (unsigned int *)realloc(s->names, sizeof(unsigned int) * s->cap_names);
+
+		free(s->index);
+		s->index = (unsigned int *)calloc(s->cap_names * 2, sizeof(unsigned int));
+
+		for (unsigned int k = 0; k < s->n_of_names; k++)
+			s->index[compilerScopeFind(s, s->names[k])] = k + 1;
+	}
+
+	s->names[s->n_of_names] = compilerAddStr(c, name);
+	s->index[compilerScopeFind(s, s->names[i])] = i + 1;
+	s->n_of_names++;
+
+	return i;
+}
+
+/* free a scope */
+extern void compilerScopeFree(compilerScope *s) {
+
+	free(s->names);
+	free(s->index);
+	free(s);
+}
+
+/* add a string to the string table */
+extern unsigned int compilerAddStr(compiler *c, char *s) {
+
+	/* resize index at half load */
+	if (c->n_strs * 2 >= c->cap_index) {
+
+		compilerStr *old = c->s_index;
+		unsigned int old_cap = c->cap_index;
+
+		c->cap_index = c->cap_index? c->cap_index * 2: 64;
+		c->s_index = (compilerStr *)calloc(c->cap_index, sizeof(compilerStr));
+
+		for (unsigned int k = 0; k < old_cap; k++) {
+
+			if (old[k].atom == NULL)
+				continue;
+
+			unsigned int j = NAMES_HASH(old[k].atom) & (c->cap_index - 1);
+			while (c->s_index[j].atom != NULL) j = (j + 1) & (c->cap_index - 1);
+
+			c->s_index[j] = old[k];
+		}
+
+		free(old);
+	}
+
+	/* search for existing string (interned strings are compared by pointer) */
+	char *atom = namesIntern(s);
+	unsigned int k = NAMES_HASH(atom) & (c->cap_index - 1);
+
+	while (c->s_index[k].atom != NULL) {
+
+		if (c->s_index[k].atom == atom)
+			return c->s_index[k].off;
+
+		k = (k + 1) & (c->cap_index - 1);
+	}
+
+	unsigned int i = c->s_len;
+
+	c->s_index[k].atom = atom;
+	c->s_index[k].off = i;
+	c->n_strs++;
+
+	/* resize */
+	unsigned int len = strlen(s) + 1;
+	while (c->s_len + len > c->s_cap) {
+
+		c->s_cap *= 2;
+		c->strs = (unsigned char *)realloc(c->strs, c->s_cap);
+	}
+
+	/* add string */
+	memcpy(&c->strs[c->s_len], s, len);
+	c->s_len += len;
+
+	return i;
+}
+
+/* add a line table entry */
+extern void compilerAddLine(compiler *c, unsigned int lineno, unsigned int colno, char *fname) {
+
+	unsigned int pos = compilerPos(c);
+
+	/* file name is the same as for the last entry most of the time */
+	if (c->fname == NULL || strcmp(c->fname, fname)) {
+
+		c->fname = namesIntern(fname);
+		c->fname_off = compilerAddStr(c, fname);
+	}
+
+	unsigned int f = c->fname_off;
+
+	/* same position as previous entry */
+	if (c->n_lines > 0) {
+
+		unsigned char *l = &c->lines[(c->n_lines - 1) * 16];
+
+		if (OP_GETUINT(&l[4]) == lineno && OP_GETUINT(&l[8]) == colno && OP_GETUINT(&l[12]) == f)
+			return;
+
+		/* replace entry that has no instructions */
+		if (OP_GETUINT(&l[0]) == pos)
+			c->n_lines--;
+	}
+
+	/* resize */
+	if (c->n_lines >= c->l_cap) {
+
+		c->l_cap *= 2;
+		c->lines = (unsigned char *)realloc(c->lines, c->l_cap * 16);
+	}
+
+	/* add entry */
+	unsigned int vals[4] = {pos, lineno, colno, f};
+	unsigned char *l = &c->lines[(c->n_lines++) * 16];
+
+	for (int i = 0; i < 4; i++) {
+
+		l[i*4+0] = (vals[i] >> 24) & 0xFF;
+		l[i*4+1] = (vals[i] >> 16) & 0xFF;
+		l[i*4+2] = (vals[i] >> 8) & 0xFF;
+		l[i*4+3] = vals[i] & 0xFF;
+	}
+}
+
+/* current position in code section */
+extern unsigned int compilerPos(compiler *c) {
+
+	return c->bc->len - c->code_start;
+}
+
+/* write a jump with a target that isn't known yet */
+extern unsigned int compilerJump(compiler *c, node *n, unsigned char op) {
+
+	compilerWriteOp(c, n, op);
+
+	unsigned int l = c->bc->len;
+	compilerWriteInt(c, 0);
+
+	return l;
+}
+
+/* set jump target to current position */
+extern void compilerPatch(compiler *c, unsigned int l) {
+
+	bytecodeInsertInt(c->bc, l, compilerPos(c));
+}
+
+/* length of the instruction at p */
+extern unsigned int compilerOpLen(unsigned char *p) {
+
+	unsigned int len = 1;
+
+	for (char *fmt = op_formats[p[0]]; fmt != NULL && *fmt; fmt++) {
+
+		if (*fmt == 'b') len++;
+		else if (*fmt == 'a') len += 4 + OP_GETUINT(&p[len]) * 13;
+		else len += 4;
+	}
+
+	return len;
+}
+
+/* offset of the jump operand of the instruction at p (0 if it has none) */
+static unsigned int compilerJumpOff(unsigned char *p) {
+
+	unsigned int off = 1;
+
+	for (char *fmt = op_formats[p[0]]; fmt != NULL && *fmt; fmt++) {
+
+		if (*fmt == 'j')
+			return off;
+
+		off += (*fmt == 'b')? 1: 4;
+	}
+
+	return 0;
+}
+
+/* replace common sequences of instructions in the code section with superinstructions */
+extern void compilerPeephole(compiler *c) {
+
+	unsigned char *code = &c->bc->bytes[c->code_start];
+	unsigned int len = compilerPos(c);
+
+	unsigned char *out = (unsigned char *)malloc(len);
+	unsigned int *map = (unsigned int *)malloc(sizeof(unsigned int) * (len + 1)); /* new position of each instruction */
+	unsigned char *target = (unsigned char *)calloc(len + 1, 1); /* instructions that are jumped to */
+
+	/* sequences can't contain jump targets after their first instruction */
+	for (unsigned int pc = 0; pc < len; pc += compilerOpLen(&code[pc])) {
+
+		unsigned int j = compilerJumpOff(&code[pc]);
+
+		if (j)
+			target[OP_GETUINT(&code[pc + j])] = 1;
+	}
+
+	unsigned int pc = 0, n = 0;
+	while (pc < len) {
+
+		/* instructions that can be replaced along with this one */
+		unsigned int at[4] = {pc};
+		unsigned int cnt = 1;
+
+		while (cnt < 4) {
+
+			unsigned int next = at[cnt - 1] + compilerOpLen(&code[at[cnt - 1]]);
+
+			if (next >= len || target[next])
+				break;
+
+			at[cnt++] = next;
+		}
+
+		unsigned char op[4] = {code[at[0]], (cnt > 1)? code[at[1]]: 0, (cnt > 2)? code[at[2]]: 0, (cnt > 3)? code[at[3]]: 0};
+		unsigned int used = 1;
+
+		/*
+		 * replaced instructions are mapped to the operands that took their
+		 * place, so errors are still reported at their positions
+		 */
+
+		/* increment or decrement a variable as a statement */
+		if (op[0] == OP_LOADSLOT && (op[1] == OP_POSTINC || op[1] == OP_POSTDEC) && op[2] == OP_POP) {
+
+			out[n] = (op[1] == OP_POSTINC)? OP_INCSLOT: OP_DECSLOT;
+			memcpy(&out[n + 1], &code[at[0] + 1], 8);
+
+			map[at[0]] = n;
+			map[at[1]] = n + 1;
+			map[at[2]] = n + 5;
+			n += 9;
+			used = 3;
+		}
+
+		/* add or subtract an integer */
+		else if (op[0] == OP_PUSHINT && (op[1] == OP_ADDINT || (op[1] == OP_SUBINT && OP_GETINT(&code[at[0] + 1]) != INT_MIN))) {
+
+			int i = OP_GETINT(&code[at[0] + 1]);
+
+			out[n] = OP_ADDIMM;
+			OP_PUTUINT(&out[n + 1], (unsigned int)((op[1] == OP_ADDINT)? i: -i));
+
+			map[at[0]] = n;
+			map[at[1]] = n + 1;
+			n += 5;
+			used = 2;
+		}
+
+		/* compare two variables as a condition */
+		else if (op[0] == OP_LOADSLOT && op[1] == OP_LOADSLOT && op[2] >= OP_EQINT && op[2] <= OP_GTINT && op[3] == OP_JMPF) {
+
+			out[n] = OP_CMPJMPF;
+			out[n + 1] = op[2];
+			memcpy(&out[n + 2], &code[at[0] + 1], 8);
+			memcpy(&out[n + 10], &code[at[1] + 1], 8);
+			memcpy(&out[n + 18], &code[at[3] + 1], 4);
+
+			map[at[0]] = n;
+			map[at[1]] = n + 10;
+			map[at[2]] = n + 18;
+			map[at[3]] = n + 19;
+			n += 22;
+			used = 4;
+		}
+
+		/* field of a struct variable */
+		else if (op[0] == OP_LOADSLOT && op[1] == OP_LOADFIELD) {
+
+			out[n] = OP_LOADSLOTF;
+			memcpy(&out[n + 1], &code[at[0] + 1], 8);
+			memcpy(&out[n + 9], &code[at[1] + 1], 4);
+
+			map[at[0]] = n;
+			map[at[1]] = n + 9;
+			n += 13;
+			used = 2;
+		}
+
+		/* other instructions are copied */
+		else {
+
+			unsigned int l = compilerOpLen(&code[pc]);
+
+			memcpy(&out[n], &code[pc], l);
+			map[pc] = n;
+			n += l;
+		}
+
+		pc = at[used - 1] + compilerOpLen(&code[at[used - 1]]);
+	}
+
+	map[len] = n;
+
+	/* move jump targets */
+	for (unsigned int i = 0; i < n; i += compilerOpLen(&out[i])) {
+
+		unsigned int j = compilerJumpOff(&out[i]);
+
+		if (j) {
+
+			unsigned int to = map[OP_GETUINT(&out[i + j])];
+			OP_PUTUINT(&out[i + j], to);
+		}
+	}
+
+	/* move line table entries */
+	for (unsigned int i = 0; i < c->n_lines; i++) {
+
+		unsigned int pos = map[OP_GETUINT(&c->lines[i * 16])];
+		OP_PUTUINT(&c->lines[i * 16], pos);
+	}
+
+	memcpy(code, out, n);
+	c->bc->len = c->code_start + n;
+
+	free(out);
+	free(map);
+	free(target);
+}
+
+/* 4 byte operand as it is packed (ints are zigzag encoded, and slots and type ids are offset so their unset value of -1 takes one byte) */
+static unsigned int compilerPackVal(char f, unsigned int x) {
+
+	if (f == 'i') return (x << 1) ^ (unsigned int)((int)x >> 31);
+	if (f == 'u' || f == 't') return x + 1;
+
+	return x;
+}
+
+/* 4 byte operand from its packed value */
+static unsigned int compilerUnpackVal(char f, unsigned int x) {
+
+	if (f == 'i') return (x >> 1) ^ -(x & 1);
+	if (f == 'u' || f == 't') return x - 1;
+
+	return x;
+}
+
+/* read a varint that must end before end (-1 if it doesn't) */
+static int compilerGetVarint(unsigned char *b, unsigned int end, unsigned int *at, unsigned int *val) {
+
+	unsigned int n = 0;
+
+	while (*at + n < end && n < 4 && (b[*at + n] & 0x80))
+		n++;
+
+	if (*at + n >= end)
+		return -1;
+
+	*val = bytecodeGetVarint(&b[*at], &n);
+	*at += n;
+
+	return 0;
+}
+
+/* copy a section that isn't packed */
+static void compilerCopySection(bytecode *to, unsigned char *b, unsigned int len, unsigned int sect) {
+
+	unsigned int off, size, pos = to->len;
+	bytecodeGetSection(b, len, sect, &off, &size);
+
+	for (unsigned int i = 0; i < size; i++)
+		bytecodeAdd(to, b[off + i]);
+
+	bytecodeSetSection(to, sect, pos, size);
+}
+
+/*
+ * copy linear bytecode for writing it to a file, with the operands, line
+ * table and function table as varints. line table entries are stored as
+ * differences from the previous entry, so most of them take four bytes
+ */
+extern bytecode *compilerPack(bytecode *bc) {
+
+	unsigned int off, size, pos;
+	bytecode *p = bytecodeNew(NULL, bc->mode);
+
+	/* header */
+	for (unsigned int i = 0; i < BYTECODE_HEADER_SIZE; i++)
+		bytecodeAdd(p, bc->bytes[i]);
+
+	p->bytes[7] |= BYTECODE_FLAG_PACKED;
+
+	/* code */
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_CODE, &off, &size);
+	unsigned char *code = &bc->bytes[off];
+	pos = p->len;
+
+	for (unsigned int pc = 0; pc < size;) {
+
+		unsigned char op = code[pc++];
+		bytecodeAdd(p, op);
+
+		for (char *fmt = op_formats[op]; fmt != NULL && *fmt; fmt++) {
+
+			if (*fmt == 'b') bytecodeAdd(p, code[pc++]);
+
+			/* function arguments (type id, type name, name and pointer flag of each) */
+			else if (*fmt == 'a') {
+
+				unsigned int n = OP_GETUINT(&code[pc]);
+				bytecodeWriteVarint(p, n);
+
+				for (pc += 4; n > 0; n--, pc += 13) {
+
+					bytecodeWriteVarint(p, compilerPackVal('t', OP_GETUINT(&code[pc])));
+					bytecodeWriteVarint(p, OP_GETUINT(&code[pc + 4]));
+					bytecodeWriteVarint(p, OP_GETUINT(&code[pc + 8]));
+					bytecodeAdd(p, code[pc + 12]);
+				}
+			}
+
+			else {
+
+				bytecodeWriteVarint(p, compilerPackVal(*fmt, OP_GETUINT(&code[pc])));
+				pc += 4;
+			}
+		}
+	}
+
+	bytecodeSetSection(p, BYTECODE_SECT_CODE, pos, p->len - pos);
+
+	/* string table */
+	compilerCopySection(p, bc->bytes, bc->len, BYTECODE_SECT_POOL);
+
+	/* line table (position, line, column and file name of each entry) */
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_LINES, &off, &size);
+	unsigned int prev[4] = {0, 0, 0, 0};
+	pos = p->len;
+
+	for (unsigned int i = 0; i + 16 <= size; i += 16) {
+
+		for (int k = 0; k < 4; k++) {
+
+			unsigned int x = OP_GETUINT(&bc->bytes[off + i + k * 4]);
+
+			/* columns aren't close to the previous ones */
+			bytecodeWriteVarint(p, (k == 2)? x: compilerPackVal('i', x - prev[k]));
+			prev[k] = x;
+		}
+	}
+
+	bytecodeSetSection(p, BYTECODE_SECT_LINES, pos, p->len - pos);
+
+	/* function table */
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_FUNCS, &off, &size);
+	pos = p->len;
+
+	for (unsigned int i = 0; i + 4 <= size; i += 4)
+		bytecodeWriteVarint(p, OP_GETUINT(&bc->bytes[off + i]));
+
+	bytecodeSetSection(p, BYTECODE_SECT_FUNCS, pos, p->len - pos);
+
+	/* libraries */
+	compilerCopySection(p, bc->bytes, bc->len, BYTECODE_SECT_LIBS);
+
+	return p;
+}
+
+/*
+ * expand linear bytecode written by compilerPack to fixed size operands,
+ * which the interpreter and the jit read and rewrite in place (NULL if it
+ * is invalid)
+ */
+extern bytecode *compilerUnpack(unsigned char *b, unsigned int len) {
+
+	unsigned int off, size, end, x, pos;
+	int err = 0;
+
+	for (unsigned int i = 0; i < BYTECODE_SECT_COUNT; i++)
+		err |= bytecodeGetSection(b, len, i, &off, &size);
+
+	if (err)
+		return NULL;
+
+	bytecode *bc = bytecodeNew(NULL, BYTECODE_CMP);
+
+	/* header */
+	for (unsigned int i = 0; i < BYTECODE_HEADER_SIZE; i++)
+		bytecodeAdd(bc, b[i]);
+
+	bc->bytes[7] &= ~BYTECODE_FLAG_PACKED;
+
+	/* code */
+	bytecodeGetSection(b, len, BYTECODE_SECT_CODE, &off, &size);
+	pos = bc->len;
+
+	for (end = off + size; !err && off < end;) {
+
+		unsigned char op = b[off++];
+
+		if (op >= OP_COUNT) {
+
+			err = 1;
+			break;
+		}
+
+		bytecodeAdd(bc, op);
+
+		for (char *fmt = op_formats[op]; !err && fmt != NULL && *fmt; fmt++) {
+
+			if (*fmt == 'b') {
+
+				if (off < end) bytecodeAdd(bc, b[off++]);
+				else err = 1;
+			}
+
+			else if (*fmt == 'a') {
+
+				unsigned int n = 0;
+				err = compilerGetVarint(b, end, &off, &n) < 0;
+
+				if (!err)
+					bytecodeWriteIntNS(bc, n);
+
+				for (; !err && n > 0; n--) {
+
+					for (int k = 0; !err && k < 3; k++) {
+
+						err = compilerGetVarint(b, end, &off, &x) < 0;
+						bytecodeWriteIntNS(bc, (k == 0)? compilerUnpackVal('t', x): x);
+					}
+
+					if (!err && off < end) bytecodeAdd(bc, b[off++]);
+					else err = 1;
+				}
+			}
+
+			else {
+
+				err = compilerGetVarint(b, end, &off, &x) < 0;
+				bytecodeWriteIntNS(bc, compilerUnpackVal(*fmt, x));
+			}
+		}
+	}
+
+	bytecodeSetSection(bc, BYTECODE_SECT_CODE, pos, bc->len - pos);
+
+	/* string table */
+	compilerCopySection(bc, b, len, BYTECODE_SECT_POOL);
+
+	/* line table */
+	bytecodeGetSection(b, len, BYTECODE_SECT_LINES, &off, &size);
+	unsigned int prev[4] = {0, 0, 0, 0};
+	pos = bc->len;
+
+	for (end = off + size; !err && off < end;) {
+
+		for (int k = 0; !err && k < 4; k++) {
+
+			err = compilerGetVarint(b, end, &off, &x) < 0;
+			prev[k] = (k == 2)? x: prev[k] + compilerUnpackVal('i', x);
+
+			bytecodeWriteIntNS(bc, prev[k]);
+		}
+	}
+
+	bytecodeSetSection(bc, BYTECODE_SECT_LINES, pos, bc->len - pos);
+
+	/* function table */
+	bytecodeGetSection(b, len, BYTECODE_SECT_FUNCS, &off, &size);
+	pos = bc->len;
+
+	for (end = off + size; !err && off < end;) {
+
+		err = compilerGetVarint(b, end, &off, &x) < 0;
+		bytecodeWriteIntNS(bc, x);
+	}
+
+	bytecodeSetSection(bc, BYTECODE_SECT_FUNCS, pos, bc->len - pos);
+
+	/* libraries */
+	compilerCopySection(bc, b, len, BYTECODE_SECT_LIBS);
+
+	if (err) {
+
+		bytecodeFree(bc);
+		return NULL;
+	}
+
+	return bc;
+}
+
+/* print instructions */
+extern void compilerPrint(bytecode *bc) {
+
+	unsigned int code_off, code_len, str_off, str_len;
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_CODE, &code_off, &code_len);
+	bytecodeGetSection(bc->bytes, bc->len, BYTECODE_SECT_POOL, &str_off, &str_len);
+
+	unsigned char *code = &bc->bytes[code_off];
+	char *strs = (char *)&bc->bytes[str_off];
+
+	unsigned int pc = 0;
+	while (pc < code_len) {
+
+		unsigned char op = code[pc];
+
+		/* unknown opcode */
+		if (op >= OP_COUNT || op_names[op] == NULL) {
+
+			printf("%08x  ?? %02x\n", pc, op);
+			return;
+		}
+
+		printf("%08x  %-10s", pc++, op_names[op]);
+
+		/* operands */
+		char *fmt = op_formats[op];
+		while (fmt != NULL && *fmt) {
+
+			char f = *fmt++;
+
+			/* byte */
+			if (f == 'b') printf(" %d", code[pc++]);
+
+			/* slot */
+			else if (f == 'u') {
+
+				printf(" #%u", OP_GETUINT(&code[pc]));
+				pc += 4;
+			}
+
+			/* type id */
+			else if (f == 't') {
+
+				if (OP_GETUINT(&code[pc]) == TYPE_NONE) printf(" %%?");
+				else printf(" %%%u", OP_GETUINT(&code[pc]));
+				pc += 4;
+			}
+
+			/* integer or jump */
+			else if (f == 'i' || f == 'j') {
+
+				printf((f == 'i')? " %d": " ->%08x", OP_GETINT(&code[pc]));
+				pc += 4;
+			}
+
+			/* string */
+			else if (f == 's') {
+
+				printf(" '%s'", &strs[OP_GETUINT(&code[pc])]);
+				pc += 4;
+			}
+
+			/* function arguments */
+			else if (f == 'a') {
+
+				int n = OP_GETINT(&code[pc]);
+				pc += 4;
+
+				for (int i = 0; i < n; i++) {
+
+					printf(" (%s", &strs[OP_GETUINT(&code[pc+4])]);
+					printf(" %s", &strs[OP_GETUINT(&code[pc+8])]);
+					printf(code[pc+12]? " *)": ")");
+					pc += 13;
+				}
+			}
+		}
+
+		printf("\n");
+	}
+}
+
+/* free a compiler */
+extern void compilerFree(compiler *c) {
+
+	compilerScopeFree(c->global);
+	free(c->strs);
+	free(c->s_index);
+	free(c->lines);
+	free(c);
+}
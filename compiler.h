@@ -0,0 +1,108 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* compiler.h -- linear bytecode compiler */
+#ifndef _COMPILER_H
+#define _COMPILER_H
+
+#include "bytecode.h" /* output buffer */
+#include "opcode.h" /* instructions */
+
+/* names declared in a scope, in slot order */
+typedef struct {
+	unsigned int *names; /* string table offsets of names */
+	unsigned int n_of_names; /* number of slots */
+	unsigned int cap_names; /* capacity of list */
+	unsigned int *index; /* open addressing hash index of names by string table offset (slot + 1, 0 if empty), twice the capacity of the list */
+	int is_func; /* function scope (names that aren't declared are looked up at run time) */
+} compilerScope;
+
+/* entry of the hash index of the string table */
+typedef struct {
+	char *atom; /* interned string (NULL if the entry is empty) */
+	unsigned int off; /* offset in string table */
+} compilerStr;
+
+/* compiler struct */
+typedef struct {
+	bytecode *bc; /* bytecode that code is written to */
+	unsigned char *strs; /* string table */
+	unsigned int s_len; /* length of string table */
+	unsigned int s_cap; /* capacity of string table */
+	compilerStr *s_index; /* open addressing hash index of string table by interned string */
+	unsigned int n_strs; /* number of strings */
+	unsigned int cap_index; /* size of index (power of two) */
+	char *fname; /* file name of last line table entry (interned) */
+	unsigned int fname_off; /* offset of fname in string table */
+	unsigned char *lines; /* line table (pc, line, column, file) */
+	unsigned int n_lines; /* number of line table entries */
+	unsigned int l_cap; /* capacity of line table in entries */
+	unsigned int code_start; /* position of code section in bc */
+	unsigned int depth; /* nesting depth (0 = top level statement) */
+	compilerScope *scope; /* scope that names are currently declared in */
+	compilerScope *global; /* top level scope */
+} compiler;
+
+/* functions */
+extern compiler *compilerNew(bytecode *bc); /* create a new compiler */
+extern void compilerComp(compiler *c); /* compile root node of bytecode */
+extern void compilerWrite(compiler *c, node *n, int keep); /* write node, keep result on stack if keep is set */
+extern void compilerWriteOp(compiler *c, node *n, unsigned char op); /* write opcode and record position of node */
+extern void compilerWriteInt(compiler *c, int i); /* write integer operand */
+extern void compilerWriteStr(compiler *c, char *s); /* write string operand */
+extern void compilerWriteType(compiler *c, char *tp_name); /* write type id and type name operands */
+extern void compilerWriteLoad(compiler *c, node *n, char *name); /* load value of a name */
+extern void compilerWriteStore(compiler *c, node *n, char *name); /* assign value on stack to a name */
+extern void compilerWriteNames(compiler *c, node *n, unsigned int cnt); /* load first cnt names of a name chain */
+extern void compilerWriteRef(compiler *c, node *n); /* load a name chain whose value may be changed in place or shared */
+extern void compilerWriteValue(compiler *c, node *n); /* write an operand that is only read */
+extern void compilerWriteCall(compiler *c, node *n, int keep); /* function call */
+extern void compilerWriteTailCall(compiler *c, node *n); /* function call in a return statement */
+extern void compilerWriteVarAsg(compiler *c, node *n, int keep); /* variable assignment */
+extern void compilerWriteSetItem(compiler *c, node *n, int keep); /* setitem */
+extern void compilerWriteVarNew(compiler *c, node *n, int keep); /* new variable */
+extern void compilerWriteVarUndefined(compiler *c, node *n, int keep); /* undefined variable */
+extern void compilerWriteIfStatement(compiler *c, node *n, int keep); /* if statement */
+extern void compilerWriteWhile(compiler *c, node *n, int keep); /* while loop */
+extern void compilerWriteFor(compiler *c, node *n, int keep); /* for loop */
+extern void compilerWriteFuncDec(compiler *c, node *n, int keep); /* function declaration */
+extern void compilerWriteFuncDef(compiler *c, node *n, int keep); /* function definition */
+extern void compilerWriteExtern(compiler *c, node *n, int keep); /* extern */
+extern void compilerWriteStruct(compiler *c, node *n, int keep); /* struct */
+extern void compilerWriteTypeDef(compiler *c, node *n, int keep); /* typedef */
+extern void compilerWriteInclude(compiler *c, node *n, int keep); /* include a file */
+extern compilerScope *compilerScopeNew(int is_func); /* create a new scope */
+extern unsigned int compilerSlot(compiler *c, char *name); /* get slot of a name in the current scope (n_of_names if it isn't declared) */
+extern unsigned int compilerDeclare(compiler *c, char *name); /* declare a name in the current scope and return its slot */
+extern void compilerScopeFree(compilerScope *s); /* free a scope */
+extern unsigned int compilerAddStr(compiler *c, char *s); /* add string to string table, return offset */
+extern void compilerAddLine(compiler *c, unsigned int lineno, unsigned int colno, char *fname); /* add line table entry for current position */
+extern unsigned int compilerPos(compiler *c); /* current position in code section */
+extern unsigned int compilerJump(compiler *c, node *n, unsigned char op); /* write jump with unknown target, return operand position */
+extern void compilerPatch(compiler *c, unsigned int l); /* set jump operand at l to current position */
+extern unsigned int compilerOpLen(unsigned char *p); /* length of the instruction at p */
+extern void compilerPeephole(compiler *c); /* replace common sequences of instructions with superinstructions */
+extern bytecode *compilerPack(bytecode *bc); /* copy linear bytecode with its operands and tables packed as varints, for writing it to a file */
+extern bytecode *compilerUnpack(unsigned char *b, unsigned int len); /* expand packed linear bytecode to fixed size operands (NULL if it is invalid) */
+extern void compilerPrint(bytecode *bc); /* print instructions of linear bytecode */
+extern void compilerFree(compiler *c); /* free a compiler */
+
+#endif /* _COMPILER_H */
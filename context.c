@@ -24,6 +24,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+/* frame stack (blocks of frames, so contexts don't move when it grows) */
+static contextFrame **frames = NULL;
+static unsigned int n_of_frames = 0; /* frames in use */
+static unsigned int n_init_frames = 0; /* frames with a name table */
+static unsigned int n_of_blocks = 0;
+
+#define FRAME(i) (&frames[(i) / CONTEXT_FRAME_BLOCK][(i) % CONTEXT_FRAME_BLOCK])
+
 /* create a context */
 extern context *contextNew(char *fn, char *sn) {
 
@@ -64,4 +72,71 @@ extern void contextFree(context *ctx) {
 
 	/* free context */
 	free(ctx);
+}
+
+/* get a context for a function call */
+extern context *contextPush(char *fn, char *sn) {
+
+	/* add a block of frames */
+	if (n_of_frames >= n_of_blocks * CONTEXT_FRAME_BLOCK) {
+
+		frames = (contextFrame **)realloc(frames, sizeof(contextFrame *) * (n_of_blocks + 1));
+		frames[n_of_blocks++] = (contextFrame *)malloc(sizeof(contextFrame) * CONTEXT_FRAME_BLOCK);
+	}
+
+	contextFrame *f = FRAME(n_of_frames);
+
+	/* first use of frame */
+	if (n_of_frames >= n_init_frames) {
+
+		namesInit(&f->nt);
+		n_init_frames++;
+	}
+
+	n_of_frames++;
+
+	/* set values */
+	f->ctx.fn = fn;
+	f->ctx.sn = sn;
+	f->ctx.tp = CONTEXT_FUNC;
+	f->ctx.rt = NULL;
+	f->ctx.nt = &f->nt;
+
+	return &f->ctx;
+}
+
+/* release the context of the last function call */
+extern void contextPop(context *ctx) {
+
+	/* release names, the lists stay with the frame */
+	namesClear(ctx->nt);
+	n_of_frames--;
+}
+
+/* free the frame stack */
+extern void contextFreeFrames() {
+
+	for (unsigned int i = 0; i < n_init_frames; i++) {
+
+		namesClear(&FRAME(i)->nt);
+
+		free(FRAME(i)->nt.names);
+		free(FRAME(i)->nt.values);
+	}
+
+	for (unsigned int i = 0; i < n_of_blocks; i++)
+		free(frames[i]);
+
+	free(frames);
+
+	frames = NULL;
+	n_of_frames = 0;
+	n_init_frames = 0;
+	n_of_blocks = 0;
+}
+
+/* get the number of frames in use */
+extern unsigned int contextDepth() {
+
+	return n_of_frames;
 }
\ No newline at end of file
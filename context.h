@@ -29,6 +29,9 @@
 #define CONTEXT_FUNC   1
 #define CONTEXT_STRUCT 2
 
+/* number of call frames allocated at once */
+#define CONTEXT_FRAME_BLOCK 64
+
 /* context type: provide a scope for variables */
 typedef struct {
 	nameTable *nt; /* table of names */
@@ -38,8 +41,18 @@ typedef struct {
 	object *rt; /* return value for functions */
 } context;
 
+/* function call frame (frames are allocated in blocks and used again by later calls) */
+typedef struct {
+	context ctx; /* context of call */
+	nameTable nt; /* names of call (arguments and locals) */
+} contextFrame;
+
 /* functions */
 extern context *contextNew(char *, char *); /* create a new context */
 extern void contextFree(context *); /* free a context */
+extern context *contextPush(char *, char *); /* get a context for a function call from the frame stack */
+extern void contextPop(context *); /* release the context of the last function call */
+extern void contextFreeFrames(); /* free the frame stack */
+extern unsigned int contextDepth(); /* get the number of function calls using a frame */
 
 #endif /* _CONTEXT_H */
\ No newline at end of file
@@ -31,6 +31,7 @@ unsigned int error_colno = 0;
 unsigned int is_error = 0;
 unsigned int error_code = 0;
 char *error_fname = NULL;
+unsigned int error_has_pos = 0;
 
 /* set the error type and value */
 extern void errorSet(unsigned int err_type,
@@ -48,6 +49,7 @@ extern void errorSetPos(unsigned int lineno,
 						unsigned int colno, char *fname) {
 
 	is_error = 1;
+	error_has_pos = 1;
 
 	error_lineno = lineno;
 	error_colno = colno;
@@ -60,6 +62,12 @@ extern unsigned int errorIsSet() {
 	return is_error;
 }
 
+/* check if the position of the error is set */
+extern unsigned int errorHasPos() {
+
+	return error_has_pos;
+}
+
 /* print the error */
 extern void errorPrint() {
 
@@ -78,6 +86,8 @@ extern void errorPrint() {
 		error_name = "Bytecode Error";
 	else if (error_type == ERROR_TYPE_INTERNAL)
 		error_name = "Internal Error";
+	else if (error_type == ERROR_TYPE_TYPE)
+		error_name = "Type Error";
 
 	/* get file name */
 	char *fname = error_fname;
@@ -97,6 +107,7 @@ extern void errorClear() {
 	error_message = NULL;
 	error_lineno = 0;
 	error_colno = 0;
+	error_has_pos = 0;
 	error_type = 0;
 	error_code = 0;
 }
\ No newline at end of file
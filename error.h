@@ -28,6 +28,7 @@
 #define ERROR_TYPE_RUNTIME 1
 #define ERROR_TYPE_BYTECODE 2
 #define ERROR_TYPE_INTERNAL 3
+#define ERROR_TYPE_TYPE 4
 #define ERROR_TYPE_BREAK 100
 
 /* error codes */
@@ -50,11 +51,13 @@
 #define ERROR_CODE_NOFILE 406 /* failed to open file */
 #define ERROR_CODE_INVALIDVALUE 407 /* used for invalid values in builtins */
 #define ERROR_CODE_INVALIDPTR 408 /* NULL pointer passed */
+#define ERROR_CODE_STACKOVERFLOW 409 /* too many nested function calls */
 
 /* functions */
 extern void errorSet(unsigned int err_type, unsigned int err_code, const char *err_msg); /* set the error */
 extern void errorSetPos(unsigned int lineno, unsigned int colno, char *fname); /* set the error pos */
 extern unsigned int errorIsSet(); /* check if error is set */
+extern unsigned int errorHasPos(); /* check if the position of the error is set */
 extern void errorPrint(); /* print the error */
 extern void errorClear(); /* clear the error */
 
@@ -26,7 +26,7 @@
 #include "object.h"
 #include "vm.h"
 
-/* for builtin functions */
+/* for builtin functions (called with the caller's context) */
 typedef object *(*bfunc_handle_t)(object **, void *);
 
 /* function object struct */
@@ -41,6 +41,7 @@ typedef struct {
 	int fb_n; /* number of nodes in function body */
 	int is_builtin; /* builtin functions are functions that run C code but can be called in Mango */
 	vm *ov; /* original vm (to avoid segfaults and keep original settings/idata) */
+	char *fname; /* file that function was declared in */
 } functionobject;
 
 /* macros */
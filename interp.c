@@ -0,0 +1,1470 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* linear bytecode interpreter */
+#include "interp.h"
+#include "object.h"
+#include "arrayobject.h"
+#include "intobject.h"
+#include "pointerobject.h"
+#include "functionobject.h"
+#include "structobject.h"
+#include "typedef.h"
+#include "error.h"
+#include "token.h"
+#include "jit.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef unsigned char u8;
+
+extern int VM_DEBUG;
+extern FILE *debug_file;
+extern context *vmdctx;
+
+/* operand stack (shared by all vms and calls) */
+static object **interp_stack = NULL;
+static unsigned int interp_sp = 0;
+static unsigned int interp_cap = 0;
+
+/* call stack (shared by all vms) */
+static interpFrame *interp_frames = NULL;
+static unsigned int interp_fp = 0;
+static unsigned int interp_fcap = 0;
+
+static int interpLoop(vm *v, unsigned char *pc, object *fnc, object **res, int step);
+
+/* references held by the stack (immediates have none, pointers and last references take the slow path) */
+#define REF(o) do { if (IMM_IS(o)); else if ((o)->type & OBJECT_POINTER) objectRef(o); else INCREF(o); } while (0)
+#define UNREF(o) do { if (IMM_IS(o)); else if ((o)->type & OBJECT_POINTER || (o)->refcnt < 2) objectUnref(o); else DECREF(o); } while (0)
+
+/* stack macros (items are owned by the stack and released when they are dropped) */
+#define PUSH(o) do { object *_p = (o); if (interp_sp >= interp_cap) interpGrow(); REF(_p); interp_stack[interp_sp++] = _p; } while (0)
+#define PEEK(n) (interp_stack[interp_sp - 1 - (n)])
+#define TOP() PEEK(0)
+#define DROP(n) do { for (unsigned int _n = (n); _n > 0; _n--) { object *_d = interp_stack[--interp_sp]; UNREF(_d); } } while (0)
+
+/* replace the top n items with a result (referenced first, as it may be one of them or belong to one) */
+#define REPLACE(n, o) do { object *_r = (o); REF(_r); DROP(n); interp_stack[interp_sp++] = _r; } while (0)
+
+/* operation on the top two items, which the compiler found to be ints or chrs */
+#define INTOP(e) do { int x = INTOF(PEEK(1)); int y = INTOF(PEEK(0)); REPLACE(2, IMM_NEW(OBJECT_INT, (e))); } while (0)
+
+/* string operand */
+#define STR(p) (v->strs + OP_GETUINT(p))
+
+/* type and value of stack items that may be immediate */
+#define TYPEOF(o) (IMM_IS(o)? IMM_TYPE(o): (o)->type)
+#define INTOF(o) (IMM_IS(o)? IMM_VAL(o): ((o)->type == OBJECT_CHR)? O_CHR(o)->val: O_INT(o)->val)
+#define BOX(o) (IMM_IS(o)? intcharobjectNew(IMM_TYPE(o) == OBJECT_CHR, IMM_VAL(o)): (o))
+
+/* name operand (interned on first use) */
+#define ATOM(p) ((v->atoms[OP_GETUINT(p)] != NULL)? v->atoms[OP_GETUINT(p)]: interpAtom(v, OP_GETUINT(p)))
+
+/* string literal operand (created on first use) */
+#define STRING(p) ((v->strings[OP_GETUINT(p)] != NULL)? v->strings[OP_GETUINT(p)]: interpString(v, OP_GETUINT(p)))
+
+/* type id operand (looked up on first use, the type name follows it) */
+#define TYPEID(p) ((OP_GETUINT(p) != TYPE_NONE)? OP_GETUINT(p): interpTypeId(v, (p)))
+
+/* grow the operand stack */
+static void interpGrow() {
+
+	interp_cap = interp_cap? interp_cap * 2: 64;
+	interp_stack = (object **)realloc(interp_stack, sizeof(object *) * interp_cap);
+}
+
+/* free the operand and call stacks */
+extern void interpFree() {
+
+	free(interp_stack);
+	free(interp_frames);
+
+	interp_stack = NULL;
+	interp_frames = NULL;
+	interp_sp = interp_cap = 0;
+	interp_fp = interp_fcap = 0;
+}
+
+/* intern a name from the string table */
+extern char *interpAtom(vm *v, unsigned int off) {
+
+	v->atoms[off] = namesIntern(v->strs + off);
+	return v->atoms[off];
+}
+
+/* create the constant object of a string literal from the string table */
+extern object *interpString(vm *v, unsigned int off) {
+
+	v->strings[off] = vmStringNew(v->strs + off);
+	return v->strings[off];
+}
+
+/* look up the type id of a type name and write it into the instruction */
+extern unsigned int interpTypeId(vm *v, unsigned char *p) {
+
+	unsigned int id = typeId(STR(p + 4));
+
+	OP_PUTUINT(p, id);
+	return id;
+}
+
+/* get the value of a name by slot, remembering the slot it was found in */
+extern object *interpLoadSlot(vm *v, unsigned char *p) {
+
+	nameTable *nt = v->ctx->nt;
+	char *name = ATOM(p + 4);
+	unsigned int idx = namesIndexAt(nt, OP_GETUINT(p), name);
+
+	/* found in this scope, remember the slot */
+	if (idx < nt->n_of_names) {
+
+		if (idx != OP_GETUINT(p)) OP_PUTUINT(p, idx);
+		return nt->values[idx];
+	}
+
+	/* outer scope */
+	return (nt->parent != NULL)? namesGet(nt->parent, name): NULL;
+}
+
+/* get a field of a struct or struct pointer (ref boxes an inline int or chr so it can be changed in place) */
+extern object *interpField(vm *v, object *a, unsigned char *p, int ref) {
+
+	/* not a struct */
+	if (IMM_IS(a) || (a->type & 0x3) != OBJECT_STRUCT || (a->type & OBJECT_ARRAY)) {
+
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		return NULL;
+	}
+
+	/* struct pointer */
+	if ((a->type & OBJECT_POINTER) && (a = O_OBJ(O_PTR(a)->val)) == NULL) {
+
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_INVALIDPTR,
+				 "Invalid pointer (null)");
+		return NULL;
+	}
+
+	/* field slot from the inline cache */
+	char *name = ATOM(p);
+	nameTable *nt = O_STRUCT(a)->nt;
+	unsigned int idx = vmFieldIndex(vmFieldEntry(v, p - v->code, name), a, name);
+
+	object *o = (idx < nt->n_of_names)? nt->values[idx]: namesGet(nt, name);
+
+	/* no field */
+	if (o == NULL) {
+
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined name");
+	}
+
+	else if (ref && IMM_IS(o))
+		o = structobjectBox(a, idx);
+
+	return o;
+}
+
+/* report an error that doesn't have a position yet at an instruction or one of its operands */
+static int interpErrorPos(vm *v, unsigned char *at) {
+
+	unsigned int lineno, colno;
+	char *fname;
+
+	if (!errorHasPos()) {
+
+		interpGetPos(v, at, &lineno, &colno, &fname);
+		errorSetPos(lineno, colno, fname);
+	}
+
+	return -1;
+}
+
+/* set a runtime error at an instruction or one of its operands */
+static int interpError(vm *v, unsigned char *at, int code, char *msg) {
+
+	errorSet(ERROR_TYPE_RUNTIME, code, msg);
+	return interpErrorPos(v, at);
+}
+
+/* assign the value on top of the stack to a name by slot */
+extern int interpStoreSlot(vm *v, unsigned char *ip) {
+
+	u8 *p = ip + 1;
+	nameTable *nt = v->ctx->nt;
+	char *name = ATOM(p + 4);
+	unsigned int idx = namesIndexAt(nt, OP_GETUINT(p), name);
+	object *a, *b = TOP();
+
+	/* found in this scope, remember the slot */
+	if (idx < nt->n_of_names) {
+
+		if (idx != OP_GETUINT(p)) OP_PUTUINT(p, idx);
+		a = nt->values[idx];
+	}
+
+	/* outer scope (the name is set in this scope) */
+	else a = (nt->parent != NULL)? namesGet(nt->parent, name): NULL;
+
+	/* not a value */
+	if (a == NULL)
+		return interpError(v, ip, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	/* check types */
+	if (a->type != TYPEOF(b))
+		return interpError(v, ip, ERROR_CODE_ILLEGALOP, "Mismatched types");
+
+	namesSetAt(nt, idx, name, BOX(b));
+	DROP(1);
+	return 0;
+}
+
+/* end of a loop iteration */
+extern int interpLoopEnd(vm *v, unsigned char *ip) {
+
+	/* keyboard interrupt */
+	if (INT_SIGNAL) {
+
+		INT_SIGNAL = 0;
+		return interpError(v, ip, ERROR_CODE_KBINT, "Keyboard interrupt");
+	}
+
+	vmCollect();
+	return 0;
+}
+
+/*
+ * superinstructions (errors of the instructions they replaced are
+ * reported at the operands that took their place)
+ */
+
+/* increment or decrement an int or chr variable by slot */
+extern int interpIncSlot(vm *v, unsigned char *ip) {
+
+	object *a = interpLoadSlot(v, ip + 1);
+	int d = (*ip == OP_INCSLOT)? 1: -1;
+
+	if (a == NULL)
+		return interpError(v, ip, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	/* not an int or chr variable */
+	if (IMM_IS(a) || (a->type != OBJECT_INT && a->type != OBJECT_CHR))
+		return interpError(v, ip + 1, ERROR_CODE_ILLEGALOP, "Illegal operation");
+
+	if (a->type == OBJECT_INT) O_INT(a)->val += d;
+	else O_CHR(a)->val += d;
+	return 0;
+}
+
+/* push a field of a struct variable by slot */
+extern int interpLoadSlotField(vm *v, unsigned char *ip) {
+
+	object *a = interpLoadSlot(v, ip + 1);
+
+	if (a == NULL)
+		return interpError(v, ip, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	object *o = interpField(v, a, ip + 9, 0);
+
+	if (o == NULL)
+		return interpErrorPos(v, ip + 9);
+
+	PUSH(o);
+	return 0;
+}
+
+/* compare two variables by slot with the int operation of a CMPJMPF */
+extern int interpCmpSlots(vm *v, unsigned char *ip) {
+
+	object *a = interpLoadSlot(v, ip + 2);
+
+	if (a == NULL)
+		return interpError(v, ip, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	object *b = interpLoadSlot(v, ip + 10);
+
+	if (b == NULL)
+		return interpError(v, ip + 10, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	int x = INTOF(a), y = INTOF(b);
+
+	switch (ip[1]) {
+
+		case OP_EQINT: return x == y;
+		case OP_NEINT: return x != y;
+		case OP_LTINT: return x < y;
+		default: return x > y;
+	}
+}
+
+/* binary operation, int and chr results are immediate */
+extern object *interpOperation(object *a, object *b, unsigned char op) {
+
+	unsigned char ta = TYPEOF(a);
+	unsigned char tb = TYPEOF(b);
+
+	/* int and chr (int op chr is not allowed) */
+	if ((ta == OBJECT_INT || ta == OBJECT_CHR) && (tb == OBJECT_INT || (tb == OBJECT_CHR && ta == OBJECT_CHR))) {
+
+		int x = INTOF(a);
+		int y = INTOF(b);
+
+		switch (op) {
+
+			case TOKEN_PLUS: return IMM_NEW(OBJECT_INT, x + y);
+			case TOKEN_MINUS: return IMM_NEW(OBJECT_INT, x - y);
+			case TOKEN_MUL: return IMM_NEW(OBJECT_INT, x * y);
+			case TOKEN_DIV: return IMM_NEW(OBJECT_INT, x / y);
+			case TOKEN_MOD: return IMM_NEW(OBJECT_INT, x % y);
+			case TOKEN_EE: return IMM_NEW(OBJECT_INT, x == y);
+			case TOKEN_NE: return IMM_NEW(OBJECT_INT, x != y);
+			case TOKEN_LT: return IMM_NEW(OBJECT_INT, x < y);
+			case TOKEN_GT: return IMM_NEW(OBJECT_INT, x > y);
+		}
+	}
+
+	/* other types */
+	return objectOperation(BOX(a), BOX(b), op);
+}
+
+/* read section offsets from header */
+extern int interpLoad(vm *v) {
+
+	u8 *bc = (u8 *)v->bc;
+
+	/* get sections */
+	unsigned int code_off, code_len, str_off, str_len, line_off, line_len;
+
+	if (bytecodeGetSection(bc, v->bc_len, BYTECODE_SECT_CODE, &code_off, &code_len) < 0 ||
+		bytecodeGetSection(bc, v->bc_len, BYTECODE_SECT_POOL, &str_off, &str_len) < 0 ||
+		bytecodeGetSection(bc, v->bc_len, BYTECODE_SECT_LINES, &line_off, &line_len) < 0 || code_len == 0)
+		return -1;
+
+	unsigned int n_lines = line_len / 16;
+
+	/* set values */
+	v->code = &bc[code_off];
+	v->code_len = code_len;
+	v->strs = (char *)&bc[str_off];
+	v->lines = &bc[line_off];
+	v->n_lines = n_lines;
+	v->atoms = (char **)calloc(str_len, sizeof(char *));
+	v->strings = (object **)calloc(str_len, sizeof(object *));
+
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[interp] code: %u bytes, strings: %u bytes, lines: %u entries\n", code_len, str_len, n_lines);
+
+	return 0;
+}
+
+/* execute linear bytecode */
+extern void interpExec(vm *v) {
+
+	/* load sections */
+	if (interpLoad(v) < 0) {
+
+		fprintf(stderr, "Invalid bytecode in file '%s'!\n", v->ctx->fn);
+		return;
+	}
+
+	/* file name */
+	if (v->n_lines > 0)
+		v->ctx->fn = STR(&v->lines[12]);
+
+	/* run code */
+	object *res = NULL;
+	interpRun(v, v->code, NULL, &res);
+}
+
+/* get source position of an instruction */
+extern void interpGetPos(vm *v, unsigned char *pc, unsigned int *lineno, unsigned int *colno, char **fname) {
+
+	unsigned int off = (unsigned int)(pc - v->code);
+
+	*lineno = 0;
+	*colno = 0;
+	*fname = v->ctx->fn;
+
+	if (v->n_lines == 0)
+		return;
+
+	/* find last entry before or at pc */
+	unsigned int lo = 0, hi = v->n_lines;
+	while (hi - lo > 1) {
+
+		unsigned int mid = (lo + hi) / 2;
+
+		if (OP_GETUINT(&v->lines[mid * 16]) <= off) lo = mid;
+		else hi = mid;
+	}
+
+	/* set values */
+	u8 *l = &v->lines[lo * 16];
+
+	*lineno = OP_GETUINT(&l[4]);
+	*colno = OP_GETUINT(&l[8]);
+	*fname = STR(&l[12]);
+}
+
+/* run code until the end of a block or a return, or a single instruction if step is set */
+static int interpLoop(vm *v, unsigned char *pc, object *fnc, object **res, int step) {
+
+	unsigned int base = interp_sp; /* stack position of current call */
+	unsigned int fp = interp_fp; /* calls below this were not made by this loop */
+	u8 *ip; /* start of current instruction */
+	object *a, *b, *c, *o;
+	int st;
+
+	while (1) {
+
+		ip = pc;
+		u8 op = *pc++;
+
+		if (VM_DEBUG) fprintf(debug_file, "[interp] %08x op %02x\n", (unsigned int)(ip - v->code), op);
+
+		switch (op) {
+
+			/* end of program or block */
+			case OP_END:
+
+				return INTERP_DONE;
+
+			/* stack */
+			case OP_POP:
+
+				DROP(1);
+				break;
+
+			case OP_DUP:
+
+				a = TOP();
+				PUSH(a);
+				break;
+
+			case OP_DUPX1:
+
+				a = PEEK(0);
+				b = PEEK(1);
+
+				/* swap the items, then push a copy */
+				PEEK(1) = a;
+				PEEK(0) = b;
+				PUSH(a);
+				break;
+
+			/* integer */
+			case OP_PUSHINT:
+
+				o = IMM_NEW(OBJECT_INT, OP_GETINT(pc));
+				pc += 4;
+
+				PUSH(o);
+				break;
+
+			/* string */
+			case OP_PUSHSTR:
+
+				/* shared constant (changing it changes a copy) */
+				o = STRING(pc);
+				pc += 4;
+
+				PUSH(o);
+				break;
+
+			/* variable access */
+			case OP_LOADNAME:
+
+				o = namesGet(v->ctx->nt, ATOM(pc));
+				pc += 4;
+
+				/* the object was not found */
+				if (o == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_UNDEFINEDNAME,
+							 "Undefined name");
+					goto error_pos;
+				}
+
+				PUSH(o);
+				break;
+
+			/* variable access by slot */
+			case OP_LOADSLOT: {
+
+				o = interpLoadSlot(v, pc);
+				pc += 8;
+
+				/* the object was not found */
+				if (o == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_UNDEFINEDNAME,
+							 "Undefined name");
+					goto error_pos;
+				}
+
+				PUSH(o);
+				break;
+			}
+
+			/* variable assignment by slot */
+			case OP_STORESLOT:
+
+				if (interpStoreSlot(v, ip) < 0)
+					goto error;
+
+				pc += 8;
+				break;
+
+			/* struct field access */
+			case OP_LOADFIELD:
+			case OP_LOADFIELDREF:
+
+				o = interpField(v, TOP(), pc, op == OP_LOADFIELDREF);
+				pc += 4;
+
+				if (o == NULL)
+					goto error_pos;
+
+				REPLACE(1, o);
+				break;
+
+			/* variable assignment */
+			case OP_STORENAME:
+			case OP_STOREFIELD: {
+
+				nameTable *nt = v->ctx->nt;
+				unsigned int idx = 0;
+				char *name = ATOM(pc);
+
+				/* struct */
+				if (op == OP_STOREFIELD) {
+
+					a = TOP();
+
+					/* not a struct */
+					if (IMM_IS(a) || (a->type & 0x3) != OBJECT_STRUCT || (a->type & OBJECT_ARRAY)) {
+
+						errorSet(ERROR_TYPE_RUNTIME,
+								 ERROR_CODE_ILLEGALOP,
+								 "Illegal operation");
+						goto error_pos;
+					}
+
+					/* struct pointer */
+					if ((a->type & OBJECT_POINTER) && (a = O_OBJ(O_PTR(a)->val)) == NULL) {
+
+						errorSet(ERROR_TYPE_RUNTIME,
+								 ERROR_CODE_INVALIDPTR,
+								 "Invalid pointer (null)");
+						goto error_pos;
+					}
+
+					nt = O_STRUCT(a)->nt;
+
+					/* field slot from the inline cache */
+					idx = vmFieldIndex(vmFieldEntry(v, pc - v->code, name), a, name);
+					a = (idx < nt->n_of_names)? nt->values[idx]: namesGet(nt, name);
+				}
+				else a = namesGet(nt, name);
+
+				pc += 4;
+				b = PEEK(op == OP_STOREFIELD);
+
+				/* not a value */
+				if (a == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_UNDEFINEDNAME,
+							 "Undefined name");
+					goto error_pos;
+				}
+
+				/* check types */
+				if (TYPEOF(a) != TYPEOF(b)) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Mismatched types");
+					goto error_pos;
+				}
+
+				/* immediates are stored inline in fields of instances (capacity 0), objects are shared with the field as they are with names */
+				if (nt->cap_names == 0 && idx < nt->n_of_names && IMM_IS(b)) {
+
+					if (!IMM_IS(a)) objectUnref(a);
+					nt->values[idx] = b;
+				}
+
+				else if (op == OP_STOREFIELD) namesSetAt(nt, idx, name, BOX(b));
+				else namesSet(nt, name, BOX(b));
+
+				DROP((op == OP_STOREFIELD)? 2: 1);
+				break;
+			}
+
+			/* getitem */
+			case OP_GETITEM:
+
+				b = PEEK(0);
+				a = PEEK(1);
+
+				/* dereference object if it is a pointer */
+				if (!IMM_IS(a) && (a->type & OBJECT_POINTER))
+					a = O_OBJ(O_PTR(a)->val);
+
+				/* no value */
+				if (a == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Pointer value is null");
+					goto error_pos;
+				}
+
+				/* not an array, index isn't an integer, or index is out of range */
+				if (IMM_IS(a) || !(a->type & OBJECT_ARRAY) || TYPEOF(b) != OBJECT_INT || INTOF(b) < 0 || INTOF(b) >= O_ARRAY(a)->n_len) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				/* get the item */
+				if (O_ARRAY(a)->a_type & OBJECT_POINTER) o = pointerobjectNew(a->type & 0x3, ((void **)O_ARRAY(a)->n_start)[INTOF(b)]);
+				else if (O_ARRAY(a)->a_type == OBJECT_INT) o = IMM_NEW(OBJECT_INT, ((int *)O_ARRAY(a)->n_start)[INTOF(b)]);
+				else if (O_ARRAY(a)->a_type == OBJECT_CHR) o = IMM_NEW(OBJECT_CHR, ((char *)O_ARRAY(a)->n_start)[INTOF(b)]);
+				else {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				REPLACE(2, o);
+				break;
+
+			/* setitem */
+			case OP_SETITEM:
+			case OP_CSETITEM:
+
+				a = PEEK(0);
+				b = PEEK(1);
+				c = PEEK(2);
+
+				/* dereference if it is a pointer (copying a constant array) */
+				if (!IMM_IS(a))
+					a = objectWritable(a);
+
+				/* no value */
+				if (a == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Pointer value is null");
+					goto error_pos;
+				}
+
+				/* not an array, index isn't an integer, index is out of range or types don't match */
+				if (IMM_IS(a) || !(a->type & OBJECT_ARRAY) || TYPEOF(c) != OBJECT_INT || INTOF(c) < 0 || INTOF(c) >= O_ARRAY(a)->n_len ||
+					(op == OP_SETITEM && (((a->type & ~(OBJECT_ARRAY)) != TYPEOF(b)) || ((a->type & OBJECT_POINTER) != (TYPEOF(b) & OBJECT_POINTER))))) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				/* set value */
+				if (O_ARRAY(a)->a_type & OBJECT_POINTER) ((void **)O_ARRAY(a)->n_start)[INTOF(c)] = O_PTR(b)->val;
+				else if (O_ARRAY(a)->a_type == OBJECT_INT) ((int *)O_ARRAY(a)->n_start)[INTOF(c)] = INTOF(b);
+				else if (O_ARRAY(a)->a_type == OBJECT_CHR) ((char *)O_ARRAY(a)->n_start)[INTOF(c)] = INTOF(b);
+
+				DROP(3);
+				break;
+
+			/* increment and decrement */
+			case OP_POSTINC:
+			case OP_POSTDEC:
+
+				a = TOP();
+
+				if (IMM_IS(a)) o = NULL;
+				else if (a->type == OBJECT_INT) o = IMM_NEW(OBJECT_INT, (op == OP_POSTINC)? O_INT(a)->val++: O_INT(a)->val--);
+				else if (a->type == OBJECT_CHR) o = IMM_NEW(OBJECT_CHR, (op == OP_POSTINC)? O_CHR(a)->val++: O_CHR(a)->val--);
+				else o = NULL;
+
+				/* not an int or chr variable */
+				if (o == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				REPLACE(1, o);
+				break;
+
+			/* unary operation */
+			case OP_UNOP: {
+
+				u8 uop = *pc++;
+				a = TOP();
+
+				/* negate */
+				if (uop == TOKEN_MINUS) {
+
+					o = interpOperation(a, IMM_NEW(OBJECT_INT, -1), TOKEN_MUL);
+
+					if (o == NULL || errorIsSet())
+						goto error_pos;
+				}
+
+				/* increment and decrement */
+				else if (uop == TOKEN_INC || uop == TOKEN_DEC) {
+
+					if (IMM_IS(a)) {
+
+						int n = IMM_VAL(a) + ((uop == TOKEN_INC)? 1: -1);
+
+						REPLACE(1, IMM_NEW(IMM_TYPE(a), (IMM_TYPE(a) == OBJECT_CHR)? (char)n: n));
+						break;
+					}
+
+					if (a->type == OBJECT_CHR) O_CHR(a)->val += (uop == TOKEN_INC)? 1: -1;
+					else O_INT(a)->val += (uop == TOKEN_INC)? 1: -1;
+					o = a;
+				}
+
+				/* '&' */
+				else if (uop == TOKEN_AMP) o = pointerobjectNew(TYPEOF(a), (void *)BOX(a));
+
+				/* '*' */
+				else if (uop == TOKEN_MUL) {
+
+					/* not a pointer */
+					if (IMM_IS(a) || !(a->type & OBJECT_POINTER) || (O_PTR(a)->val == NULL)) {
+
+						errorSet(ERROR_TYPE_RUNTIME,
+								 ERROR_CODE_ILLEGALOP,
+								 "Attempt to dereference a non-pointer");
+						goto error_pos;
+					}
+
+					o = O_OBJ(O_PTR(a)->val);
+				}
+
+				else o = a;
+
+				REPLACE(1, o);
+				break;
+			}
+
+			/* binary operation */
+			case OP_BINOP:
+
+				b = PEEK(0);
+				a = PEEK(1);
+
+				o = interpOperation(a, b, *pc++);
+
+				if (o == NULL || errorIsSet())
+					goto error_pos;
+
+				REPLACE(2, o);
+				break;
+
+			/* operations on ints and chrs */
+			case OP_ADDINT: INTOP(x + y); break;
+			case OP_SUBINT: INTOP(x - y); break;
+			case OP_MULINT: INTOP(x * y); break;
+			case OP_DIVINT: INTOP(x / y); break;
+			case OP_MODINT: INTOP(x % y); break;
+			case OP_EQINT: INTOP(x == y); break;
+			case OP_NEINT: INTOP(x != y); break;
+			case OP_LTINT: INTOP(x < y); break;
+			case OP_GTINT: INTOP(x > y); break;
+
+			case OP_NEGINT:
+
+				REPLACE(1, IMM_NEW(OBJECT_INT, -INTOF(TOP())));
+				break;
+
+			/* superinstructions */
+			case OP_INCSLOT:
+			case OP_DECSLOT:
+
+				if (interpIncSlot(v, ip) < 0)
+					goto error;
+
+				pc += 8;
+				break;
+
+			case OP_ADDIMM:
+
+				REPLACE(1, IMM_NEW(OBJECT_INT, INTOF(TOP()) + OP_GETINT(pc)));
+				pc += 4;
+				break;
+
+			case OP_CMPJMPF:
+
+				if ((st = interpCmpSlots(v, ip)) < 0)
+					goto error;
+
+				pc = st? ip + 22: v->code + OP_GETUINT(ip + 18);
+				break;
+
+			case OP_LOADSLOTF:
+
+				if (interpLoadSlotField(v, ip) < 0)
+					goto error;
+
+				pc += 12;
+				break;
+
+			/* new variable */
+			case OP_DECLARE:
+			case OP_DECLUNDEF: {
+
+				unsigned int tp_id = TYPEID(pc);
+				char *ob_name = ATOM(pc + 8);
+				u8 fl = pc[12];
+				unsigned int slot = OP_GETUINT(pc + 13);
+				pc += 17;
+
+				/* get object type from id */
+				u8 ob_type = typeGetId(tp_id);
+
+				if (ob_type == 0xFF) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Unknown type");
+					goto error_pos;
+				}
+
+				/* array and pointer */
+				ob_type |= ((fl & OP_DECL_ARRAY)? OBJECT_ARRAY: 0) | ((fl & OP_DECL_POINTER)? OBJECT_POINTER: 0);
+
+				/* value */
+				if (op == OP_DECLARE) {
+
+					o = TOP();
+
+					/* mismatched types */
+					if (!(fl & OP_DECL_CHECKED) && (ob_type & 0x3) != (TYPEOF(o) & 0x3)) {
+
+						errorSet(ERROR_TYPE_RUNTIME,
+								 ERROR_CODE_ILLEGALOP,
+								 "Mismatched types");
+						goto error_pos;
+					}
+
+					o = BOX(o);
+				}
+
+				/* array */
+				else if (ob_type & OBJECT_ARRAY) {
+
+					a = TOP();
+
+					/* array size should be an integer */
+					if (TYPEOF(a) != OBJECT_INT) {
+
+						errorSet(ERROR_TYPE_RUNTIME,
+								 ERROR_CODE_ILLEGALOP,
+								 "Array size must be an integer");
+						goto error_pos;
+					}
+
+					o = pointerobjectNew(ob_type & 0x3, (void *)arrayobjectNew(INTOF(a), ob_type & 0x3));
+				}
+
+				/* pointer */
+				else if (ob_type & OBJECT_POINTER) o = pointerobjectNew(ob_type & 0x3, NULL);
+
+				/* struct */
+				else if (ob_type == OBJECT_STRUCT) o = structobjectInstance(O_TYPE(typeobjectGetId(tp_id))->st);
+
+				/* int or char */
+				else o = intcharobjectNew(((ob_type & 0x3) != OBJECT_INT)? 1: 0, 0);
+
+				namesSetAt(v->ctx->nt, namesIndexAt(v->ctx->nt, slot, ob_name), ob_name, o);
+
+				/* value or array size */
+				if (op == OP_DECLARE || (ob_type & OBJECT_ARRAY)) DROP(1);
+				break;
+			}
+
+			/* jumps */
+			case OP_JMP:
+
+				pc = v->code + OP_GETUINT(pc);
+
+				/* loops that run often enough are compiled (the loop ends with this jump), or were compiled to c */
+				if ((jit_enabled || v->jit != NULL) && pc <= ip) {
+
+					jitFunc fn = jitEnter(v, pc, ip + 5, JIT_HOT_LOOP);
+
+					if (fn != NULL && (pc = fn(v)) == NULL)
+						goto error;
+				}
+				break;
+
+			case OP_JMPF:
+
+				a = TOP();
+
+				if ((TYPEOF(a) == OBJECT_INT) && (INTOF(a) == 0)) pc = v->code + OP_GETUINT(pc);
+				else pc += 4;
+
+				DROP(1);
+				break;
+
+			/* end of loop iteration */
+			case OP_LOOP:
+
+				if (interpLoopEnd(v, ip) < 0)
+					goto error;
+				break;
+
+			/* garbage collect after top level statement */
+			case OP_COLLECT:
+
+				vmCollect();
+				break;
+
+			/* function call */
+			case OP_CALL:
+			case OP_TAILCALL: {
+
+				int n = OP_GETINT(pc);
+				pc += 4;
+
+				/* box the function and arguments in place (the stack owns the boxes) */
+				for (int i = 0; i <= n; i++) {
+
+					if (IMM_IS(PEEK(i))) {
+
+						PEEK(i) = BOX(PEEK(i));
+						REF(PEEK(i));
+					}
+				}
+
+				object *f = PEEK(n);
+				object **ob_args = &PEEK(n - 1);
+
+				/* builtin and tree bytecode functions (arguments stay on the stack during the call, errors get the position of the call below) */
+				if (f->type != OBJECT_FUNC || O_FUNC(f)->is_builtin || O_FUNC(f)->fb_start == NULL || !IS_LINEAR(O_FUNC(f)->ov->bcflags)) {
+
+					o = vmCall(v, f, ob_args, n, 0, 0, NULL);
+
+					if (o == NULL || errorIsSet())
+						goto error;
+
+					REPLACE(n + 1, o);
+					break;
+				}
+
+				if (vmCallCheck(f, ob_args, n) < 0)
+					goto error;
+
+				/* the result of the call is returned, so the call can replace the current one */
+				if (op == OP_TAILCALL && interp_fp > fp && O_FUNC(f)->ov == v && O_FUNC(f)->rt_type == O_FUNC(fnc)->rt_type) {
+
+					/* names of the current call stay visible as they would be from a new call */
+					for (int i = 0; i < n; i++)
+						namesSet(v->ctx->nt, O_FUNC(f)->fa_names[i], ob_args[i]);
+
+					v->ctx->fn = O_FUNC(f)->fname;
+					v->ctx->sn = O_FUNC(f)->func_name;
+
+					objectRef(f);
+					objectUnref(interp_frames[interp_fp - 1].f);
+					interp_frames[interp_fp - 1].f = f;
+
+					DROP(interp_sp - base);
+				}
+
+				/* new call */
+				else {
+
+					if (interp_fp >= interp_fcap) {
+
+						interp_fcap = interp_fcap? interp_fcap * 2: 64;
+						interp_frames = (interpFrame *)realloc(interp_frames, sizeof(interpFrame) * interp_fcap);
+					}
+
+					/* save caller */
+					interpFrame *fr = &interp_frames[interp_fp++];
+
+					fr->v = v;
+					fr->pc = pc;
+					fr->fnc = fnc;
+					fr->base = base;
+					fr->n_of_args = n;
+					fr->f = f;
+					fr->ctx_old = O_FUNC(f)->ov->ctx;
+					objectRef(f);
+
+					/* set values for arguments */
+					context *fctx = contextPush(O_FUNC(f)->fname, O_FUNC(f)->func_name);
+					fctx->nt->parent = v->ctx->nt;
+
+					for (int i = 0; i < n; i++)
+						namesSet(fctx->nt, O_FUNC(f)->fa_names[i], ob_args[i]);
+
+					v = O_FUNC(f)->ov;
+					v->ctx = fctx;
+					base = interp_sp;
+				}
+
+				/* run function body */
+				fnc = f;
+				pc = O_FUNC(f)->fb_start;
+
+				if (VM_DEBUG) fprintf(debug_file, "[interp] called function '%s'.\n", O_FUNC(f)->func_name);
+
+				/* functions that are called often enough are compiled (the body ends where FUNCBODY jumps to), or were compiled to c */
+				if (jit_enabled || v->jit != NULL) {
+
+					jitFunc fn = jitEnter(v, pc, v->code + OP_GETUINT(pc - 4), JIT_HOT_CALL);
+
+					if (fn != NULL && (pc = fn(v)) == NULL)
+						goto error;
+				}
+				break;
+			}
+
+			/* return */
+			case OP_RETURN:
+			case OP_CRETURN:
+
+				a = TOP();
+
+				/* if we are not in a function */
+				if (fnc == NULL) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				/* check return type */
+				if (op == OP_RETURN && TYPEOF(a) != O_FUNC(fnc)->rt_type) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Mismatched types");
+					goto error_pos;
+				}
+
+				/* the return value keeps a reference for the caller */
+				o = a;
+				REF(o);
+				goto ret;
+
+			/* end of function */
+			case OP_LEAVE:
+
+				o = IMM_NEW(OBJECT_INT, 0);
+				goto ret;
+
+			/* function declaration */
+			case OP_FUNCDEC: {
+
+				unsigned int tp_id = TYPEID(pc);
+				char *fn_name = ATOM(pc + 8);
+				int is_p = pc[12];
+				int n_of_args = OP_GETINT(pc + 13);
+				pc += 17;
+
+				int err = 0; /* unknown argument type */
+
+				/* list of argument names and argument types */
+				char **arg_names = FUNC_ARGNAME_LIST(n_of_args + 1);
+				u8 *arg_types = FUNC_ARGTYPE_LIST(n_of_args + 1);
+
+				for (int i = 0; i < n_of_args; i++) {
+
+					/* argument name and type */
+					arg_names[i] = ATOM(pc + 8);
+					arg_types[i] = typeGetId(TYPEID(pc));
+
+					if (arg_types[i] == 0xFF) err = 1;
+					else arg_types[i] |= pc[12]? OBJECT_POINTER: 0;
+
+					pc += 13;
+				}
+
+				/* get return type */
+				u8 rt_type = typeGetId(tp_id);
+
+				if (rt_type == 0xFF || err) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 err? "Illegal operation": "Unknown type");
+
+					free(arg_names);
+					free(arg_types);
+					goto error_pos;
+				}
+
+				rt_type |= is_p? OBJECT_POINTER: 0;
+
+				/* create a function object */
+				o = functionobjectNew(fn_name, rt_type, arg_names, arg_types, n_of_args);
+				O_FUNC(o)->fname = v->ctx->fn;
+
+				namesSet(v->ctx->nt, fn_name, o);
+
+				/* debug info */
+				if (VM_DEBUG) fprintf(debug_file, "[interp] created function reference '%s'.\n", fn_name);
+
+				PUSH(o);
+				break;
+			}
+
+			/* function body */
+			case OP_FUNCBODY:
+
+				a = TOP();
+
+				/* not a function */
+				if (IMM_IS(a) || a->type != OBJECT_FUNC) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Illegal operation");
+					goto error_pos;
+				}
+
+				/* set values */
+				O_FUNC(a)->fb_start = pc + 4;
+				O_FUNC(a)->fb_n = 0;
+				O_FUNC(a)->ov = v;
+
+				/* skip body */
+				pc = v->code + OP_GETUINT(pc);
+				break;
+
+			/* extern */
+			case OP_EXTERN: {
+
+				/* set up scope */
+				nameTable *nt_old = v->ctx->nt;
+				v->ctx->nt = vmdctx->nt;
+
+				st = interpRun(v, pc + 4, fnc, &o);
+
+				/* restore scope */
+				v->ctx->nt = nt_old;
+
+				/* return from the current call */
+				if (st == INTERP_RETURN)
+					goto ret;
+
+				if (st != INTERP_DONE)
+					goto error;
+
+				pc = v->code + OP_GETUINT(pc);
+				break;
+			}
+
+			/* struct */
+			case OP_STRUCT: {
+
+				char *struct_name = ATOM(pc);
+
+				/* create struct context */
+				context *myctx = contextNew(v->ctx->fn, struct_name);
+				myctx->tp = CONTEXT_STRUCT;
+
+				context *octx = v->ctx;
+				v->ctx = myctx;
+
+				/* run struct body */
+				st = interpRun(v, pc + 8, NULL, res);
+
+				v->ctx = octx;
+
+				if (st != INTERP_DONE) {
+
+					contextFree(myctx);
+					goto error;
+				}
+
+				/* create struct */
+				o = structobjectNew(myctx, struct_name);
+
+				namesSet(v->ctx->nt, struct_name, o);
+				typeRegisterStruct(struct_name, o);
+
+				pc = v->code + OP_GETUINT(pc + 4);
+
+				PUSH(o);
+				break;
+			}
+
+			/* typedef */
+			case OP_TYPEDEF: {
+
+				int is_p = pc[0];
+				unsigned int tp_id = TYPEID(pc + 1);
+				char *otp = STR(pc + 5);
+				char *ntp = STR(pc + 9);
+				pc += 13;
+
+				/* get type */
+				u8 tp_type = typeGetId(tp_id);
+
+				if (tp_type == 0xFF) {
+
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Unknown type");
+					goto error_pos;
+				}
+
+				typeRegister(ntp, tp_type | (is_p? OBJECT_POINTER: 0));
+
+				/* debug */
+				if (VM_DEBUG) fprintf(debug_file, "[interp] created type '%s' based off of '%s'\n", ntp, otp);
+				break;
+			}
+
+			/* invalid instruction */
+			default:
+
+				errorSet(ERROR_TYPE_BYTECODE,
+						 ERROR_CODE_BYTECODEUNIMPL,
+						 "Invalid instruction");
+				goto error_pos;
+		}
+
+		if (step)
+			return INTERP_DONE;
+		continue;
+
+		/* return a referenced value from the current call */
+		ret:
+
+		DROP(interp_sp - base);
+
+		/* return to caller of interpRun */
+		if (interp_fp == fp) {
+
+			*res = BOX(o);
+			if (IMM_IS(o)) objectRef(*res);
+
+			return INTERP_RETURN;
+		}
+
+		/* return to calling code, replacing the call with its result */
+		interpFrame *fr = &interp_frames[--interp_fp];
+
+		contextPop(v->ctx);
+		v->ctx = fr->ctx_old;
+		objectUnref(fr->f);
+
+		v = fr->v;
+		pc = fr->pc;
+		fnc = fr->fnc;
+		base = fr->base;
+
+		DROP(fr->n_of_args + 1);
+		interp_stack[interp_sp++] = o;
+	}
+
+	/* errors that don't have a position yet are reported at the failing instruction */
+	error_pos:
+	error:
+
+	if (!errorHasPos()) {
+
+		unsigned int lineno, colno;
+		char *fname;
+
+		interpGetPos(v, ip, &lineno, &colno, &fname);
+		errorSetPos(lineno, colno, fname);
+	}
+
+	/* the stack is restored by the loop that ran the jit code */
+	if (step)
+		return INTERP_ERROR;
+
+	/* leave calls made by this loop */
+	while (interp_fp > fp) {
+
+		interpFrame *fr = &interp_frames[--interp_fp];
+
+		DROP(interp_sp - base);
+		contextPop(v->ctx);
+		v->ctx = fr->ctx_old;
+		objectUnref(fr->f);
+
+		v = fr->v;
+		base = fr->base;
+	}
+
+	/* restore stack */
+	DROP(interp_sp - base);
+	return INTERP_ERROR;
+}
+
+/* run code until the end of a block or a return */
+extern int interpRun(vm *v, unsigned char *pc, object *fnc, object **res) {
+
+	return interpLoop(v, pc, fnc, res, 0);
+}
+
+/* run an instruction for jit code */
+extern int interpJitStep(vm *v, unsigned char *ip) {
+
+	object *res = NULL;
+
+	return (interpLoop(v, ip, NULL, &res, 1) == INTERP_ERROR)? -1: 0;
+}
+
+/* call a function for jit code (calls of linear functions are made by the interpreter) */
+extern int interpJitCall(vm *v, unsigned char *ip) {
+
+	object *f = PEEK(OP_GETINT(ip + 1));
+
+	if (!IMM_IS(f) && f->type == OBJECT_FUNC && !O_FUNC(f)->is_builtin && O_FUNC(f)->fb_start != NULL && IS_LINEAR(O_FUNC(f)->ov->bcflags))
+		return -2;
+
+	return interpJitStep(v, ip);
+}
+
+/* get the operand stack for jit code (the addresses stay valid as the stack grows) */
+extern void interpJitStack(object ****stack, unsigned int **sp) {
+
+	*stack = &interp_stack;
+	*sp = &interp_sp;
+}
+
+/* push an integer for jit code */
+extern int interpJitPushInt(vm *v, unsigned char *ip) {
+
+	object *o = IMM_NEW(OBJECT_INT, OP_GETINT(ip + 1));
+
+	PUSH(o);
+	return 0;
+}
+
+/* push an int computed by compiled code */
+extern void interpJitPushVal(int val) {
+
+	object *o = IMM_NEW(OBJECT_INT, val);
+
+	PUSH(o);
+}
+
+/* discard top of stack for jit code */
+extern int interpJitPop(vm *v, unsigned char *ip) {
+
+	DROP(1);
+	return 0;
+}
+
+/* duplicate top of stack for jit code */
+extern int interpJitDup(vm *v, unsigned char *ip) {
+
+	object *a = TOP();
+
+	PUSH(a);
+	return 0;
+}
+
+/* push the value of a name by slot for jit code */
+extern int interpJitLoadSlot(vm *v, unsigned char *ip) {
+
+	object *o = interpLoadSlot(v, ip + 1);
+
+	if (o == NULL)
+		return interpError(v, ip, ERROR_CODE_UNDEFINEDNAME, "Undefined name");
+
+	PUSH(o);
+	return 0;
+}
+
+/* replace struct on top of stack with a field for jit code */
+extern int interpJitLoadField(vm *v, unsigned char *ip) {
+
+	object *o = interpField(v, TOP(), ip + 1, 0);
+
+	if (o == NULL)
+		return interpErrorPos(v, ip);
+
+	REPLACE(1, o);
+	return 0;
+}
+
+/* operation on ints and chrs for jit code */
+extern int interpJitIntOp(vm *v, unsigned char *ip) {
+
+	switch (*ip) {
+
+		case OP_ADDINT: INTOP(x + y); break;
+		case OP_SUBINT: INTOP(x - y); break;
+		case OP_MULINT: INTOP(x * y); break;
+		case OP_DIVINT: INTOP(x / y); break;
+		case OP_MODINT: INTOP(x % y); break;
+		case OP_EQINT: INTOP(x == y); break;
+		case OP_NEINT: INTOP(x != y); break;
+		case OP_LTINT: INTOP(x < y); break;
+		case OP_GTINT: INTOP(x > y); break;
+
+		case OP_NEGINT:
+
+			REPLACE(1, IMM_NEW(OBJECT_INT, -INTOF(TOP())));
+			break;
+
+		case OP_ADDIMM:
+
+			REPLACE(1, IMM_NEW(OBJECT_INT, INTOF(TOP()) + OP_GETINT(ip + 1)));
+			break;
+	}
+
+	return 0;
+}
+
+/* pop condition for jit code (0 if the jump is taken) */
+extern int interpJitJmpF(vm *v, unsigned char *ip) {
+
+	object *a = TOP();
+	int st = !((TYPEOF(a) == OBJECT_INT) && (INTOF(a) == 0));
+
+	DROP(1);
+	return st;
+}
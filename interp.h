@@ -0,0 +1,74 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* interp.h -- linear bytecode interpreter */
+#ifndef _INTERP_H
+#define _INTERP_H
+
+#include "vm.h"
+#include "opcode.h"
+
+/* results of interpRun */
+#define INTERP_DONE		0 /* reached end of program or block */
+#define INTERP_RETURN	1 /* returned from function */
+#define INTERP_ERROR	2 /* error is set */
+
+/* call of a function in linear bytecode (calls are made without recursing into interpRun) */
+typedef struct {
+	vm *v; /* vm of caller */
+	unsigned char *pc; /* return address */
+	object *fnc; /* function of caller */
+	unsigned int base; /* stack position of caller */
+	int n_of_args; /* number of arguments (replaced by the result along with the function) */
+	object *f; /* called function */
+	context *ctx_old; /* context of called function's vm before the call */
+} interpFrame;
+
+/* functions */
+extern void interpExec(vm *v); /* execute linear bytecode in a vm */
+extern int interpLoad(vm *v); /* read section offsets from header */
+extern char *interpAtom(vm *v, unsigned int off); /* intern a name from the string table */
+extern object *interpString(vm *v, unsigned int off); /* create the constant object of a string literal from the string table */
+extern unsigned int interpTypeId(vm *v, unsigned char *p); /* look up the type id of a type name and write it into the instruction */
+extern int interpRun(vm *v, unsigned char *pc, object *fnc, object **res); /* run code from pc until end of block or return */
+extern void interpGetPos(vm *v, unsigned char *pc, unsigned int *lineno, unsigned int *colno, char **fname); /* get source position of an instruction */
+extern object *interpLoadSlot(vm *v, unsigned char *p); /* get the value of a name by its slot and name operands (NULL if it doesn't exist) */
+extern object *interpField(vm *v, object *a, unsigned char *p, int ref); /* get a field of a struct by its name operand (NULL and error set if it can't) */
+extern int interpStoreSlot(vm *v, unsigned char *ip); /* assign the value on top of the stack to a name by slot (-1 and error set if it can't) */
+extern int interpIncSlot(vm *v, unsigned char *ip); /* increment or decrement a variable by slot (-1 and error set if it can't) */
+extern int interpLoadSlotField(vm *v, unsigned char *ip); /* push a field of a struct variable by slot (-1 and error set if it can't) */
+extern int interpCmpSlots(vm *v, unsigned char *ip); /* compare two variables by slot (1 if true, -1 and error set if they don't exist) */
+extern int interpLoopEnd(vm *v, unsigned char *ip); /* end of a loop iteration (-1 and error set on keyboard interrupt) */
+extern object *interpOperation(object *a, object *b, unsigned char op); /* binary operation on tagged or boxed values */
+extern int interpJitStep(vm *v, unsigned char *ip); /* run one instruction for jit code */
+extern int interpJitCall(vm *v, unsigned char *ip); /* call a function for jit code (-2 if it is left to the interpreter) */
+extern void interpJitStack(object ****stack, unsigned int **sp); /* get the operand stack for jit code */
+extern int interpJitPushInt(vm *v, unsigned char *ip); /* push an integer for jit code */
+extern void interpJitPushVal(int val); /* push an int computed by compiled code */
+extern int interpJitPop(vm *v, unsigned char *ip); /* discard top of stack for jit code */
+extern int interpJitDup(vm *v, unsigned char *ip); /* duplicate top of stack for jit code */
+extern int interpJitLoadSlot(vm *v, unsigned char *ip); /* push the value of a name by slot for jit code */
+extern int interpJitLoadField(vm *v, unsigned char *ip); /* replace struct on top of stack with a field for jit code */
+extern int interpJitIntOp(vm *v, unsigned char *ip); /* operation on ints and chrs for jit code */
+extern int interpJitJmpF(vm *v, unsigned char *ip); /* pop condition for jit code (0 if the jump is taken) */
+extern void interpFree(); /* free the operand and call stacks */
+
+#endif /* _INTERP_H */
@@ -0,0 +1,748 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * template jit: each instruction of a hot region becomes a call to the
+ * interpreter's code for it, so the native code only removes dispatch
+ * and keeps jumps inside the region native. int operations on tagged
+ * values and int variables found at their slot are written inline and
+ * only call the interpreter when that check fails. instructions that
+ * return, call linear functions or run nested blocks leave the native
+ * code and are run by the interpreter.
+ */
+#include "jit.h"
+#include "interp.h"
+#include "compiler.h"
+#include "error.h"
+#include "run.h"
+#include "intobject.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef JIT_SUPPORTED
+#include <sys/mman.h> /* mmap, mprotect */
+#include <sys/wait.h> /* waitpid */
+#include <unistd.h> /* fork, dup2 */
+#endif
+
+typedef unsigned char u8;
+
+extern int VM_DEBUG;
+extern FILE *debug_file;
+
+int jit_enabled = 0;
+
+#ifdef JIT_SUPPORTED
+
+/* machine code being written */
+typedef struct {
+	u8 *b; /* bytes */
+	unsigned int len; /* length */
+	unsigned int cap; /* capacity */
+} jitBuf;
+
+/* rel32 jump to fill in once all code is written */
+typedef struct {
+	unsigned int at; /* position of operand */
+	u8 *to; /* instruction jumped to (NULL = leave with an error) */
+	int leave; /* leave native code to run the instruction in the interpreter */
+} jitFixup;
+
+/* write bytes */
+static void jitPut(jitBuf *b, const void *p, unsigned int n) {
+
+	if (b->len + n > b->cap) {
+
+		while (b->len + n > b->cap)
+			b->cap = b->cap? b->cap * 2: 256;
+
+		b->b = (u8 *)realloc(b->b, b->cap);
+	}
+
+	memcpy(&b->b[b->len], p, n);
+	b->len += n;
+}
+
+/* write a 64 bit immediate */
+static void jitImm64(jitBuf *b, uint64_t x) {
+
+	jitPut(b, &x, 8);
+}
+
+/* write a jump instruction and remember its operand */
+static void jitJump(jitBuf *b, jitFixup **fx, unsigned int *n_fx, const char *op, unsigned int op_len, u8 *to, int leave) {
+
+	jitPut(b, op, op_len);
+
+	*fx = (jitFixup *)realloc(*fx, sizeof(jitFixup) * (*n_fx + 1));
+	(*fx)[*n_fx].at = b->len;
+	(*fx)[*n_fx].to = to;
+	(*fx)[(*n_fx)++].leave = leave;
+
+	jitPut(b, "\0\0\0\0", 4);
+}
+
+/* write a 32 bit displacement or immediate */
+static void jitImm32(jitBuf *b, int32_t x) {
+
+	jitPut(b, &x, 4);
+}
+
+/* label inside the code of one instruction */
+typedef struct {
+	unsigned int at[16]; /* positions of rel32 operands jumping to it */
+	unsigned int n; /* number of jumps */
+} jitLabel;
+
+/* write a jump to a label */
+static void jitTo(jitBuf *b, jitLabel *l, const char *op, unsigned int op_len) {
+
+	jitPut(b, op, op_len);
+	l->at[l->n++] = b->len;
+	jitPut(b, "\0\0\0\0", 4);
+}
+
+/* place a label at the end of the code */
+static void jitBind(jitBuf *b, jitLabel *l) {
+
+	for (unsigned int i = 0; i < l->n; i++) {
+
+		int32_t rel = (int32_t)b->len - (int32_t)(l->at[i] + 4);
+		memcpy(&b->b[l->at[i]], &rel, 4);
+	}
+
+	l->n = 0;
+}
+
+/* call the interpreter's code of an instruction */
+static void jitCall(jitBuf *b, u8 *p, jitHelper fn) {
+
+	/* mov rdi, rbx; mov rsi, ip; mov rax, fn; call rax */
+	jitPut(b, "\x48\x89\xDF\x48\xBE", 5);
+	jitImm64(b, (uintptr_t)p);
+	jitPut(b, "\x48\xB8", 2);
+	jitImm64(b, (uintptr_t)fn);
+	jitPut(b, "\xFF\xD0", 2);
+}
+
+/* get the value of the first (rax into esi) or second (rdx into edi) operand of an int operation */
+static void jitIntOperand(jitBuf *b, int second, jitLabel *slow) {
+
+	jitLabel boxed = {{0}, 0}, done = {{0}, 0};
+
+	/* test al/dl, 1; jz boxed; mov rsi/rdi, rax/rdx; sar rsi/rdi, 32; jmp done */
+	if (second) jitPut(b, "\xF6\xC2\x01", 3);
+	else jitPut(b, "\xA8\x01", 2);
+
+	jitTo(b, &boxed, "\x0F\x84", 2);
+	jitPut(b, second? "\x48\x89\xD7\x48\xC1\xFF\x20": "\x48\x89\xC6\x48\xC1\xFE\x20", 7);
+	jitTo(b, &done, "\xE9", 1);
+	jitBind(b, &boxed);
+
+	/* cmp byte [reg + type], OBJECT_INT; jne slow */
+	jitPut(b, second? "\x80\xBA": "\x80\xB8", 2);
+	jitImm32(b, offsetof(object, type));
+	jitPut(b, "\x00", 1);
+	jitTo(b, slow, "\x0F\x85", 2);
+
+	/* cmp dword [reg + refcnt], 2; jb slow (dropping the last reference frees it) */
+	jitPut(b, second? "\x83\xBA": "\x83\xB8", 2);
+	jitImm32(b, offsetof(object, refcnt));
+	jitPut(b, "\x02", 1);
+	jitTo(b, slow, "\x0F\x82", 2);
+
+	/* mov esi/edi, [reg + val] */
+	jitPut(b, second? "\x8B\xBA": "\x8B\xB0", 2);
+	jitImm32(b, offsetof(intobject, val));
+	jitBind(b, &done);
+}
+
+/* drop the stack's reference to an operand of an int operation */
+static void jitIntRelease(jitBuf *b, int second) {
+
+	jitLabel imm = {{0}, 0};
+
+	/* test al/dl, 1; jnz imm; dec dword [reg + refcnt] */
+	if (second) jitPut(b, "\xF6\xC2\x01", 3);
+	else jitPut(b, "\xA8\x01", 2);
+
+	jitTo(b, &imm, "\x0F\x85", 2);
+	jitPut(b, second? "\xFF\x8A": "\xFF\x88", 2);
+	jitImm32(b, offsetof(object, refcnt));
+	jitBind(b, &imm);
+}
+
+/* get an int variable by its slot into rsi (names of the scope in rax) */
+static void jitSlotInt(jitBuf *b, vm *v, u8 *p, jitLabel *slow) {
+
+	unsigned int off = OP_GETUINT(p + 4);
+	char *name = (v->atoms[off] != NULL)? v->atoms[off]: interpAtom(v, off);
+
+	/* mov rdx, p; mov edx, [rdx]; bswap edx (the slot is rewritten as it moves) */
+	jitPut(b, "\x48\xBA", 2);
+	jitImm64(b, (uintptr_t)p);
+	jitPut(b, "\x8B\x12\x0F\xCA", 4);
+
+	/* cmp edx, [rax + n_of_names]; jae slow */
+	jitPut(b, "\x3B\x90", 2);
+	jitImm32(b, offsetof(nameTable, n_of_names));
+	jitTo(b, slow, "\x0F\x83", 2);
+
+	/* mov rsi, [rax + names]; mov rdi, name; cmp [rsi + rdx * 8], rdi; jne slow */
+	jitPut(b, "\x48\x8B\xB0", 3);
+	jitImm32(b, offsetof(nameTable, names));
+	jitPut(b, "\x48\xBF", 2);
+	jitImm64(b, (uintptr_t)name);
+	jitPut(b, "\x48\x39\x3C\xD6", 4);
+	jitTo(b, slow, "\x0F\x85", 2);
+
+	/* mov rsi, [rax + values]; mov rsi, [rsi + rdx * 8] */
+	jitPut(b, "\x48\x8B\xB0", 3);
+	jitImm32(b, offsetof(nameTable, values));
+	jitPut(b, "\x48\x8B\x34\xD6", 4);
+
+	/* test rsi, rsi; jz slow; test sil, 1; jnz slow */
+	jitPut(b, "\x48\x85\xF6", 3);
+	jitTo(b, slow, "\x0F\x84", 2);
+	jitPut(b, "\x40\xF6\xC6\x01", 4);
+	jitTo(b, slow, "\x0F\x85", 2);
+
+	/* cmp byte [rsi + type], OBJECT_INT; jne slow */
+	jitPut(b, "\x80\xBE", 2);
+	jitImm32(b, offsetof(object, type));
+	jitPut(b, "\x00", 1);
+	jitTo(b, slow, "\x0F\x85", 2);
+}
+
+/* write the code of an int operation for when its operands are ints, the code after it is the interpreter's for other values */
+static void jitInline(jitBuf *b, vm *v, u8 *p, jitLabel *done) {
+
+	jitLabel slow = {{0}, 0};
+	object ***stack;
+	unsigned int *sp;
+
+	interpJitStack(&stack, &sp);
+
+	switch (*p) {
+
+		case OP_ADDINT:
+		case OP_SUBINT:
+		case OP_MULINT:
+		case OP_DIVINT:
+		case OP_MODINT:
+		case OP_EQINT:
+		case OP_NEINT:
+		case OP_LTINT:
+		case OP_GTINT:
+		case OP_NEGINT:
+		case OP_ADDIMM: {
+
+			int unary = (*p == OP_NEGINT || *p == OP_ADDIMM);
+
+			/* mov r8, &stack; mov r8, [r8]; mov r9, &sp; mov ecx, [r9] */
+			jitPut(b, "\x49\xB8", 2);
+			jitImm64(b, (uintptr_t)stack);
+			jitPut(b, "\x4D\x8B\x00\x49\xB9", 5);
+			jitImm64(b, (uintptr_t)sp);
+			jitPut(b, "\x41\x8B\x09", 3);
+
+			/* mov rax, [r8 + rcx * 8 - 8] for one operand, mov rax, [r8 + rcx * 8 - 16]; mov rdx, [r8 + rcx * 8 - 8] for two */
+			if (unary) jitPut(b, "\x49\x8B\x44\xC8\xF8", 5);
+			else jitPut(b, "\x49\x8B\x44\xC8\xF0\x49\x8B\x54\xC8\xF8", 10);
+
+			/* check both operands before changing anything */
+			jitIntOperand(b, 0, &slow);
+			if (!unary) jitIntOperand(b, 1, &slow);
+
+			jitIntRelease(b, 0);
+			if (!unary) jitIntRelease(b, 1);
+
+			/* mov eax, esi */
+			jitPut(b, "\x89\xF0", 2);
+
+			switch (*p) {
+
+				case OP_ADDINT: jitPut(b, "\x01\xF8", 2); break; /* add eax, edi */
+				case OP_SUBINT: jitPut(b, "\x29\xF8", 2); break; /* sub eax, edi */
+				case OP_MULINT: jitPut(b, "\x0F\xAF\xC7", 3); break; /* imul eax, edi */
+				case OP_DIVINT: jitPut(b, "\x99\xF7\xFF", 3); break; /* cdq; idiv edi */
+				case OP_MODINT: jitPut(b, "\x99\xF7\xFF\x89\xD0", 5); break; /* cdq; idiv edi; mov eax, edx */
+				case OP_EQINT: jitPut(b, "\x39\xFE\x0F\x94\xC0\x0F\xB6\xC0", 8); break; /* cmp esi, edi; sete al; movzx eax, al */
+				case OP_NEINT: jitPut(b, "\x39\xFE\x0F\x95\xC0\x0F\xB6\xC0", 8); break; /* setne */
+				case OP_LTINT: jitPut(b, "\x39\xFE\x0F\x9C\xC0\x0F\xB6\xC0", 8); break; /* setl */
+				case OP_GTINT: jitPut(b, "\x39\xFE\x0F\x9F\xC0\x0F\xB6\xC0", 8); break; /* setg */
+				case OP_NEGINT: jitPut(b, "\xF7\xD8", 2); break; /* neg eax */
+
+				/* add eax, imm */
+				case OP_ADDIMM:
+
+					jitPut(b, "\x05", 1);
+					jitImm32(b, OP_GETINT(p + 1));
+					break;
+			}
+
+			/* shl rax, 32; or rax, tag */
+			jitPut(b, "\x48\xC1\xE0\x20\x48\x83\xC8", 7);
+			jitPut(b, &(u8){(OBJECT_INT << 1) | 1}, 1);
+
+			/* mov [r8 + rcx * 8 - 8], rax for one operand, mov [r8 + rcx * 8 - 16], rax; dec ecx; mov [r9], ecx for two */
+			if (unary) jitPut(b, "\x49\x89\x44\xC8\xF8", 5);
+			else jitPut(b, "\x49\x89\x44\xC8\xF0\xFF\xC9\x41\x89\x09", 10);
+
+			break;
+		}
+
+		case OP_INCSLOT:
+		case OP_DECSLOT:
+
+			/* mov rax, [rbx + ctx]; mov rax, [rax + nt] */
+			jitPut(b, "\x48\x8B\x83", 3);
+			jitImm32(b, offsetof(vm, ctx));
+			jitPut(b, "\x48\x8B\x80", 3);
+			jitImm32(b, offsetof(context, nt));
+
+			jitSlotInt(b, v, p + 1, &slow);
+
+			/* add dword [rsi + val], 1 or -1 */
+			jitPut(b, "\x83\x86", 2);
+			jitImm32(b, offsetof(intobject, val));
+			jitPut(b, (*p == OP_INCSLOT)? "\x01": "\xFF", 1);
+			break;
+
+		case OP_CMPJMPF:
+
+			/* mov rax, [rbx + ctx]; mov rax, [rax + nt] */
+			jitPut(b, "\x48\x8B\x83", 3);
+			jitImm32(b, offsetof(vm, ctx));
+			jitPut(b, "\x48\x8B\x80", 3);
+			jitImm32(b, offsetof(context, nt));
+
+			/* mov r10d, [rsi + val] of the first; mov r11d, [rsi + val] of the second; cmp r10d, r11d */
+			jitSlotInt(b, v, p + 2, &slow);
+			jitPut(b, "\x44\x8B\x96", 3);
+			jitImm32(b, offsetof(intobject, val));
+			jitSlotInt(b, v, p + 10, &slow);
+			jitPut(b, "\x44\x8B\x9E", 3);
+			jitImm32(b, offsetof(intobject, val));
+			jitPut(b, "\x45\x39\xDA", 3);
+
+			/* setcc al; movzx eax, al (1 if true) */
+			switch (p[1]) {
+
+				case OP_EQINT: jitPut(b, "\x0F\x94\xC0", 3); break;
+				case OP_NEINT: jitPut(b, "\x0F\x95\xC0", 3); break;
+				case OP_LTINT: jitPut(b, "\x0F\x9C\xC0", 3); break;
+				default: jitPut(b, "\x0F\x9F\xC0", 3); break;
+			}
+
+			jitPut(b, "\x0F\xB6\xC0", 3);
+
+			/* jmp done (the result is the helper's) */
+			jitTo(b, done, "\xE9", 1);
+			jitBind(b, &slow);
+			return;
+
+		default:
+			return;
+	}
+
+	/* xor eax, eax; jmp done */
+	jitPut(b, "\x31\xC0", 2);
+	jitTo(b, done, "\xE9", 1);
+	jitBind(b, &slow);
+}
+
+#endif
+
+/* function and its name */
+#define JIT_OP(f) ((jitOp){f, #f})
+
+/* get the code of an instruction */
+extern jitOp jitOpOf(unsigned char op) {
+
+	switch (op) {
+
+		case OP_PUSHINT: return JIT_OP(interpJitPushInt);
+		case OP_POP: return JIT_OP(interpJitPop);
+		case OP_DUP: return JIT_OP(interpJitDup);
+		case OP_LOADSLOT: return JIT_OP(interpJitLoadSlot);
+		case OP_LOADFIELD: return JIT_OP(interpJitLoadField);
+		case OP_LOADSLOTF: return JIT_OP(interpLoadSlotField);
+		case OP_STORESLOT: return JIT_OP(interpStoreSlot);
+		case OP_INCSLOT: return JIT_OP(interpIncSlot);
+		case OP_DECSLOT: return JIT_OP(interpIncSlot);
+		case OP_JMPF: return JIT_OP(interpJitJmpF);
+		case OP_CMPJMPF: return JIT_OP(interpCmpSlots);
+		case OP_CALL: return JIT_OP(interpJitCall);
+		case OP_LOOP: return JIT_OP(interpLoopEnd);
+
+		case OP_ADDINT:
+		case OP_SUBINT:
+		case OP_MULINT:
+		case OP_DIVINT:
+		case OP_MODINT:
+		case OP_EQINT:
+		case OP_NEINT:
+		case OP_LTINT:
+		case OP_GTINT:
+		case OP_NEGINT:
+		case OP_ADDIMM:
+
+			return JIT_OP(interpJitIntOp);
+
+		/* returns, jumps out of the code and nested blocks */
+		case OP_END:
+		case OP_JMP:
+		case OP_RETURN:
+		case OP_CRETURN:
+		case OP_LEAVE:
+		case OP_TAILCALL:
+		case OP_FUNCBODY:
+		case OP_EXTERN:
+		case OP_STRUCT:
+
+			return JIT_OP(NULL);
+	}
+
+	/* everything else runs through the interpreter loop */
+	return (op < OP_COUNT)? JIT_OP(interpJitStep): JIT_OP(NULL);
+}
+
+/* check if a region of code contains a loop */
+extern int jitHasLoop(unsigned char *code, unsigned char *start, unsigned char *end) {
+
+	for (u8 *p = start; p < end && *p < OP_COUNT; p += compilerOpLen(p)) {
+
+		if (*p == OP_JMP && code + OP_GETUINT(p + 1) >= start && code + OP_GETUINT(p + 1) <= p)
+			return 1;
+	}
+
+	return 0;
+}
+
+/* add native code of a region that was compiled ahead of time */
+extern void jitAdd(vm *v, unsigned int pos, jitFunc fn) {
+
+	if (v->jit == NULL)
+		v->jit = calloc(1, sizeof(jit));
+
+	jitEntry *e = &((jit *)v->jit)->entries[pos & (JIT_TABLE - 1)];
+
+	/* the region is left to the interpreter if its entry is taken */
+	if (e->fn == NULL) {
+
+		e->pos = pos + 1;
+		e->fn = fn;
+	}
+}
+
+/* count an entry into a region of code and get its native code once it is hot */
+extern jitFunc jitEnter(vm *v, unsigned char *start, unsigned char *end, unsigned int hot) {
+
+	if (v->jit == NULL)
+		v->jit = calloc(1, sizeof(jit));
+
+	unsigned int pos = (unsigned int)(start - v->code);
+	jitEntry *e = &((jit *)v->jit)->entries[pos & (JIT_TABLE - 1)];
+
+	/* take the entry over unless its region was compiled */
+	if (e->pos != pos + 1) {
+
+		if (e->fn != NULL)
+			return NULL;
+
+		e->pos = pos + 1;
+		e->count = 0;
+		e->failed = 0;
+	}
+
+	/* without -jit only regions compiled to c are entered */
+	if (e->fn != NULL || e->failed || !jit_enabled || ++e->count < hot)
+		return e->fn;
+
+	e->fn = jitCompile(v, start, end);
+	e->failed = (e->fn == NULL);
+
+	return e->fn;
+}
+
+/* compile a region of code */
+extern jitFunc jitCompile(vm *v, unsigned char *start, unsigned char *end) {
+
+#ifdef JIT_SUPPORTED
+	/* code without a loop leaves at its first call or return, entering it costs more than the dispatch it saves */
+	if (!jitHasLoop(v->code, start, end))
+		return NULL;
+
+	unsigned int n = (unsigned int)(end - start);
+	int *at = (int *)malloc(sizeof(int) * n); /* native position of each instruction */
+
+	jitBuf b = {NULL, 0, 0};
+	jitFixup *fx = NULL;
+	unsigned int n_fx = 0;
+
+	for (unsigned int i = 0; i < n; i++)
+		at[i] = -1;
+
+	/* push rbx; mov rbx, rdi (rbx keeps the vm, the push aligns the stack for calls) */
+	jitPut(&b, "\x53\x48\x89\xFB", 4);
+
+	u8 *p = start;
+	while (p < end) {
+
+		jitHelper fn = jitOpOf(*p).fn;
+		at[p - start] = b.len;
+
+		/* jmp to target */
+		if (*p == OP_JMP) jitJump(&b, &fx, &n_fx, "\xE9", 1, v->code + OP_GETUINT(p + 1), 0);
+
+		/* leave for the interpreter */
+		else if (fn == NULL) {
+
+			jitJump(&b, &fx, &n_fx, "\xE9", 1, p, 1);
+
+			/* length is unknown */
+			if (*p >= OP_COUNT)
+				break;
+		}
+
+		else {
+
+			jitLabel done = {{0}, 0};
+
+			/* int operations run inline and call the interpreter only for other values */
+			jitInline(&b, v, p, &done);
+			jitCall(&b, p, fn);
+			jitBind(&b, &done);
+
+			/* cmp eax, -2; je leave (call of a linear function) */
+			if (*p == OP_CALL) {
+
+				jitPut(&b, "\x83\xF8\xFE", 3);
+				jitJump(&b, &fx, &n_fx, "\x0F\x84", 2, p, 1);
+			}
+
+			/* test eax, eax */
+			jitPut(&b, "\x85\xC0", 2);
+
+			/* jz target; js error */
+			if (*p == OP_JMPF || *p == OP_CMPJMPF) {
+
+				jitJump(&b, &fx, &n_fx, "\x0F\x84", 2, v->code + OP_GETUINT(p + ((*p == OP_JMPF)? 1: 18)), 0);
+				jitJump(&b, &fx, &n_fx, "\x0F\x88", 2, NULL, 0);
+			}
+
+			/* jnz error */
+			else jitJump(&b, &fx, &n_fx, "\x0F\x85", 2, NULL, 0);
+		}
+
+		p += compilerOpLen(p);
+	}
+
+	/* end of region */
+	if (p >= end)
+		jitJump(&b, &fx, &n_fx, "\xE9", 1, end, 1);
+
+	/* exits back to the interpreter (one per instruction it continues at) */
+	unsigned int code_len = b.len;
+	unsigned int *exits = (unsigned int *)calloc(n_fx, sizeof(unsigned int));
+
+	for (unsigned int i = 0; i < n_fx; i++) {
+
+		unsigned int to;
+
+		/* native jump */
+		if (fx[i].to != NULL && !fx[i].leave && fx[i].to >= start && fx[i].to < end && at[fx[i].to - start] >= 0)
+			to = at[fx[i].to - start];
+
+		else {
+
+			/* reuse an exit */
+			unsigned int j;
+			for (j = 0; j < i; j++) {
+
+				if (exits[j] && fx[j].to == fx[i].to)
+					break;
+			}
+
+			if (j < i) to = exits[j];
+			else {
+
+				to = b.len;
+
+				/* mov rax, pc (xor eax, eax for errors); pop rbx; ret */
+				if (fx[i].to == NULL) jitPut(&b, "\x31\xC0", 2);
+				else {
+
+					jitPut(&b, "\x48\xB8", 2);
+					jitImm64(&b, (uintptr_t)fx[i].to);
+				}
+
+				jitPut(&b, "\x5B\xC3", 2);
+			}
+
+			exits[i] = to;
+		}
+
+		int32_t rel = (int32_t)to - (int32_t)(fx[i].at + 4);
+		memcpy(&b.b[fx[i].at], &rel, 4);
+	}
+
+	free(exits);
+	free(fx);
+	free(at);
+
+	/* copy into executable memory */
+	void *mem = mmap(NULL, b.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mem == MAP_FAILED) {
+
+		free(b.b);
+		return NULL;
+	}
+
+	memcpy(mem, b.b, b.len);
+
+	if (mprotect(mem, b.len, PROT_READ | PROT_EXEC) < 0) {
+
+		munmap(mem, b.len);
+		free(b.b);
+		return NULL;
+	}
+
+	/* keep mapping until the vm is freed */
+	jitCode *jc = (jitCode *)malloc(sizeof(jitCode));
+
+	jc->mem = mem;
+	jc->size = b.len;
+	jc->next = ((jit *)v->jit)->code;
+	((jit *)v->jit)->code = jc;
+
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[jit] compiled %08x-%08x to %u bytes (%u for exits)\n", (unsigned int)(start - v->code), (unsigned int)(end - v->code), b.len, b.len - code_len);
+
+	free(b.b);
+	return (jitFunc)mem;
+#else
+	return NULL;
+#endif
+}
+
+/* free native code of a vm */
+extern void jitFree(vm *v) {
+
+	if (v->jit == NULL)
+		return;
+
+#ifdef JIT_SUPPORTED
+	jitCode *jc = ((jit *)v->jit)->code;
+
+	while (jc != NULL) {
+
+		jitCode *next = jc->next;
+
+		munmap(jc->mem, jc->size);
+		free(jc);
+
+		jc = next;
+	}
+#endif
+
+	free(v->jit);
+	v->jit = NULL;
+}
+
+/* run a file with and without the jit, compare what they print and pass on the output of the jit */
+extern int jitCheck(char *fname, int bc_mode) {
+
+#ifdef JIT_SUPPORTED
+	FILE *out[2];
+	int status[2];
+
+	for (int i = 0; i < 2; i++) {
+
+		out[i] = tmpfile();
+
+		if (out[i] == NULL) {
+
+			fprintf(stderr, "Could not create a file for the JIT check!\n");
+			return -1;
+		}
+
+		fflush(stdout);
+		fflush(stderr);
+
+		pid_t pid = fork();
+
+		/* run with output going to the file */
+		if (pid == 0) {
+
+			dup2(fileno(out[i]), 1);
+			dup2(fileno(out[i]), 2);
+
+			jit_enabled = i;
+			run(fname, bc_mode);
+
+			exit(errorIsSet()? EXIT_FAILURE: EXIT_SUCCESS);
+		}
+
+		if (pid < 0 || waitpid(pid, &status[i], 0) < 0) {
+
+			fprintf(stderr, "Could not run '%s' for the JIT check!\n", fname);
+			return -1;
+		}
+	}
+
+	/* compare output */
+	int same = (status[0] == status[1]);
+	int c0, c1;
+
+	rewind(out[0]);
+	rewind(out[1]);
+
+	do {
+
+		c0 = fgetc(out[0]);
+		c1 = fgetc(out[1]);
+
+		if (c0 != c1) same = 0;
+		if (c1 != EOF) putchar(c1);
+
+	} while (c0 != EOF || c1 != EOF);
+
+	fclose(out[0]);
+	fclose(out[1]);
+	fflush(stdout);
+
+	if (!same) {
+
+		fprintf(stderr, "JIT check failed: '%s' behaves differently with -jit\n", fname);
+		return -1;
+	}
+
+	return (WIFEXITED(status[1]) && WEXITSTATUS(status[1]) == EXIT_SUCCESS)? 0: -1;
+#else
+	fprintf(stderr, "JIT is not supported on this platform\n");
+	return (run(fname, bc_mode) <= -1 || errorIsSet())? -1: 0;
+#endif
+}
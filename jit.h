@@ -0,0 +1,85 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* jit.h -- template jit for hot loops and functions in linear bytecode */
+#ifndef _JIT_H
+#define _JIT_H
+
+#include "vm.h"
+#include <stddef.h> /* size_t */
+
+/* native code is only generated for x86-64 linux, -jit does nothing elsewhere */
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED
+#endif
+
+/* times a loop jumps back or a function is called before it is compiled */
+#define JIT_HOT_LOOP 64
+#define JIT_HOT_CALL 16
+
+/* number of regions counted per vm (power of two) */
+#define JIT_TABLE 256
+
+/* native code of a region, returns the instruction the interpreter continues at (NULL if an error is set) */
+typedef unsigned char *(*jitFunc)(vm *v);
+
+/* code of one instruction for native code (returns -1 if an error is set, conditional jumps return 0 to jump) */
+typedef int (*jitHelper)(vm *v, unsigned char *ip);
+
+/* how an instruction is run by native code */
+typedef struct {
+	jitHelper fn; /* function that runs it (NULL if native code leaves to run it in the interpreter) */
+	char *name; /* name of function */
+} jitOp;
+
+/* region of code counted by the jit */
+typedef struct {
+	unsigned int pos; /* position of the first instruction in the code plus one (0 = unused) */
+	unsigned int count; /* times the region was entered */
+	jitFunc fn; /* native code (NULL until the region is hot) */
+	int failed; /* region could not be compiled */
+} jitEntry;
+
+/* executable memory holding native code */
+typedef struct jitCode {
+	void *mem; /* mapping */
+	size_t size; /* size of mapping */
+	struct jitCode *next; /* next mapping */
+} jitCode;
+
+/* jit state of a vm */
+typedef struct {
+	jitEntry entries[JIT_TABLE]; /* regions by position */
+	jitCode *code; /* native code of compiled regions */
+} jit;
+
+extern int jit_enabled; /* compile hot code (-jit) */
+
+/* functions */
+extern jitOp jitOpOf(unsigned char op); /* get how an instruction is run by native code */
+extern int jitHasLoop(unsigned char *code, unsigned char *start, unsigned char *end); /* check if a region of code contains a loop */
+extern void jitAdd(vm *v, unsigned int pos, jitFunc fn); /* add native code of a region that was compiled ahead of time */
+extern jitFunc jitEnter(vm *v, unsigned char *start, unsigned char *end, unsigned int hot); /* count an entry into a region of code and get its native code once it is hot */
+extern jitFunc jitCompile(vm *v, unsigned char *start, unsigned char *end); /* compile a region of code (NULL if it can't be) */
+extern void jitFree(vm *v); /* free native code of a vm */
+extern int jitCheck(char *fname, int bc_mode); /* run a file with and without the jit and compare the output */
+
+#endif /* _JIT_H */
@@ -28,7 +28,7 @@
 
 #include "mango.h"
 
-char *prog_name; /* program name */
+extern char *prog_name; /* program name */
 extern int is_at_end;
 extern FILE *debug_file;
 
@@ -42,6 +42,7 @@ static void endHandle() {
 	vmFreeAll();
 	mangodlCloseAll();
 	objectFreeAll();
+	namesFreeAtoms();
 	argparse_close_debug_file();
 }
 
@@ -99,8 +100,13 @@ int main(int argc, char **argv) {
 	lib_fnames = &(argpfv[1]);
 	lib_fnames_len = (argpfc - 1);
 
+	/* run file with and without the jit */
+	if (argparse_get_flag(FLAG_JITCHECK))
+		return jitCheck(argpfv[0], bc_mode);
+
 	/* run file */
-	run(argpfv[0], bc_mode);
+	if (run(argpfv[0], bc_mode) < 0)
+		return -1;
 
 	/* error */
 	if (errorIsSet())
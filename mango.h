@@ -68,12 +68,17 @@
 
 #if HAS_VM == 1 /* bytecode virtual machine */
 #include "vm.h"
+#include "interp.h"
+#include "jit.h"
 #include "context.h"
 #include "typedef.h"
 #endif
 
 #if HAS_BYTECODE == 1 /* bytecode compiler */
 #include "bytecode.h"
+#include "compiler.h"
+#include "check.h"
+#include "aot.h"
 #endif
 
 #if HAS_NAMES == 1 /* variable name system */
@@ -84,7 +84,6 @@ extern int mangodlOpen(object *s, char *name) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_NOFILE,
 				 strerror(errno));
-		errorSetPos(s->lineno, s->colno, s->fname);
 		return -1;
 	}
 
@@ -104,7 +103,6 @@ extern int mangodlOpen(object *s, char *name) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_NOFILE,
 				 dlerror());
-		errorSetPos(s->lineno, s->colno, s->fname);
 		d->op = 0;
 		return -1;
 	}
@@ -122,7 +120,6 @@ extern int mangodlOpen(object *s, char *name) {
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_NOFILE,
 					 "Failed to locate symbol");
-			errorSetPos(s->lineno, s->colno, s->fname);
 
 			/* close lib */
 			dlclose(d->dl);
@@ -191,7 +188,6 @@ extern int mangodlOpen(object *s, char *name) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_NOFILE,
 				 "Failed to find 'mangodl_init' function");
-		errorSetPos(s->lineno, s->colno, s->fname);
 
 		/* close lib */
 		dlclose(d->dl);
@@ -246,7 +242,6 @@ extern mangodlobject *mangodlGet(object *s) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_INVALIDTYPE,
 				 "Index must be integer");
-		errorSetPos(s->lineno, s->colno, s->fname);
 		return NULL;
 	}
 
@@ -256,7 +251,6 @@ extern mangodlobject *mangodlGet(object *s) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_INVALIDVALUE,
 				 "Invalid index");
-		errorSetPos(s->lineno, s->colno, s->fname);
 		return NULL;
 	}
 
@@ -273,7 +267,6 @@ extern object *mangodlSym(mangodlobject *d, object *s) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_INVALIDTYPE,
 				 "Symbol name must be a string");
-		errorSetPos(s->lineno, s->colno, s->fname);
 		return NULL;
 	}
 
@@ -286,7 +279,6 @@ extern object *mangodlSym(mangodlobject *d, object *s) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_UNDEFINEDNAME,
 				 "Failed to locate symbol");
-		errorSetPos(s->lineno, s->colno, s->fname);
 		return NULL;
 	}
 
@@ -30,12 +30,153 @@
 
 /* forward declarations */
 extern object *objectCopy(object *);
+extern void objectRef(object *);
+extern void objectUnref(object *);
 extern int DEBUG;
 extern FILE *debug_file;
 
 int is_at_end = 0;
 static int id = 0;
 
+/* interned names */
+static char **atoms = NULL; /* open addressing table */
+static unsigned int n_of_atoms = 0;
+static unsigned int cap_atoms = 0;
+
+/* hash a string (fnv-1a) */
+static unsigned int namesHashStr(char *s) {
+
+	unsigned int h = 2166136261u;
+
+	while (*s) {
+
+		h ^= (unsigned char)*s++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+/* get the unique copy of a name */
+extern char *namesIntern(char *name) {
+
+	/* resize table at half load */
+	if (n_of_atoms * 2 >= cap_atoms) {
+
+		char **old = atoms;
+		unsigned int old_cap = cap_atoms;
+
+		cap_atoms = cap_atoms? cap_atoms * 2: 256;
+		atoms = (char **)calloc(cap_atoms, sizeof(char *));
+
+		for (unsigned int i = 0; i < old_cap; i++) {
+
+			if (old[i] == NULL)
+				continue;
+
+			unsigned int j = NAMES_HASH(old[i]) & (cap_atoms - 1);
+			while (atoms[j] != NULL) j = (j + 1) & (cap_atoms - 1);
+
+			atoms[j] = old[i];
+		}
+
+		free(old);
+	}
+
+	/* find existing name */
+	unsigned int h = namesHashStr(name);
+	unsigned int i = h & (cap_atoms - 1);
+
+	while (atoms[i] != NULL) {
+
+		if (atoms[i] == name || (NAMES_HASH(atoms[i]) == h && !strcmp(atoms[i], name)))
+			return atoms[i];
+
+		i = (i + 1) & (cap_atoms - 1);
+	}
+
+	/* create a new one with the hash in front */
+	size_t len = strlen(name);
+	unsigned int *a = (unsigned int *)malloc(sizeof(unsigned int) + len + 1);
+
+	a[0] = h;
+	memcpy(&a[1], name, len + 1);
+
+	atoms[i] = (char *)&a[1];
+	n_of_atoms++;
+
+	return atoms[i];
+}
+
+/* free all interned names */
+extern void namesFreeAtoms() {
+
+	for (unsigned int i = 0; i < cap_atoms; i++) {
+
+		if (atoms[i] != NULL)
+			free(&((unsigned int *)atoms[i])[-1]);
+	}
+
+	free(atoms);
+
+	atoms = NULL;
+	n_of_atoms = 0;
+	cap_atoms = 0;
+}
+
+/* add an entry to the hash index of a table */
+static void namesIndexAdd(nameTable *nt, unsigned int idx) {
+
+	unsigned int i = NAMES_HASH(nt->names[idx]) & (nt->cap_index - 1);
+
+	while (nt->index[i])
+		i = (i + 1) & (nt->cap_index - 1);
+
+	nt->index[i] = idx + 1;
+}
+
+/* create the hash index of a table with room for its names */
+static void namesIndexBuild(nameTable *nt) {
+
+	free(nt->index);
+
+	nt->cap_index = nt->cap_names * 2;
+	nt->index = (unsigned int *)calloc(nt->cap_index, sizeof(unsigned int));
+
+	for (unsigned int i = 0; i < nt->n_of_names; i++)
+		namesIndexAdd(nt, i);
+}
+
+/* find an interned name in a table */
+static unsigned int namesFind(nameTable *nt, char *atom) {
+
+	/* small tables are searched directly */
+	if (nt->index == NULL) {
+
+		unsigned int i;
+		for (i = 0; i < nt->n_of_names; i++) {
+
+			if (nt->names[i] == atom)
+				break;
+		}
+
+		return i;
+	}
+
+	/* probe hash index */
+	unsigned int i = NAMES_HASH(atom) & (nt->cap_index - 1);
+
+	while (nt->index[i]) {
+
+		if (nt->names[nt->index[i] - 1] == atom)
+			return nt->index[i] - 1;
+
+		i = (i + 1) & (nt->cap_index - 1);
+	}
+
+	return nt->n_of_names;
+}
+
 /* create a name table */
 extern nameTable *namesNew() {
 
@@ -46,6 +187,15 @@ extern nameTable *namesNew() {
 	if (nt == NULL)
 		return NULL;
 
+	namesInit(nt);
+
+	/* return */
+	return nt;
+}
+
+/* set up a name table in existing memory */
+extern void namesInit(nameTable *nt) {
+
 	/* create lists */
 	nt->names = (char **)malloc(sizeof(char *) * 8);
 	nt->values = (object **)malloc(sizeof(object *) * 8);
@@ -54,11 +204,10 @@ extern nameTable *namesNew() {
 	/* assign values */
 	nt->n_of_names = 0;
 	nt->cap_names = 8;
+	nt->index = NULL;
+	nt->cap_index = 0;
 	nt->parent = NULL;
 	nt->id = id++;
-
-	/* return */
-	return nt;
 }
 
 extern nameTable *namesCopy(nameTable *nt) {
@@ -72,10 +221,20 @@ extern nameTable *namesCopy(nameTable *nt) {
 	nt2->parent = nt->parent;
 
 	/* create new name and value lists */
+	free(nt2->names);
+	free(nt2->values);
 	nt2->names = (char **)malloc(sizeof(char *) * nt2->cap_names);
 	nt2->values = (object **)malloc(sizeof(object *) * nt2->cap_names);
 	memset(nt2->names, 0, sizeof(char *) * nt2->cap_names);
 
+	/* copy hash index */
+	if (nt->index != NULL) {
+
+		nt2->cap_index = nt->cap_index;
+		nt2->index = (unsigned int *)malloc(sizeof(unsigned int) * nt2->cap_index);
+		memcpy(nt2->index, nt->index, sizeof(unsigned int) * nt2->cap_index);
+	}
+
 	/* copy names and values */
 	for (int i = 0; i < nt2->n_of_names; i++) {
 
@@ -92,9 +251,7 @@ extern nameTable *namesCopy(nameTable *nt) {
 		nt2->values[i] = o;
 
 		/* reference tracking */
-		XINCREF(o);
-		if (o->type & OBJECT_POINTER)
-			XINCREF(O_OBJ(O_PTR(o)->val));
+		objectRef(o);
 
 		if (DEBUG) fprintf(debug_file, "[names] Copied %p[name=%s,type=%d] to %p[type=%d]\n", nt->values[i], nt->names[i], nt->values[i]->type, o, o->type);
 	}
@@ -108,60 +265,80 @@ extern nameTable *namesCopy(nameTable *nt) {
 /* set a value to a name */
 extern void namesSet(nameTable *nt, char *name, object *value) {
 
-	/* resize lists if neccessary */
-	if (nt->n_of_names >= nt->cap_names) {
+	/* get the index and set values in list */
+	namesSetAt(nt, namesIndex(nt, name), name, value);
+}
+
+/* set a value at an index (n_of_names adds a new name) */
+extern void namesSetAt(nameTable *nt, unsigned int idx, char *name, object *value) {
+
+	/* struct instances (capacity 0) have the fixed layout of their template */
+	if (idx >= nt->n_of_names && nt->cap_names == 0) {
+
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined name");
+		return;
+	}
+
+	/* resize lists if neccessary (only for new names) */
+	if (idx >= nt->n_of_names && nt->n_of_names >= nt->cap_names) {
 
 		nt->cap_names *= 2;
 		nt->names = (char **)realloc(nt->names, sizeof(char *) * nt->cap_names);
 		nt->values = (object **)realloc(nt->values, sizeof(object *) * nt->cap_names);
 	}
 
-	/* get the index and set values in list */
-	unsigned int idx = namesIndex(nt, name);
-
 	/* new seperate string */
 	//char *new_name = (char *)malloc(strlen(name) + 2);
 	//strcpy(new_name, name);
 	//name = new_name;
 
-	/* decrement reference if value is found */
-	if (idx < nt->n_of_names) {
-		XDECREF(nt->values[idx]);
+	/* constants are shared, so names get their own copy (which copies the constant it points to once it is changed) */
+	if (value->flags & OBJECT_CONST)
+		value = objectCopy(value);
 
-		/* for pointers */
-		if (nt->values[idx]->type & OBJECT_POINTER && !(nt->values[idx]->type & OBJECT_ARRAY))
-			XDECREF(O_OBJ(O_PTR(nt->values[idx])->val));
-	}
+	/* reference new value before releasing the old one (they may be the same object) */
+	objectRef(value);
 
-	/* increase reference for new value */
-	XINCREF(value);
+	/* fields of struct instances may hold an inline int or chr */
+	if (idx < nt->n_of_names && !IMM_IS(nt->values[idx]))
+		objectUnref(nt->values[idx]);
 
-	/* for pointers */
-	if (value->type & OBJECT_POINTER && !(value->type & OBJECT_ARRAY)) {
+	/* set value of existing name */
+	if (idx < nt->n_of_names) {
 
-		XINCREF(O_OBJ(O_PTR(value)->val));
+		nt->values[idx] = value;
+		return;
 	}
 
-	/* store stuff */
-	nt->names[idx] = name;
+	/* add new name */
+	nt->names[idx] = namesIntern(name);
 	nt->values[idx] = value;
+	nt->n_of_names++;
+
+	/* update hash index */
+	if (nt->n_of_names > NAMES_INDEX_MIN) {
 
-	/* advance number of values if needed */
-	if (idx >= nt->n_of_names) nt->n_of_names++;
+		if (nt->index == NULL || nt->n_of_names * 2 > nt->cap_index) namesIndexBuild(nt);
+		else namesIndexAdd(nt, idx);
+	}
 }
 
 /* get the index of a name if it exists */
 extern unsigned int namesIndex(nameTable *nt, char *name) {
 
-	/* loop through list and compare values */
-	int i;
-	for (i = 0; i < nt->n_of_names; i++) {
+	return namesFind(nt, namesIntern(name));
+}
 
-		if (!strcmp(nt->names[i], name))
-			break; /* exit out of loop to get correct value */
-	}
+/* get the index of a name, checking a slot that is likely to hold it first */
+extern unsigned int namesIndexAt(nameTable *nt, unsigned int slot, char *name) {
+
+	/* name is in its slot */
+	if (slot < nt->n_of_names && nt->names[slot] == name)
+		return slot;
 
-	return i; /* return the final index */
+	return namesIndex(nt, name);
 }
 
 /* get the value of a name */
@@ -173,27 +350,24 @@ extern object *namesGet(nameTable *nt, char *name) {
 /* get the value of a name */
 extern object *namesGetN(nameTable *nt, char *name, int n) {
 
-	/* get index of name */
-	unsigned int idx = namesIndex(nt, name);
-	object *o = NULL;
+	char *atom = namesIntern(name);
 
-	/* error */
-	if (idx == nt->n_of_names) {
+	/* check table and its parents */
+	while (nt != NULL) {
 
-		/* try and get parent value */
-		if ((nt->parent != NULL) && (n != 0)) {
+		unsigned int idx = namesFind(nt, atom);
 
-			o = namesGetN(nt->parent, name, 1);
-		}
+		if (idx < nt->n_of_names)
+			return nt->values[idx];
 
-		/* no success */
-		if (o == NULL)
-			return NULL;
+		/* don't check parent */
+		if (n == 0)
+			break;
+
+		nt = nt->parent;
 	}
-	else o = nt->values[idx];
 
-	/* return value */
-	return o;
+	return NULL;
 }
 
 /* get a value from a string object */
@@ -210,7 +384,6 @@ extern object *namesGetFromString(nameTable *nt, object *obj) {
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_UNDEFINEDNAME,
 					 "Undefined name/reference");
-			errorSetPos(obj->lineno, obj->colno, obj->fname);
 		}
 		return NULL;
 	}
@@ -219,10 +392,8 @@ extern object *namesGetFromString(nameTable *nt, object *obj) {
 	return o;
 }
 
-/* free a name table */
-extern void namesFree(nameTable *nt) {
-
-	if (DEBUG) fprintf(debug_file, "[names] Freeing %p\n", nt);
+/* remove all names from a table, keeping its lists to be used again */
+extern void namesClear(nameTable *nt) {
 
 	/* decrease references for each object */
 	for (int i = 0; i < nt->n_of_names; i++) {
@@ -232,13 +403,7 @@ extern void namesFree(nameTable *nt) {
 			/* debug info */
 			if (DEBUG) fprintf(debug_file, "[names] Dereffing '%s'...\n", nt->names[i]);
 	
-			XDECREF(nt->values[i]);
-	
-			/* for pointers */
-			if (nt->values[i]->type & (1 << 3)) {
-	
-				XDECREF(O_OBJ(O_PTR(nt->values[i])->val));
-			}
+			objectUnref(nt->values[i]);
 	
 			if (DEBUG) fprintf(debug_file, "[names] Dereffed '%s'.\n", nt->names[i]);
 		}
@@ -246,6 +411,22 @@ extern void namesFree(nameTable *nt) {
 
 	if (DEBUG) fprintf(debug_file, "[names] Dereffed all values for nt %p\n", nt);
 
+	/* reset table */
+	free(nt->index);
+
+	nt->n_of_names = 0;
+	nt->index = NULL;
+	nt->cap_index = 0;
+	nt->parent = NULL;
+}
+
+/* free a name table */
+extern void namesFree(nameTable *nt) {
+
+	if (DEBUG) fprintf(debug_file, "[names] Freeing %p\n", nt);
+
+	namesClear(nt);
+
 	/* free lists */
 	free(nt->names);
 	free(nt->values);
@@ -254,4 +435,4 @@ extern void namesFree(nameTable *nt) {
 	free(nt);
 
 	if (DEBUG) fprintf(debug_file, "[names] Freed nt %p\n", nt);
-}
\ No newline at end of file
+}
@@ -28,13 +28,25 @@
 #include "obhead.h"
 #include "nametable.h"
 
+/* tables with more names than this use a hash index */
+#define NAMES_INDEX_MIN 8
+
+/* hash of an interned name (stored in front of the string) */
+#define NAMES_HASH(atom) (((unsigned int *)(atom))[-1])
+
 /* functions */
+extern char *namesIntern(char *name); /* get the unique copy of a name, so names can be compared by pointer */
+extern void namesFreeAtoms(); /* free all interned names */
 extern nameTable *namesNew(); /* create a new nameTable for storing names */
+extern void namesInit(nameTable *nt); /* set up a nameTable in existing memory */
 extern void namesSet(nameTable *nt, char *name, object *value); /* add a value to the list or set a value to the list */
+extern void namesSetAt(nameTable *nt, unsigned int idx, char *name, object *value); /* set a value at an index returned by namesIndex */
 extern unsigned int namesIndex(nameTable *nt, char *name); /* get the index of a name if it has been found */
+extern unsigned int namesIndexAt(nameTable *nt, unsigned int slot, char *name); /* same as namesIndex, but checks slot first */
 extern object *namesGet(nameTable *nt, char *name); /* get a name's value if the name is found */
 extern object *namesGetFromString(nameTable *nt, object *obj); /* get a value from a string name */
 extern object *namesGetN(nameTable *nt, char *name, int n); /* same as namesGet, but n controls whether or not to check the parent name table as well */
+extern void namesClear(nameTable *nt); /* remove all names from a table but keep its memory */
 extern void namesFree(nameTable *nt); /* free a table */
 extern nameTable *namesCopy(nameTable *nt); /* copy a table entirely */
 
@@ -27,10 +27,12 @@
 /* name table for storing names */
 typedef struct _nameTable {
 	struct _nameTable *parent; /* for accessing "outside" values */
-	char **names; /* list of names */
+	char **names; /* list of names (interned, see namesIntern) */
 	object **values; /* list of values */
 	unsigned int n_of_names; /* number of names */
-	unsigned int cap_names; /* capacity of lists */
+	unsigned int cap_names; /* capacity of lists (0 for struct instances, which can't add names) */
+	unsigned int *index; /* open addressing hash index of names (entry index + 1, 0 if empty), NULL for small tables */
+	unsigned int cap_index; /* size of index (power of two) */
 	int id; /* identity number for better tracking of what is what */
 } nameTable;
 
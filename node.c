@@ -44,6 +44,9 @@ extern node *nodeNew(unsigned int type,
 	n->cap_children = 8;
 	n->cap_tokens = 8;
 	n->cap_values = 8;
+	n->checked = 0;
+	n->is_const = 0;
+	n->const_val = 0;
 	n->lineno = lineno;
 	n->colno = colno;
 	n->fname = fname;
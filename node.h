@@ -66,6 +66,9 @@ typedef struct _node {
 	unsigned int cap_children; /* capacity of children */
 	unsigned int cap_tokens; /* capacity of tokens */
 	unsigned int cap_values; /* capacity of values */
+	unsigned char checked; /* types were checked before compiling, so they don't need to be checked at run time */
+	unsigned char is_const; /* value was folded into a constant before compiling */
+	int const_val; /* folded value */
 	/* error stuff */
 	unsigned int lineno;
 	unsigned int colno;
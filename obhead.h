@@ -24,6 +24,7 @@
 #define _OBHEAD_H
 
 #include <stdlib.h>
+#include <stdint.h> /* uintptr_t */
 
 /* object types */
 #define OBJECT_INT 0
@@ -36,18 +37,34 @@
 #define OBJECT_TYPE (1 << 4)
 #define OBJECT_DL (1 << 5)
 
+/* object flags */
+#define OBJECT_CONST (1 << 0) /* shared constant that can't be changed (see objectWritable) */
+
+/* int and chr values on the operand stack and in the fields of struct instances
+   are tagged words instead of objects (type in bits 1-7, value in the upper half),
+   boxed when they are stored in a name or need an object of their own */
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define IMM_IS(o) (((uintptr_t)(o)) & 1)
+#define IMM_NEW(tp, v) ((object *)(((uintptr_t)(unsigned int)(v) << 32) | ((uintptr_t)(tp) << 1) | 1))
+#define IMM_VAL(o) ((int)((uintptr_t)(o) >> 32))
+#define IMM_TYPE(o) ((unsigned char)(((uintptr_t)(o) >> 1) & 0x7F))
+#else
+/* no room for a value next to the tag, always box */
+#define IMM_IS(o) 0
+#define IMM_NEW(tp, v) intcharobjectNew((tp) == OBJECT_CHR, v)
+#define IMM_VAL(o) 0
+#define IMM_TYPE(o) 0
+#endif
+
 /* these will make builtin function creation much less ugly */
 #define FUNC_ARGNAME_LIST(n) ((char **)malloc(sizeof(char *) * n))
 #define FUNC_ARGTYPE_LIST(n) ((unsigned char *)malloc(sizeof(unsigned char) * n + 1))
 
-/* object head */
+/* object head (source positions of errors come from the bytecode, not from objects) */
 #define OB_HEAD 	unsigned int refcnt; /* number of references */ \
 	unsigned char type; /* type of object */ \
-	unsigned int lineno; /* for errors */ \
-	unsigned int colno; /* for errors */ \
-	char *fname; /* for errors */ \
-	unsigned int sz; /* for objectCopy */\
-	char copied; /* copied from existing object's data (using objectCopy) */
+	unsigned char flags; /* object flags */ \
+	unsigned int slot; /* index in object list */
 
 /* object */
 typedef struct {
@@ -35,11 +35,44 @@
 #include <string.h> /* strcpy, strlen, etc */
 #include <stdio.h> /* sprintf, printf, etc */
 #include <unistd.h> /* more io */
+#include <stdint.h> /* uintptr_t */
 
 /* list of all objects */
 object **objects = NULL;
 int n_of_objects; /* number of objects stored in list */
 int cap_objects; /* capacity of object list */
+int n_free_objects = 0; /* number of free slots below n_of_objects */
+int n_new_objects = 0; /* number of objects created since the last collection */
+static int free_objects = -1; /* first free slot (-1 if there are none) */
+extern int is_at_end; /* values are not released when the program ends */
+
+/* free slots hold the index of the next free slot plus one (so -1 is never shifted), tagged with the low bit */
+#define OBJECTS_IS_FREE(p) (((uintptr_t)(p)) & 1)
+#define OBJECTS_NEXT(p) ((int)((uintptr_t)(p) >> 1) - 1)
+#define OBJECTS_LINK(i) ((object *)((((uintptr_t)((i) + 1)) << 1) | 1))
+
+/* shrink the list when less than a quarter of it is used */
+#define OBJECTS_SHRINK_MIN 1024
+
+/* small objects come from pools of fixed size blocks (one pool for each multiple of OBJECT_POOL_ALIGN) */
+#define OBJECT_POOL_ALIGN 8
+#define OBJECT_POOL_MAX 128 /* larger objects are allocated with malloc */
+#define OBJECT_POOL_CLASSES (OBJECT_POOL_MAX / OBJECT_POOL_ALIGN)
+#define OBJECT_POOL_CHUNK 8192 /* size of memory blocks that pools are carved from */
+#define OBJECT_POOL_HEAD 16 /* space for chunk list link at the start of a chunk */
+#define OBJECT_POOL_CLASS(sz) (((sz) + OBJECT_POOL_ALIGN - 1) / OBJECT_POOL_ALIGN - 1)
+
+/* objects that own memory besides their own block */
+#define OBJECT_HAS_DATA(o) ((o)->type == OBJECT_FUNC || (o)->type == OBJECT_STRUCT || ((o)->type & (OBJECT_DL | OBJECT_TYPE)))
+
+static void *pool_free[OBJECT_POOL_CLASSES]; /* free blocks of each size (first word of a block is the next one) */
+static void *pool_chunks = NULL; /* all chunks (first word of a chunk is the next one) */
+
+/* allocation counters */
+static unsigned long n_pool_allocs = 0; /* objects allocated from pools */
+static unsigned long n_malloc_allocs = 0; /* objects allocated with malloc */
+static unsigned long n_object_frees = 0; /* objects freed */
+static unsigned int n_pool_chunks = 0; /* number of chunks */
 int DEBUG = 0; /* debugging */
 int INT_SIGNAL = 0; /* if we were interrupted */
 int objdout = 0; /* for disabling non-debug output */
@@ -50,10 +83,13 @@ FILE *debug_file = NULL; /* file that debug info gets sent to */
 static int open_fds[8] = {0,1,2};
 static int open_fdsl = 3;
 
-/* typedef types */
-static typeobject **types = NULL;
-static int types_len = 0;
-static int types_cap = 8;
+/* typedef types (indexed by type id) */
+static typeobject **types = NULL; /* type of each id (NULL if the name isn't a type yet) */
+static char **type_names = NULL; /* interned name of each id */
+static unsigned int types_len = 0;
+static unsigned int types_cap = 0;
+static unsigned int *type_index = NULL; /* open addressing hash index of names (id + 1, 0 if empty) */
+static unsigned int type_index_cap = 0;
 
 /* misc */
 static int struct_ids = 0;
@@ -80,10 +116,89 @@ extern void objectSegvHandler(int n) {
 	exit(0); /* exit program */
 }
 
+/* allocate memory for an object */
+static void *objectAlloc(size_t size) {
+
+	/* too big for pools */
+	if (size > OBJECT_POOL_MAX) {
+
+		n_malloc_allocs++;
+		return malloc(size);
+	}
+
+	int c = OBJECT_POOL_CLASS(size);
+	size_t bsz = (c + 1) * OBJECT_POOL_ALIGN;
+
+	/* pool is empty, carve a new chunk into blocks */
+	if (pool_free[c] == NULL) {
+
+		char *chunk = (char *)malloc(OBJECT_POOL_CHUNK);
+
+		if (chunk == NULL)
+			return NULL;
+
+		*(void **)chunk = pool_chunks;
+		pool_chunks = chunk;
+		n_pool_chunks++;
+
+		for (size_t p = OBJECT_POOL_HEAD; p + bsz <= OBJECT_POOL_CHUNK; p += bsz) {
+
+			*(void **)(chunk + p) = pool_free[c];
+			pool_free[c] = chunk + p;
+		}
+
+		if (DEBUG) fprintf(debug_file, "[DEBUG] Added chunk %p to pool of %d byte objects.\n", chunk, (int)bsz);
+	}
+
+	/* take first free block */
+	void *b = pool_free[c];
+	pool_free[c] = *(void **)b;
+	n_pool_allocs++;
+
+	return b;
+}
+
+/* get the size of an object from its type */
+extern size_t objectSize(object *o) {
+
+	if (o->type & OBJECT_TYPE) return sizeof(typeobject);
+	if (o->type & OBJECT_DL) return sizeof(mangodlobject);
+	if (o->type & OBJECT_POINTER) return sizeof(pointerobject);
+	if (o->type & OBJECT_ARRAY) return sizeof(arrayobject) + (O_ARRAY(o)->n_len * O_TPSZ(O_ARRAY(o)->a_type));
+
+	switch (o->type & 0x3) {
+
+		case OBJECT_INT: return sizeof(intobject);
+		case OBJECT_CHR: return sizeof(charobject);
+		case OBJECT_FUNC: return sizeof(functionobject);
+		default: return O_STRUCT(o)->is_templ? sizeof(structobject): STRUCT_SIZE(O_STRUCT(o)->fields.n_of_names);
+	}
+}
+
+/* release the memory of an object */
+static void objectRelease(object *obj) {
+
+	size_t sz = objectSize(obj);
+
+	n_object_frees++;
+
+	if (sz > OBJECT_POOL_MAX) {
+
+		free(obj);
+		return;
+	}
+
+	/* give block back to its pool */
+	int c = OBJECT_POOL_CLASS(sz);
+
+	*(void **)obj = pool_free[c];
+	pool_free[c] = obj;
+}
+
 /* create an object */
 extern object *objectNew(unsigned char type, size_t size) {
 	
-	object *o = (object *)malloc(size); /* new object! :D */
+	object *o = (object *)objectAlloc(size); /* new object! :D */
 
 	/* we have failed */
 	if (o == NULL) {
@@ -98,15 +213,8 @@ extern object *objectNew(unsigned char type, size_t size) {
 
 	/* set our values */
 	o->type = type;
+	o->flags = 0;
 	o->refcnt = 0; /* can be freed if it needs to (starts out at 1 so that garbage collection won't immediately take care of it) */
-	
-	o->lineno = 0;
-	o->colno = 0;
-	o->fname = NULL;
-
-	o->sz = size;
-
-	o->copied = 0;
 
 	/* auto initalise list */
 	if (objects == NULL) {
@@ -120,27 +228,32 @@ extern object *objectNew(unsigned char type, size_t size) {
 
 	unsigned int lnums;
 
-	/* find index for object */
-	for (lnums = 0; lnums < n_of_objects; lnums++) {
+	/* reuse a free slot */
+	if (free_objects >= 0) {
 
-		/* null */
-		if (objects[lnums] == NULL)
-			break;
+		lnums = free_objects;
+		free_objects = OBJECTS_NEXT(objects[lnums]);
+		n_free_objects--;
 	}
 
-	/* if list is already full then resize it */
-	if (n_of_objects >= cap_objects) {
-		objects = (object **)realloc(objects, sizeof(object*) * cap_objects * 2);
-		cap_objects *= 2;
+	/* add to the end */
+	else {
 
-		if (DEBUG) fprintf(debug_file, "[DEBUG] Resized object list to %d item(s) capacity.\n", cap_objects);
-	}
+		/* if list is already full then resize it */
+		if (n_of_objects >= cap_objects) {
+			objects = (object **)realloc(objects, sizeof(object*) * cap_objects * 2);
+			cap_objects *= 2;
+
+			if (DEBUG) fprintf(debug_file, "[DEBUG] Resized object list to %d item(s) capacity.\n", cap_objects);
+		}
 
-	/* increase n_of_objects if necessary */
-	if (lnums == n_of_objects) n_of_objects++;
+		lnums = n_of_objects++;
+	}
 
 	/* add item to list */
 	objects[lnums] = o;
+	o->slot = lnums;
+	n_new_objects++;
 
 	/* debug mode */
 	if (DEBUG) fprintf(debug_file, "[DEBUG] Successfully created an object (%p) of type %d.\n", o, type);
@@ -155,16 +268,96 @@ extern object *objectCopy(object *o) {
 	if (o->type != OBJECT_INT && o->type != OBJECT_CHR && !(o->type & OBJECT_ARRAY) && !(o->type & OBJECT_POINTER))
 		return o;
 
-	object *o2 = objectNew(o->type, o->sz);
-	memcpy(o2, o, o->sz);
+	size_t sz = objectSize(o);
+	object *o2 = objectNew(o->type, sz);
+	unsigned int slot = o2->slot;
+	memcpy(o2, o, sz);
 	
+	o2->slot = slot;
 	o2->refcnt = 0;
-	o2->copied = 1;
+
+	/* copies of constants can be changed (arrays get their own data) */
+	if (o->flags & OBJECT_CONST) {
+
+		o2->flags &= ~OBJECT_CONST;
+
+		if (o->type & OBJECT_ARRAY)
+			O_ARRAY(o2)->n_start = ((void *)o2 + sizeof(arrayobject));
+	}
 
 	/* return object */
 	return o2;
 }
 
+/* get an array to change from a pointer to it (or the array itself), copying it first if it is a constant */
+extern object *objectWritable(object *o) {
+
+	object *p = NULL; /* pointer to array */
+
+	/* for pointers */
+	if (o->type & OBJECT_POINTER && !(o->type & OBJECT_ARRAY)) {
+
+		p = o;
+		o = O_OBJ(O_PTR(p)->val);
+	}
+
+	/* not a constant */
+	if (o == NULL || !(o->flags & OBJECT_CONST))
+		return o;
+
+	object *c = objectCopy(o);
+
+	/* the pointer points to the copy from now on, moving its references over (a constant pointer is shared, so the copy is only seen by the caller) */
+	if (p != NULL && !(p->flags & OBJECT_CONST)) {
+
+		c->refcnt += p->refcnt;
+		o->refcnt -= p->refcnt;
+		O_PTR(p)->val = (void *)c;
+	}
+
+	return c;
+}
+
+/* drop a reference, freeing the object when the last one goes */
+static void objectDecref(object *o) {
+
+	if (o != NULL && o->refcnt > 0 && --o->refcnt == 0)
+		objectFree(o);
+}
+
+/* take a reference to an object (and the object a pointer points to) */
+extern void objectRef(object *o) {
+
+	XINCREF(o);
+
+	/* for pointers */
+	if (o->type & OBJECT_POINTER && !(o->type & OBJECT_ARRAY))
+		XINCREF(O_OBJ(O_PTR(o)->val));
+}
+
+/* release a reference taken with objectRef, freeing objects that are no longer referenced */
+extern void objectUnref(object *o) {
+
+	object *p = NULL;
+
+	/* for pointers */
+	if (o->type & OBJECT_POINTER && !(o->type & OBJECT_ARRAY))
+		p = O_OBJ(O_PTR(o)->val);
+
+	objectDecref(o);
+	objectDecref(p);
+}
+
+/* release a reference taken with objectRef, leaving unreferenced objects to the garbage collector */
+extern void objectDisown(object *o) {
+
+	/* for pointers */
+	if (o->type & OBJECT_POINTER && !(o->type & OBJECT_ARRAY))
+		XDECREF(O_OBJ(O_PTR(o)->val));
+
+	XDECREF(o);
+}
+
 /* create a new type */
 extern object *typeNew(char *tp_name, unsigned char tp_type) {
 
@@ -184,29 +377,96 @@ extern object *typeNew(char *tp_name, unsigned char tp_type) {
 	return tp;
 }
 
-/* create and register a new type */
-extern void typeRegister(char *tp_name, unsigned char tp_type) {
+/* add an id to the hash index of type names */
+static void typeIndexAdd(unsigned int id) {
 
-	/* create object */
-	object *tp = typeNew(tp_name, tp_type);
+	unsigned int i = NAMES_HASH(type_names[id]) & (type_index_cap - 1);
+
+	while (type_index[i])
+		i = (i + 1) & (type_index_cap - 1);
+
+	type_index[i] = id + 1;
+}
+
+/* get the id of a type name (names that aren't types yet get one too) */
+extern unsigned int typeId(char *tp_name) {
 
-	/* create list */
+	/* builtin types have fixed ids */
 	if (types == NULL) {
 
-		types_len = 0;
 		types_cap = 8;
-		types = (typeobject **)malloc(sizeof(typeobject *) * types_cap);
+		types = (typeobject **)calloc(types_cap, sizeof(typeobject *));
+		type_names = (char **)malloc(sizeof(char *) * types_cap);
+		type_index_cap = types_cap * 2;
+		type_index = (unsigned int *)calloc(type_index_cap, sizeof(unsigned int));
+
+		type_names[TYPE_INT] = namesIntern("int");
+		type_names[TYPE_CHR] = namesIntern("chr");
+		types_len = 2;
+
+		typeIndexAdd(TYPE_INT);
+		typeIndexAdd(TYPE_CHR);
+	}
+
+	char *atom = namesIntern(tp_name);
+
+	/* find existing id */
+	unsigned int i = NAMES_HASH(atom) & (type_index_cap - 1);
+
+	while (type_index[i]) {
+
+		if (type_names[type_index[i] - 1] == atom)
+			return type_index[i] - 1;
+
+		i = (i + 1) & (type_index_cap - 1);
 	}
 
-	/* realloc list */
+	/* resize lists */
 	if (types_len >= types_cap) {
 
 		types_cap *= 2;
 		types = (typeobject **)realloc(types, sizeof(typeobject *) * types_cap);
+		type_names = (char **)realloc(type_names, sizeof(char *) * types_cap);
+	}
+
+	/* add new id */
+	unsigned int id = types_len++;
+	types[id] = NULL;
+	type_names[id] = atom;
+
+	/* rebuild hash index at half load */
+	if (types_len * 2 > type_index_cap) {
+
+		free(type_index);
+
+		type_index_cap = types_cap * 2;
+		type_index = (unsigned int *)calloc(type_index_cap, sizeof(unsigned int));
+
+		for (unsigned int j = 0; j < types_len; j++)
+			typeIndexAdd(j);
 	}
+	else typeIndexAdd(id);
+
+	return id;
+}
+
+/* add a type object to its id (the first type registered with a name is kept) */
+static void typeAdd(object *tp) {
+
+	unsigned int id = typeId(O_TYPE(tp)->tp_name);
+
+	if (types[id] == NULL)
+		types[id] = O_TYPE(tp);
+}
+
+/* create and register a new type */
+extern void typeRegister(char *tp_name, unsigned char tp_type) {
+
+	/* create object */
+	object *tp = typeNew(tp_name, tp_type);
 
 	/* add item */
-	types[types_len++] = O_TYPE(tp);
+	typeAdd(tp);
 }
 
 /* create and register struct type */
@@ -216,57 +476,43 @@ extern void typeRegisterStruct(char *tp_name, object *st) {
 	object *tp = typeNew(tp_name, OBJECT_STRUCT);
 	O_TYPE(tp)->st = st;
 
-	/* create list */
-	if (types == NULL) {
+	/* add item */
+	typeAdd(tp);
+}
 
-		types_len = 0;
-		types_cap = 8;
-		types = (typeobject **)malloc(sizeof(typeobject *) * types_cap);
-	}
+/* get a type from its id (0xFF if it isn't defined) */
+extern unsigned char typeGetId(unsigned int id) {
 
-	/* realloc list */
-	if (types_len >= types_cap) {
+	/* builtin types */
+	if (id == TYPE_INT) return OBJECT_INT;
+	if (id == TYPE_CHR) return OBJECT_CHR;
 
-		types_cap *= 2;
-		types = (typeobject **)realloc(types, sizeof(typeobject *) * types_cap);
-	}
+	/* no type */
+	if (id >= types_len || types[id] == NULL)
+		return 0xFF;
 
-	/* add item */
-	types[types_len++] = O_TYPE(tp);
+	return types[id]->tp_type;
 }
 
-/* get a new type */
-extern unsigned char typeGet(char *tp_name) {
+/* get a full type object from its id */
+extern object *typeobjectGetId(unsigned int id) {
 
-	if (types == NULL)
-		return 0xFF;
+	if (id >= types_len)
+		return NULL;
 
-	/* loop through types */
-	for (int i = 0; i < types_len; i++) {
+	return O_OBJ(types[id]);
+}
 
-		if (!strcmp(types[i]->tp_name, tp_name))
-			return types[i]->tp_type;
-	}
+/* get a new type */
+extern unsigned char typeGet(char *tp_name) {
 
-	/* no type */
-	return 0xFF;
+	return typeGetId(typeId(tp_name));
 }
 
 /* get a new type */
 extern object *typeobjectGet(char *tp_name) {
 
-	if (types == NULL)
-		return NULL;
-
-	/* loop through types */
-	for (int i = 0; i < types_len; i++) {
-
-		if (!strcmp(types[i]->tp_name, tp_name))
-			return O_OBJ(types[i]);
-	}
-
-	/* no type */
-	return NULL;
+	return typeobjectGetId(typeId(tp_name));
 }
 
 /* perform operation on object */
@@ -421,7 +667,6 @@ extern object *objectOperation(object *obj, object *other, unsigned int op_num)
 	/* create error */
 	errorSet(ERROR_TYPE_RUNTIME, ERROR_CODE_ILLEGALOP,
 			 "Illegal operation");
-	errorSetPos(obj->lineno, obj->colno, obj->fname);
 
 	/* exit */
 	return NULL;
@@ -438,9 +683,6 @@ extern object *arrayobjectNew(int n, unsigned char t) {
 		return NULL;
 
 	/* assign values */
-	a->lineno = 0;
-	a->colno = 0;
-	a->fname = NULL;
 	a->refcnt = 0;
 	a->n_len = n;
 	a->n_sz = 0;
@@ -472,7 +714,7 @@ extern object *charobjectNew(char val) {
 extern object *intcharobjectNew(int isch, int val) {
 
 	/* allocate object */
-	size_t sz = isch? sizeof(intobject): sizeof(charobject);
+	size_t sz = isch? sizeof(charobject): sizeof(intobject);
 	object *o = objectNew(isch? OBJECT_CHR: OBJECT_INT, sz);
 
 	/* failed to allocate */
@@ -523,6 +765,7 @@ extern object *functionobjectNew(char *func_name, unsigned char rt_type, char **
 	O_FUNC(o)->n_of_args = n_of_args;
 	O_FUNC(o)->fb_n = 0;
 	O_FUNC(o)->is_builtin = 0;
+	O_FUNC(o)->fname = NULL;
 
 	/* return object */
 	return o;
@@ -568,8 +811,10 @@ extern object *structobjectNew(context *ctx, char *struct_name) {
 /* create a new instance of a struct */
 extern object *structobjectInstance(object *s) {
 
-	/* create new object */
-	object *s2 = objectNew(OBJECT_STRUCT, sizeof(structobject));
+	nameTable *nt = O_STRUCT(s)->ctx->nt;
+
+	/* create new object with room for its fields */
+	object *s2 = objectNew(OBJECT_STRUCT, STRUCT_SIZE(nt->n_of_names));
 
 	/* failed to allocate */
 	if (s2 == NULL)
@@ -577,20 +822,52 @@ extern object *structobjectInstance(object *s) {
 
 	/* set values */
 	O_STRUCT(s2)->struct_name = O_STRUCT(s)->struct_name;
-	O_STRUCT(s2)->nt = namesCopy(O_STRUCT(s)->ctx->nt);
 	O_STRUCT(s2)->parent = O_STRUCT(s);
 	O_STRUCT(s2)->is_templ = 0;
 
-	/* allocate context */
-	O_STRUCT(s2)->ctx = (context *)malloc(sizeof(context));
-	O_STRUCT(s2)->ctx->fn = O_STRUCT(s)->ctx->fn;
-	O_STRUCT(s2)->ctx->sn = O_STRUCT(s)->ctx->sn;
-	O_STRUCT(s2)->ctx->nt = O_STRUCT(s2)->nt;
+	/* instances don't run code, so they use the context of their template */
+	O_STRUCT(s2)->ctx = O_STRUCT(s)->ctx;
+
+	/* the layout of the template is fixed, so its names and hash index are shared (a capacity of 0 keeps names from being added) */
+	O_STRUCT(s2)->fields = *nt;
+	O_STRUCT(s2)->fields.values = O_STRUCT(s2)->values;
+	O_STRUCT(s2)->fields.cap_names = 0;
+	O_STRUCT(s2)->nt = &O_STRUCT(s2)->fields;
+
+	/* copy values (int and chr fields are stored inline) */
+	for (unsigned int i = 0; i < nt->n_of_names; i++) {
+
+		object *f = nt->values[i];
+
+		if (f->type == OBJECT_INT) f = IMM_NEW(OBJECT_INT, O_INT(f)->val);
+		else if (f->type == OBJECT_CHR) f = IMM_NEW(OBJECT_CHR, O_CHR(f)->val);
+		else f = objectCopy(f);
+
+		if (!IMM_IS(f)) objectRef(f);
+		O_STRUCT(s2)->values[i] = f;
+	}
+
+	/* keep the template while the instance uses its names */
+	objectRef(s);
 
 	/* return struct */
 	return s2;
 }
 
+/* get a field of a struct as an object, an inline int or chr is boxed and the box takes its place */
+extern object *structobjectBox(object *s, unsigned int idx) {
+
+	object **f = &O_STRUCT(s)->nt->values[idx];
+
+	if (IMM_IS(*f)) {
+
+		*f = intcharobjectNew(IMM_TYPE(*f) == OBJECT_CHR, IMM_VAL(*f));
+		objectRef(*f);
+	}
+
+	return *f;
+}
+
 /* free an object */
 extern void objectFree(object *obj) {
 
@@ -618,10 +895,19 @@ extern void objectFree(object *obj) {
 	/* non-template struct */
 	if (obj->type == OBJECT_STRUCT && !(O_STRUCT(obj)->is_templ)) {
 
-		/* free name table */
-		contextFree(O_STRUCT(obj)->ctx);
+		/* release fields and template */
+		if (!is_at_end) {
 
-		if (DEBUG) fprintf(debug_file, "[DEBUG] Freed nt %p.\n", O_STRUCT(obj)->nt);
+			for (unsigned int i = 0; i < O_STRUCT(obj)->fields.n_of_names; i++) {
+
+				if (!IMM_IS(O_STRUCT(obj)->values[i]))
+					objectUnref(O_STRUCT(obj)->values[i]);
+			}
+
+			objectUnref((object *)O_STRUCT(obj)->parent);
+		}
+
+		if (DEBUG) fprintf(debug_file, "[DEBUG] Released fields of %p.\n", obj);
 	}
 
 	/* dynamic library */
@@ -643,54 +929,142 @@ extern void objectFree(object *obj) {
 		free(O_TYPE(obj)->tp_name);
 	}
 
+	/* give its slot back to the list */
+	objects[obj->slot] = OBJECTS_LINK(free_objects);
+	free_objects = obj->slot;
+	n_free_objects++;
+
 	/* free the object */
-	free(obj);
+	objectRelease(obj);
 }
 
-extern void objectCollect() {
-	
-	/* task: go through list, free any objects with low reference counts */
+/* move objects to the front of the list and release unused capacity */
+static void objectShrink() {
+
+	int n = 0;
+
 	for (int i = 0; i < n_of_objects; i++) {
 
-		if ((objects[i] != NULL) && (objects[i]->refcnt < 1)) {
+		if (OBJECTS_IS_FREE(objects[i]))
+			continue;
+
+		objects[n] = objects[i];
+		objects[n]->slot = n;
+		n++;
+	}
+
+	n_of_objects = n;
+	n_free_objects = 0;
+	free_objects = -1;
+
+	/* keep room to grow */
+	while (cap_objects > 8 && cap_objects / 4 > n)
+		cap_objects /= 2;
+
+	objects = (object **)realloc(objects, sizeof(object*) * cap_objects);
+
+	if (DEBUG) fprintf(debug_file, "[DEBUG] Shrunk object list to %d item(s) capacity.\n", cap_objects);
+}
+
+/* free unreferenced objects in a range of slots */
+extern void objectCollectRange(int start, int end) {
+
+	if (end > n_of_objects)
+		end = n_of_objects;
+
+	/* task: go through list, free any objects with low reference counts */
+	for (int i = start; i < end; i++) {
+
+		object *o = objects[i];
+
+		if (!OBJECTS_IS_FREE(o) && (o->refcnt < 1)) {
 
 			/* debug info */
-			if (DEBUG) fprintf(debug_file, "[DEBUG] Freeing %p with type %d...\n", objects[i], objects[i]->type);
+			if (DEBUG) fprintf(debug_file, "[DEBUG] Freeing %p with type %d...\n", o, o->type);
 
-			objectFree(objects[i]);
+			objectFree(o);
 
 			/* debug */
-			if (DEBUG) fprintf(debug_file, "[DEBUG] Garbage freed %p.\n", objects[i]);
-			objects[i] = NULL;
+			if (DEBUG) fprintf(debug_file, "[DEBUG] Garbage freed %p.\n", o);
 		}
 	}
 }
 
+/* finish a collection */
+extern void objectCollectDone() {
+
+	n_new_objects = 0;
+
+	/* mostly empty after a burst of allocations */
+	if (cap_objects > OBJECTS_SHRINK_MIN && (n_of_objects - n_free_objects) < cap_objects / 4)
+		objectShrink();
+}
+
+extern void objectCollect() {
+
+	objectCollectRange(0, n_of_objects);
+	objectCollectDone();
+}
+
 extern void objectFreeAll() {
 
 	if (DEBUG) fprintf(debug_file, "[DEBUG] Preparing to free objects...\n");
 
 	/* go through list and free all objects. */
 	for (int i = 0; i < n_of_objects; i++) {
-		if (objects[i] != NULL) {
 
-			/* debug info */
-			if (DEBUG) fprintf(debug_file, "[DEBUG] Freeing %p with type %d...\n", objects[i], objects[i]->type);
+		object *o = objects[i];
+
+		if (OBJECTS_IS_FREE(o))
+			continue;
 
-			objectFree(objects[i]);
+		/* pooled objects without data of their own are released with their chunks */
+		if (!OBJECT_HAS_DATA(o)) {
 
-			/* debug mode stuff */
-			if (DEBUG) fprintf(debug_file, "[DEBUG] Freed %p.\n", objects[i]);
-			objects[i] = NULL;
+			if (objectSize(o) > OBJECT_POOL_MAX) free(o);
+			continue;
 		}
+
+		/* debug info */
+		if (DEBUG) fprintf(debug_file, "[DEBUG] Freeing %p with type %d...\n", o, o->type);
+
+		objectFree(o);
+
+		/* debug mode stuff */
+		if (DEBUG) fprintf(debug_file, "[DEBUG] Freed %p.\n", o);
 	}
 
+	if (DEBUG) fprintf(debug_file, "[DEBUG] %lu object(s) from pools, %lu from malloc, %lu freed, %u pool chunk(s).\n", n_pool_allocs, n_malloc_allocs, n_object_frees, n_pool_chunks);
+
+	/* release pools */
+	while (pool_chunks != NULL) {
+
+		void *next = *(void **)pool_chunks;
+		free(pool_chunks);
+		pool_chunks = next;
+	}
+
+	memset(pool_free, 0, sizeof(pool_free));
+	n_pool_chunks = 0;
+
 	/* free object list */
 	free(objects);
+	objects = NULL;
+	n_of_objects = 0;
+	n_free_objects = 0;
+	n_new_objects = 0;
+	free_objects = -1;
 
 	/* free type list */
-	if (types != NULL) free(types);
+	free(types);
+	free(type_names);
+	free(type_index);
 	types = NULL;
+	type_names = NULL;
+	type_index = NULL;
+	types_len = 0;
+	types_cap = 0;
+	type_index_cap = 0;
 }
 
 /* builtin function : write */
@@ -725,7 +1099,6 @@ extern object *builtinWrite(object **ob_args, void *ctx) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_UNKNOWNFD,
 				 "File descriptor not opened by Mango");
-		errorSetPos(ob_args[1]->lineno, ob_args[1]->colno, ob_args[1]->fname);
 		return NULL;
 	}
 
@@ -744,7 +1117,7 @@ extern object *builtinRead(object **ob_args, void *ctx) {
 
 	/* get arguments */
 	int fd = O_INT(ob_args[0])->val;
-	char *buf = (char *)(O_ARRAY(O_PTR(ob_args[1])->val)->n_start);
+	char *buf = (char *)(O_ARRAY(objectWritable(ob_args[1]))->n_start);
 	int n = O_INT(ob_args[2])->val;
 
 	int n_of_chars = 0;
@@ -764,7 +1137,6 @@ extern object *builtinRead(object **ob_args, void *ctx) {
 		errorSet(ERROR_TYPE_RUNTIME,
 				 ERROR_CODE_UNKNOWNFD,
 				 "File descriptor not opened by Mango");
-		errorSetPos(ob_args[1]->lineno, ob_args[1]->colno, ob_args[1]->fname);
 		return NULL;
 	}
 
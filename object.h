@@ -29,6 +29,9 @@
 extern int DEBUG;
 extern int objdout;
 extern int INT_SIGNAL;
+extern int n_of_objects; /* number of slots used in object list */
+extern int n_free_objects; /* number of free slots in object list */
+extern int n_new_objects; /* number of objects created since the last collection */
 
 /* operation types */
 #define OPERATION_PLUS 0
@@ -58,12 +61,19 @@ extern object *objectNew(unsigned char type, size_t size); /* create a new objec
 extern void objectFree(object *obj); /* free an object */
 extern object *objectOperation(object *obj, object *other, unsigned int op_num); /* perform an operation (i.e., +, -, <, >, etc) on an object */
 extern void objectCollect(); /* garbage collection routine */
+extern void objectCollectRange(int start, int end); /* free unreferenced objects in slots start to end */
+extern void objectCollectDone(); /* finish a collection (reset counters and shrink object list) */
 extern void objectFreeAll(); /* free all objects */
 //extern object *objectRepresent(object *obj); /* represent an object */
 //extern void objectWrite(int fd, object *value); /* write a string value to a file descriptor */
 //extern object *objectRead(int fd, object *buf); /* read text from file */
 //extern void objectPrint(object *obj); /* wrapper for "write(FD_CONSOLE, represent(value));" */
 extern object *objectCopy(object *o); /* copy an object */
+extern object *objectWritable(object *o); /* get an array to change from a pointer to it (or the array itself), copying it first if it is a constant */
+extern size_t objectSize(object *o); /* get the size of an object from its type */
+extern void objectRef(object *o); /* take a reference to an object */
+extern void objectUnref(object *o); /* release a reference to an object and free it if it was the last one */
+extern void objectDisown(object *o); /* release a reference to an object without freeing it */
 
 /* builtin functions */
 extern object *builtinWrite(object **ob_args, void *ctx); /* write to a file descriptor */
@@ -0,0 +1,120 @@
+/*
+ *
+ * Copyright 2021, 2022 Elliot Kohlmyer
+ *
+ * This file is part of Mango.
+ *
+ * Mango is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Mango is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Mango.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* opcode.h -- instructions for linear bytecode */
+#ifndef _OPCODE_H
+#define _OPCODE_H
+
+/*
+ * operands follow the opcode byte:
+ *   i = 32 bit big endian integer
+ *   s = 32 bit offset into the string table
+ *   j = 32 bit offset into the code section
+ *   b = single byte
+ *   u = 32 bit slot index of a name in the current name table, assigned
+ *       by the compiler and rewritten by the interpreter if the name is
+ *       found in a different slot
+ *   t = 32 bit type id of the type name that follows it (TYPE_INT and
+ *       TYPE_CHR are written by the compiler, other types are written as
+ *       TYPE_NONE and rewritten by the interpreter the first time it looks
+ *       them up)
+ *
+ * instructions from OP_INCSLOT to OP_LOADSLOTF are only written by the
+ * peephole pass (compilerPeephole), each in place of a common sequence of
+ * instructions
+ */
+
+/* opcodes */
+#define OP_END			0x01 /* end of program or block */
+#define OP_POP			0x02 /* discard top of stack */
+#define OP_DUP			0x03 /* duplicate top of stack */
+#define OP_DUPX1		0x04 /* duplicate top of stack below the second item */
+#define OP_PUSHINT		0x05 /* i: push integer */
+#define OP_PUSHSTR		0x06 /* s: push string */
+#define OP_LOADNAME		0x07 /* s: push value of name */
+#define OP_LOADFIELD	0x08 /* s: replace struct on top of stack with a field */
+#define OP_STORENAME	0x09 /* s: pop value and assign it to name */
+#define OP_STOREFIELD	0x0A /* s: pop struct and value, assign value to field */
+#define OP_GETITEM		0x0B /* pop index and array, push item */
+#define OP_SETITEM		0x0C /* pop array, value and index, set item */
+#define OP_POSTINC		0x0D /* pop value, push old value and increment */
+#define OP_POSTDEC		0x0E /* pop value, push old value and decrement */
+#define OP_UNOP			0x0F /* b: unary operation on top of stack */
+#define OP_BINOP		0x10 /* b: binary operation on top two items */
+#define OP_DECLARE		0x11 /* t s s b u: pop value and declare variable (type, name, array | pointer | checked, slot) */
+#define OP_DECLUNDEF	0x12 /* t s s b u: declare variable with no value, pops array size if needed */
+#define OP_JMP			0x13 /* j: jump */
+#define OP_JMPF			0x14 /* j: pop condition and jump if false */
+#define OP_LOOP			0x15 /* end of loop iteration (interrupt check and garbage collection) */
+#define OP_CALL			0x16 /* i: call function below i arguments */
+#define OP_RETURN		0x17 /* pop value and return from function */
+#define OP_LEAVE		0x18 /* return from function without a value */
+#define OP_FUNCDEC		0x19 /* t s s b i (t s s b)...: push function declaration */
+#define OP_FUNCBODY		0x1A /* j: set body of function on top of stack, jump past body */
+#define OP_EXTERN		0x1B /* j: run block in the global scope */
+#define OP_STRUCT		0x1C /* s j: run block as struct body, push struct */
+#define OP_TYPEDEF		0x1D /* b t s s: define type (pointer, old type, new name) */
+/* 0x1E is unused (libraries are loaded from the library section, see bytecode.h) */
+#define OP_COLLECT		0x1F /* garbage collect after a top level statement */
+#define OP_LOADSLOT		0x20 /* u s: push value of name, looking in slot u first */
+#define OP_STORESLOT	0x21 /* u s: pop value and assign it to name, looking in slot u first */
+#define OP_TAILCALL		0x22 /* i: call function below i arguments in place of the current call, followed by RETURN */
+#define OP_CRETURN		0x23 /* pop value and return from function (type checked by compiler) */
+#define OP_CSETITEM		0x24 /* pop array, value and index, set item (type checked by compiler) */
+
+/* operations on ints and chrs (types checked by compiler), pop two values and push an int */
+#define OP_ADDINT		0x25 /* a + b */
+#define OP_SUBINT		0x26 /* a - b */
+#define OP_MULINT		0x27 /* a * b */
+#define OP_DIVINT		0x28 /* a / b */
+#define OP_MODINT		0x29 /* a % b */
+#define OP_EQINT		0x2A /* a == b */
+#define OP_NEINT		0x2B /* a != b */
+#define OP_LTINT		0x2C /* a < b */
+#define OP_GTINT		0x2D /* a > b */
+#define OP_NEGINT		0x2E /* pop int or chr and push it negated */
+
+/* superinstructions */
+#define OP_INCSLOT		0x2F /* u s: increment int or chr variable (LOADSLOT POSTINC POP) */
+#define OP_DECSLOT		0x30 /* u s: decrement int or chr variable (LOADSLOT POSTDEC POP) */
+#define OP_ADDIMM		0x31 /* i: add integer to int or chr on top of stack (PUSHINT ADDINT, PUSHINT SUBINT) */
+#define OP_CMPJMPF		0x32 /* b u s u s j: compare two variables with an int operation and jump if false (LOADSLOT LOADSLOT EQINT..GTINT JMPF) */
+#define OP_LOADSLOTF	0x33 /* u s s: push field of struct variable (LOADSLOT LOADFIELD) */
+
+/* written by the compiler after the superinstructions */
+#define OP_LOADFIELDREF	0x34 /* s: replace struct on top of stack with a field that may be changed in place or shared, boxing an inline int or chr */
+
+/* number of opcodes */
+#define OP_COUNT		0x35
+
+/* flags of DECLARE */
+#define OP_DECL_ARRAY	0x01 /* array */
+#define OP_DECL_POINTER	0x02 /* pointer */
+#define OP_DECL_CHECKED	0x04 /* type of value checked by compiler */
+
+/* read operands */
+#define OP_GETINT(p) ((int)(((unsigned int)(p)[0]<<24)|((unsigned int)(p)[1]<<16)|((unsigned int)(p)[2]<<8)|((unsigned int)(p)[3])))
+#define OP_GETUINT(p) ((unsigned int)OP_GETINT(p))
+
+/* write operands */
+#define OP_PUTUINT(p, v) do { (p)[0] = ((v) >> 24) & 0xFF; (p)[1] = ((v) >> 16) & 0xFF; (p)[2] = ((v) >> 8) & 0xFF; (p)[3] = (v) & 0xFF; } while (0)
+
+#endif /* _OPCODE_H */
@@ -262,9 +262,27 @@ extern int run(char *fname, int bc_mode) {
 			nodePrintTree(p->pn);
 		}
 
+		/* check types */
+		checkTree(p->pn);
+
+		/* error */
+		if (errorIsSet()) {
+
+			/* free stuff */
+			node *pn = p->pn;
+			parserFree(p);
+			lexerFree(l);
+			if (pn != NULL) nodeFree(pn);
+
+			/* print error and exit */
+			errorPrint();
+			return -1;
+		}
+
 		/* create bytecode */
 		bytecode *bc = bytecodeNew(p->pn, bc_mode);
 		bc->is_idat = argparse_get_flag(FLAG_IDATA);
+		bc->is_tree = argparse_get_flag(FLAG_TREE);
 		bytecodeComp(bc);
 
 		/* error */
@@ -285,6 +303,7 @@ extern int run(char *fname, int bc_mode) {
 
 			printf("\nBYTECODE:\n");
 			bytecodePrintf(bc);
+			if (!bc->is_tree) compilerPrint(bc);
 		}
 
 		/* figure out what to do with bytecode */
@@ -34,13 +34,17 @@ typedef struct _structobject {
 	char *struct_name; /* name of struct */
 	int is_templ; /* template = how the structure will look, otherwise = actual instance of struct */
 	int id; /* identifier number */
+	nameTable fields; /* table of names of an instance (names and hash index belong to the template) */
+	object *values[]; /* values of an instance's fields, in the order of the template's names (ints and chrs are inline, see IMM_IS) */
 } structobject;
 
 /* macros */
 #define O_STRUCT(o) ((structobject *)(o))
+#define STRUCT_SIZE(n) (sizeof(structobject) + sizeof(object *) * (n)) /* size of an instance with n fields */
 
 /* functions */
 extern object *structobjectNew(context *ctx, char *struct_name);
 extern object *structobjectInstance(object *s);
+extern object *structobjectBox(object *s, unsigned int idx);
 
 #endif /* _STRUCTOBJECT_H */
\ No newline at end of file
@@ -35,12 +35,20 @@ typedef struct {
 	object *st; /* struct */
 } typeobject;
 
+/* ids of builtin types (other type names get ids when they are first used) */
+#define TYPE_INT 0
+#define TYPE_CHR 1
+#define TYPE_NONE 0xFFFFFFFF /* id that hasn't been looked up yet */
+
 /* functions */
 extern object *typeNew(char *tp_name, unsigned char tp_type); /* creates a new type */
 extern void typeRegister(char *tp_name, unsigned char tp_type); /* creates a new type and adds it to a list */
 extern void typeRegisterStruct(char *tp_name, object *st); /* registers a struct */
+extern unsigned int typeId(char *tp_name); /* get the id of a type name */
 extern unsigned char typeGet(char *tp_name); /* get a new type */
+extern unsigned char typeGetId(unsigned int id); /* get a type from its id (0xFF if it isn't defined) */
 extern object *typeobjectGet(char *tp_name); /* get a full type object */
+extern object *typeobjectGetId(unsigned int id); /* get a full type object from its id */
 
 /* macros */
 #define O_TYPE(o) ((typeobject *)(o))
@@ -22,6 +22,9 @@
 /* virtual machine bytecode interpreter */
 #include "object.h"
 #include "vm.h"
+#include "interp.h"
+#include "compiler.h"
+#include "jit.h"
 #include "arrayobject.h"
 #include "intobject.h"
 #include "pointerobject.h"
@@ -44,8 +47,10 @@ int VM_DEBUG = -1;
 static vm **vm_list = NULL;
 static int vm_list_len = 0;
 static int vm_list_cap = 0;
-static int gbc_iter = 0; /* garbage collection iteration */
-static int gbc_len = 100; /* number of iterations of vmHandle before objectCollect is called */
+static int gbc_iter = -1; /* next slot to sweep (-1 when no collection is running) */
+int gbc_len = 1024; /* number of new objects before a collection starts (-gc) */
+int gbc_step = 4096; /* number of slots swept per step, 0 sweeps all at once (-gcstep) */
+int vm_max_stack = VM_MAX_STACK; /* maximum depth of function calls (--max-stack) */
 
 /* debug trace list for determining where a problem is coming from */
 object *debug_trace[8];
@@ -94,6 +99,22 @@ extern vm *vmNew(bytecode *bc) {
 
 	/* set context */
 	v->ctx = vmdctx;
+
+	/* no linear code yet */
+	v->bcflags = 0;
+	v->code = NULL;
+	v->code_len = 0;
+	v->strs = NULL;
+	v->lines = NULL;
+	v->n_lines = 0;
+	v->atoms = NULL;
+	v->strings = NULL;
+	v->pool = NULL;
+	v->n_pool = 0;
+	v->pos = 0;
+	v->fcache = NULL;
+	v->jit = NULL;
+	v->bc_pos = 0;
 	
 	if (bc != NULL) {
 
@@ -140,1549 +161,1866 @@ extern vm *vmNewFromFile(char *f) {
 	fclose(fp);
 
 	/* check the file header and make sure it is a mangobc file */
-	if (!(!memcmp(v->bc, "\x0bmc\x0e", 4) || !memcmp(v->bc, "\x0bml\x0f", 4)) || st.st_size < 8) {
+	if (st.st_size < 8 || !(!memcmp(v->bc, "\x0bmc\x0e", 4) || !memcmp(v->bc, "\x0bml\x0f", 4))) {
 
 		/* print error */
 		fprintf(stderr, "File '%s' is not a bytecode file!\n", f);
 
-		/* free vm and exit */
-		free(v->ctx);
-		free(v->bc);
-		free(v);
+		/* the vm is freed along with the others at exit (its context is shared) */
+		return NULL;
+	}
+
+	/* written before the header had a version (converted to the current version) */
+	if (((u8 *)v->bc)[4] == 0) {
+
+		bytecode *bc = bytecodeUpgrade((u8 *)v->bc, v->bc_len);
+
+		if (bc == NULL) {
+
+			fprintf(stderr, "File '%s' is not a bytecode file!\n", f);
+			return NULL;
+		}
+
+		v->bc = realloc(v->bc, bc->len);
+		v->bc_len = bc->len;
+		memcpy(v->bc, bc->bytes, bc->len);
+
+		bytecodeFree(bc);
+	}
+
+	/* version 2 differs only in that its linear bytecode isn't packed */
+	if (((u8 *)v->bc)[4] == 2)
+		((u8 *)v->bc)[4] = BYTECODE_VERSION;
+
+	/* written by a different version */
+	if (((u8 *)v->bc)[4] != BYTECODE_VERSION) {
+
+		/* print error */
+		fprintf(stderr, "File '%s' was compiled by a different version of mango!\n", f);
+
+		/* the vm is freed along with the others at exit (its context is shared) */
 		return NULL;
 	}
 
+	/* linear bytecode is packed in files (expanded to the fixed size operands the interpreter rewrites in place) */
+	if (((u8 *)v->bc)[7] & BYTECODE_FLAG_PACKED) {
+
+		bytecode *bc = compilerUnpack((u8 *)v->bc, v->bc_len);
+
+		if (bc == NULL) {
+
+			fprintf(stderr, "Invalid bytecode in file '%s'!\n", f);
+			return NULL;
+		}
+
+		v->bc = realloc(v->bc, bc->len);
+		v->bc_len = bc->len;
+		memcpy(v->bc, bc->bytes, bc->len);
+
+		bytecodeFree(bc);
+	}
+
 	/* return vm pointer */
 	return v;
 }
 
-/* return an object from handler */
-extern object *vmHandle(vm *v, unsigned int i) {
+/* create the constant object of a string literal (shared by every use of it, see objectWritable) */
+extern object *vmStringNew(char *s) {
 
-	gbc_iter++; /* advance garbage collection iterator */
+	int len = strlen(s) + 1;
 
-	object *o = NULL;
+	/* create an array object */
+	object *a = arrayobjectNew(len, OBJECT_CHR);
 
-	if (VM_DEBUG) fprintf(debug_file, "[vm] node type %02x\n", (((u8 *)v->bc)[i]));
+	/* copy string value */
+	memcpy(O_ARRAY(a)->n_start, s, len);
 
-	/* check options */
+	/* create pointer */
+	object *o = pointerobjectNew(OBJECT_CHR, (void *)a);
 
-	/* create a string object */
-	if (((u8 *)v->bc)[i] == 0x9E) {
+	a->flags |= OBJECT_CONST;
+	o->flags |= OBJECT_CONST;
 
-		if (!IS_IDAT(v->bcflags)) {
-		
-			/* get length of string */
-			char *stocp = &((char *)v->bc)[i + 1];
-			int len = strlen(stocp) + 1;
-		
-			/* create an array object */
-			o = arrayobjectNew(len, OBJECT_CHR);
-		
-			/* copy string value */
-			strcpy(O_ARRAY(o)->n_start, stocp);
-		
-			/* advance number of bytes */
-			v->nofbytes += (len + 1);
+	/* kept until the program ends */
+	objectRef(o);
 
-			/* create pointer */
-			o = pointerobjectNew(OBJECT_CHR, (void *)o);
-		
-		} else {
+	return o;
+}
 
-			/* get length of string */
-			char *stocp = v->idata[((u8 *)v->bc)[i+1]] + 1;
-			int len = strlen(stocp) + 1;
+/* create a string object */
+extern object *vmHandleString(vm *v, unsigned int i) {
 
-			/* create an array object */
-			object *a = arrayobjectNew(len, OBJECT_CHR);
+	/* created on first use */
+	if (v->strings == NULL)
+		v->strings = (object **)calloc(v->bc_len, sizeof(object *));
 
-			/* copy string value */
-			strcpy(O_ARRAY(a)->n_start, stocp);
+	/* reference to constant pool */
+	if (IS_IDAT(v->bcflags)) {
 
-			/* advance number of bytes */
-			v->nofbytes += 2;
+		unsigned int len;
+		unsigned int k = bytecodeGetVarint(&((u8 *)v->bc)[i + 1], &len);
 
-			/* create pointer */
-			o = pointerobjectNew(OBJECT_CHR, (void *)a);
-		}
+		v->nofbytes += len + 1;
 
-		o->fname = v->ctx->fn;
+		/* integer */
+		if (*v->pool[k] == 0x9B)
+			return intobjectNew(bytecodeGetInt(v->pool[k] + 1, &len));
 
-		/* debug info */
-		if (VM_DEBUG) fprintf(debug_file, "[vm] created string with value '%s'\n", O_ARRAY(O_PTR(o)->val)->n_start);
+		if (v->strings[k] == NULL)
+			v->strings[k] = vmStringNew((char *)v->pool[k] + 1);
+
+		return v->strings[k];
 	}
 
-	/* create an int object */
-	if (((u8 *)v->bc)[i] == 0x9B) {
+	object **s = &v->strings[v->bc_pos + i];
 
-		/* get int value */
-		int val = (((u8*)v->bc)[i+1]<<24) | (((u8*)v->bc)[i+2]<<16) | (((u8*)v->bc)[i+3]<<8) | (((u8*)v->bc)[i+4]);
+	if (*s == NULL)
+		*s = vmStringNew(&((char *)v->bc)[i + 1]);
 
-		/* create object */
-		o = intobjectNew(val);
-		o->fname = v->ctx->fn;
+	object *o = *s;
 
-		/* debug info */
-		if (VM_DEBUG) fprintf(debug_file, "[vm] created integer object with value %d\n", O_INT(o)->val);
+	/* advance number of bytes */
+	v->nofbytes += O_ARRAY(O_PTR(o)->val)->n_len + 1;
 
-		/* advance number of bytes */
-		v->nofbytes += 5;
-	}
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[vm] created string with value '%s'\n", O_ARRAY(O_PTR(o)->val)->n_start);
 
-	/* unary operation */
-	if (((u8 *)v->bc)[i] == 0x9C) {
+	return o;
+}
 
-		/* get operation */
-		u8 op = ((u8 *)v->bc)[i + 1];
-		v->nofbytes += 2;
+/* create an int object */
+extern object *vmHandleInt(vm *v, unsigned int i) {
 
-		/* get object */
-		object *a = vmHandle(v, v->lowbi + v->nofbytes);
+	object *o = NULL;
+
+	/* get int value */
+	unsigned int len;
+	int val = bytecodeGetInt(&((u8 *)v->bc)[i + 1], &len);
 
-		/* get error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+	/* create object */
+	o = intobjectNew(val);
+
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[vm] created integer object with value %d\n", O_INT(o)->val);
+
+	/* advance number of bytes */
+	v->nofbytes += len + 1;
+
+	return o;
+}
+
+/* unary operation */
+extern object *vmHandleUnOp(vm *v, unsigned int i) {
+
+	object *o = NULL;
+
+	/* get operation */
+	u8 op = ((u8 *)v->bc)[i + 1];
+	v->nofbytes += 2;
+
+	/* get object */
+	object *a = vmHandle(v, v->lowbi + v->nofbytes);
+
+	/* get error info */
+	unsigned int pos = vmNodePos(v, i);
+
+	/* error */
+	if (a == NULL || errorIsSet())
+		return NULL;
+
+	/* negate */
+	if (op == TOKEN_MINUS) {
+
+		/* multiply */
+		o = objectOperation(a, intobjectNew(-1), TOKEN_MUL);
 
 		/* error */
-		if (a == NULL || errorIsSet())
+		if (o == NULL || errorIsSet())
 			return NULL;
+	}
 
-		/* negate */
-		if (op == TOKEN_MINUS) {
+	/* increment */
+	else if (op == TOKEN_INC) {
 
-			/* multiply */
-			o = objectOperation(a, intobjectNew(-1), TOKEN_MUL);
+		/* add one */
+		O_INT(a)->val++;
+		o = a;
+	}
 
-			/* error */
-			if (o == NULL || errorIsSet())
-				return NULL;
-		}
+	/* decrement */
+	else if (op == TOKEN_DEC) {
 
-		/* increment */
-		else if (op == TOKEN_INC) {
+		/* sub one */
+		O_INT(a)->val--;
+		o = a;
+	}
 
-			/* add one */
-			O_INT(a)->val++;
-			o = a;
-		}
+	/* '&' */
+	else if (op == TOKEN_AMP) {
 
-		/* decrement */
-		else if (op == TOKEN_DEC) {
+		/* get address */
+		o = pointerobjectNew(a->type, (void *)a);
+	}
 
-			/* sub one */
-			O_INT(a)->val--;
-			o = a;
+	/* '*' */
+	else if (op == TOKEN_MUL) {
+
+		/* not a pointer */
+		if (!(a->type & OBJECT_POINTER) || (O_PTR(a)->val == NULL)) {
+
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_ILLEGALOP,
+					 "Attempt to dereference a non-pointer");
+			vmSetErrorPos(v, pos);
+			return NULL;
 		}
 
-		/* '&' */
-		else if (op == TOKEN_AMP) {
+		/* get dereffed value */
+		o = O_OBJ(O_PTR(a)->val);
 
-			/* get address */
-			o = pointerobjectNew(a->type, (void *)a);
+		/* invalid pointer */
+		if (o == NULL) {
+
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_INVALIDPTR,
+					 "Invalid pointer (null)");
+			vmSetErrorPos(v, pos);
+			return NULL;
 		}
+	}
+
+	else o = a;
+
+	/* debug info */
+	if (VM_DEBUG) {
+		
+		fprintf(debug_file, "[vm] interpreted unary operation with op code %d\n", op);
+		if (o->type == OBJECT_INT) printf("[vm] unary operation value is %d\n", O_INT(o)->val);
+	}
 
-		/* '*' */
-		else if (op == TOKEN_MUL) {
+	return o;
+}
 
-			/* not a pointer */
-			if (!(a->type & OBJECT_POINTER) || (O_PTR(a)->val == NULL)) {
+/* binary operation */
+extern object *vmHandleBinOp(vm *v, unsigned int i) {
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Attempt to dereference a non-pointer");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	object *o = NULL;
 
-			/* get dereffed value */
-			o = O_OBJ(O_PTR(a)->val);
+	/* get operation */
+	u8 op = ((u8 *)v->bc)[i + 1];
+	v->nofbytes += 2;
 
-			/* invalid pointer */
-			if (o == NULL) {
+	/* get first object */
+	object *a = vmHandle(v, v->lowbi + v->nofbytes);
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_INVALIDPTR,
-						 "Invalid pointer (null)");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
-		}
+	/* error */
+	if (a == NULL || errorIsSet())
+		return NULL;
 
-		else o = a;
+	unsigned int pos = v->pos; /* errors are reported at the first object */
 
-		/* debug info */
-		if (VM_DEBUG) {
-			
-			fprintf(debug_file, "[vm] interpreted unary operation with op code %d\n", op);
-			if (o->type == OBJECT_INT) printf("[vm] unary operation value is %d\n", O_INT(o)->val);
-		}
+	/* keep the first object while the second one is evaluated */
+	objectRef(a);
+
+	/* get second object */
+	object *b = vmHandle(v, v->lowbi + v->nofbytes);
+
+	/* error */
+	if (b == NULL || errorIsSet()) {
+
+		objectUnref(a);
+		return NULL;
 	}
 
-	/* binary operation */
-	if (((u8 *)v->bc)[i] == 0x9D) {
+	/* operate on object (the result is a new object, so temporary operands can go now) */
+	objectRef(b);
+	object *c = objectOperation(a, b, op);
 
-		/* get operation */
-		u8 op = ((u8 *)v->bc)[i + 1];
-		v->nofbytes += 2;
+	objectUnref(a);
+	objectUnref(b);
 
-		/* get first object */
-		object *a = vmHandle(v, v->lowbi + v->nofbytes);
+	/* error */
+	if (c == NULL || errorIsSet()) {
 
-		/* error */
-		if (a == NULL || errorIsSet())
-			return NULL;
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
 
-		/* get second object */
-		object *b = vmHandle(v, v->lowbi + v->nofbytes);
+	/* set object */
+	o = c;
 
-		/* error */
-		if (b == NULL || errorIsSet())
-			return NULL;
+	/* debug */
+	if (VM_DEBUG) {
+		
+		fprintf(debug_file, "[vm] interpreted binary operation with operation %d\n", op);
+		if (c->type == OBJECT_INT) printf("[vm] binary operation value is %d\n", O_INT(c)->val);
+	}
 
-		/* operate on object */
-		object *c = objectOperation(a, b, op);
+	return o;
+}
 
-		/* error */
-		if (c == NULL || errorIsSet())
-			return NULL;
+/* get the inline cache entry of a field name in the code */
+extern vmFieldCache *vmFieldEntry(vm *v, unsigned int pos, char *name) {
 
-		/* set object */
-		o = c;
+	/* create caches */
+	if (v->fcache == NULL)
+		v->fcache = (vmFieldCache *)calloc(VM_FIELD_CACHE, sizeof(vmFieldCache));
 
-		/* debug */
-		if (VM_DEBUG) {
-			
-			fprintf(debug_file, "[vm] interpreted binary operation with operation %d\n", op);
-			if (c->type == OBJECT_INT) printf("[vm] binary operation value is %d\n", O_INT(c)->val);
-		}
+	vmFieldCache *c = &v->fcache[pos & (VM_FIELD_CACHE - 1)];
+
+	/* entry belongs to another name, take it over */
+	if (c->pos != pos) {
+
+		c->pos = pos;
+		c->templ = NULL;
 	}
 
-	/* assign to an existing variable */
-	if ((((u8 *)v->bc)[i] == 0xD2) || (((u8 *)v->bc)[i] == 0xDD)) {
+	return c;
+}
 
-		v->nofbytes += 2;
+/* get the slot of a field in a struct (n_of_names if it does not exist) */
+extern unsigned int vmFieldIndex(vmFieldCache *c, object *s, char *name) {
 
-		/* get number of items */
-		unsigned int n = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+	nameTable *nt = O_STRUCT(s)->nt;
 
-		nameTable *ntc = v->ctx->nt; /* current table of names */
-		char *cn; /* current name we are looking at */
-		int exists = 1; /* to determine an undefined name */
+	/* instances share the layout of their template, so the slot is known */
+	if (c->templ == O_STRUCT(s)->parent && c->slot < nt->n_of_names && nt->names[c->slot] == c->atom)
+		return c->slot;
 
-		/* loop through names */
-		for (int j = 0; j < (n-1); j++) {
+	/* look the field up and remember it */
+	unsigned int idx = namesIndex(nt, name);
+
+	if (idx < nt->n_of_names) {
+
+		c->templ = O_STRUCT(s)->parent;
+		c->atom = nt->names[idx];
+		c->slot = idx;
+	}
 
-			/* get name and advance forward */
-			cn = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-			v->nofbytes += strlen(cn) + 1;
+	return idx;
+}
 
-			/* get object associated with name */
-			if (ntc != NULL) {
+/* assign to an existing variable */
+extern object *vmHandleVarAsg(vm *v, unsigned int i) {
 
-				/* name */
-				object *st = namesGet(ntc, cn);
+	object *o = NULL;
 
-				/* non-existant */
-				if (st == NULL) {
+	v->nofbytes++;
 
-					ntc = NULL;
-					exists = 0;
-					continue;
-				}
+	/* get number of items */
+	unsigned int n = vmNextInt(v);
 
-				/* value is not a struct */
-				if ((st->type & 0x3) != OBJECT_STRUCT) {
+	nameTable *ntc = v->ctx->nt; /* current table of names */
+	object *sto = NULL; /* struct that ntc belongs to */
+	vmFieldCache *fc = NULL; /* inline cache of the current field */
+	char *cn; /* current name we are looking at */
+	unsigned int len; /* bytes taken by the name */
+	int exists = 1; /* to determine an undefined name */
 
-					ntc = NULL;
-					continue;
-				}
+	/* loop through names */
+	for (int j = 0; j < (n-1); j++) {
 
-				/* struct pointer */
-				else if (st->type & OBJECT_POINTER)
-					st = O_OBJ(O_PTR(st)->val);
+		/* get name and advance forward */
+		cn = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
 
-				ntc = O_STRUCT(st)->nt;
+		if (j > 0)
+			fc = vmFieldEntry(v, v->bc_pos + v->lowbi + v->nofbytes, cn);
+
+		v->nofbytes += len;
+
+		/* get object associated with name */
+		if (ntc != NULL) {
+
+			object *st;
+
+			/* name */
+			if (sto == NULL) st = namesGet(ntc, cn);
+
+			/* struct field */
+			else {
+
+				unsigned int idx = vmFieldIndex(fc, sto, cn);
+				st = (idx < ntc->n_of_names)? structobjectBox(sto, idx): namesGet(ntc, cn);
 			}
-		}
 
-		/* get last name */
-		cn = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-		v->nofbytes += strlen(cn) + 1;
+			/* non-existant */
+			if (st == NULL) {
+
+				ntc = NULL;
+				exists = 0;
+				continue;
+			}
 
-		/* array index */
-		object *arr_idx;
-		if ((((u8 *)v->bc)[i]) == 0xDD) {
+			/* value is not a struct */
+			if ((st->type & 0x3) != OBJECT_STRUCT) {
+
+				ntc = NULL;
+				continue;
+			}
 
-			arr_idx = vmHandle(v, v->lowbi + v->nofbytes);
+			/* struct pointer */
+			else if (st->type & OBJECT_POINTER)
+				st = O_OBJ(O_PTR(st)->val);
 
-			/* error */
-			if (arr_idx == NULL || errorIsSet())
-				return NULL;
+			sto = st;
+			ntc = O_STRUCT(st)->nt;
 		}
+	}
 
-		/* get value object */
-		object *val = vmHandle(v, v->lowbi + v->nofbytes);
+	/* get last name */
+	cn = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+
+	if (n > 1)
+		fc = vmFieldEntry(v, v->bc_pos + v->lowbi + v->nofbytes, cn);
+
+	v->nofbytes += len;
+
+	/* array index */
+	object *arr_idx;
+	if ((((u8 *)v->bc)[i]) == 0xDD) {
+
+		arr_idx = vmHandle(v, v->lowbi + v->nofbytes);
 
 		/* error */
-		if (val == NULL || errorIsSet())
+		if (arr_idx == NULL || errorIsSet())
 			return NULL;
 
-		/* get error information */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+		/* keep the index while the value is evaluated */
+		objectRef(arr_idx);
+	}
+
+	/* get value object */
+	object *val = vmHandle(v, v->lowbi + v->nofbytes);
+
+	if ((((u8 *)v->bc)[i]) == 0xDD)
+		objectDisown(arr_idx);
+
+	/* error */
+	if (val == NULL || errorIsSet())
+		return NULL;
+
+	/* get error information */
+	unsigned int pos = vmNodePos(v, i);
+
+	/* undefined name */
+	if (!exists) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined name");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	/* not a struct */
+	if (ntc == NULL) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	object *curobj;
+	unsigned int idx = 0;
+
+	/* struct field */
+	if (sto != NULL) {
+
+		idx = vmFieldIndex(fc, sto, cn);
+		curobj = (idx < ntc->n_of_names)? structobjectBox(sto, idx): namesGet(ntc, cn);
+	}
+	else curobj = namesGet(ntc, cn);
+
+	/* not a value */
+	if (curobj == NULL) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined name");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	/* check types */
+	if ((curobj->type != val->type) && ((((u8 *)v->bc)[i]) != 0xDD)) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Mismatched types");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	/* if array */
+	if ((((u8 *)v->bc)[i]) == 0xDD) {
 
-		/* undefined name */
-		if (!exists) {
+		/* dereference if it is a pointer (copying a constant array) */
+		object *a = objectWritable(curobj);
+
+		/* check if it is an array */
+		if (!(a->type & OBJECT_ARRAY)) {
 
 			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_UNDEFINEDNAME,
-					 "Undefined name");
-			errorSetPos(lineno, colno, v->ctx->fn);
+					 ERROR_CODE_ILLEGALOP,
+					 "Illegal operation");
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
-		/* not a struct */
-		if (ntc == NULL) {
+		/* check type of array index */
+		if (arr_idx->type != OBJECT_INT) {
 
 			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_ILLEGALOP,
 					 "Illegal operation");
-			errorSetPos(lineno, colno, v->ctx->fn);
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
-		object *curobj;
-
-		/* not a value */
-		if ((curobj = namesGet(ntc, cn)) == NULL) {
+		/* check length of array */
+		if (O_INT(arr_idx)->val >= O_ARRAY(a)->n_len) {
 
 			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_UNDEFINEDNAME,
-					 "Undefined name");
-			errorSetPos(lineno, colno, v->ctx->fn);
+					 ERROR_CODE_ILLEGALOP,
+					 "Illegal operation");
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
 		/* check types */
-		if ((curobj->type != val->type) && ((((u8 *)v->bc)[i]) != 0xDD)) {
+		if (((a->type & ~(OBJECT_ARRAY)) != val->type) || ((a->type & OBJECT_POINTER) != (val->type & OBJECT_POINTER))) {
 
 			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_ILLEGALOP,
-					 "Mismatched types");
-			errorSetPos(lineno, colno, v->ctx->fn);
+					 "Illegal operation");
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
-		/* if array */
-		if ((((u8 *)v->bc)[i]) == 0xDD) {
-
-			/* dereference if it is a pointer */
-			object *a = curobj;
-			if (a->type & OBJECT_POINTER) a = O_OBJ(O_PTR(a)->val);
+		/* set value */
+		if (O_ARRAY(a)->a_type & OBJECT_POINTER) ((void **)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_PTR(val)->val;
+		else if (O_ARRAY(a)->a_type == OBJECT_INT) ((int *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_INT(val)->val;
+		else if (O_ARRAY(a)->a_type == OBJECT_CHR) ((char *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_CHR(val)->val;
+	}
+	else {
 
-			/* check if it is an array */
-			if (!(a->type & OBJECT_ARRAY)) {
+		/* set value */
+		if (sto != NULL) namesSetAt(ntc, idx, cn, val);
+		else namesSet(ntc, cn, val);
+	}
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	o = val;
 
-			/* check type of array index */
-			if (arr_idx->type != OBJECT_INT) {
+	/* debug info */
+	if (VM_DEBUG) {
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+		fprintf(debug_file, "[vm] set object '%s' with type %d in nameTable %p.\n", cn, val->type, ntc);
+	}
 
-			/* check length of array */
-			if (O_INT(arr_idx)->val >= O_ARRAY(a)->n_len) {
+	return o;
+}
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+/* get a variable */
+extern object *vmHandleVarAcc(vm *v, unsigned int i) {
 
-			/* check types */
-			if (((a->type & ~(OBJECT_ARRAY)) != val->type) || ((a->type & OBJECT_POINTER) != (val->type & OBJECT_POINTER))) {
+	object *o = NULL;
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	u8 _v = (((u8 *)v->bc)[i]);
 
-			/* set value */
-			if (O_ARRAY(a)->a_type & OBJECT_POINTER) ((void **)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_PTR(val)->val;
-			else if (O_ARRAY(a)->a_type == OBJECT_INT) ((int *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_INT(val)->val;
-			else if (O_ARRAY(a)->a_type == OBJECT_CHR) ((char *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val] = O_CHR(val)->val;
-		}
-		else {
+	/* increase byte number */
+	v->nofbytes++;
 
-			/* set value */
-			namesSet(ntc, cn, val);
-		}
+	/* get number of items */
+	unsigned int n = vmNextInt(v);
 
-		o = val;
+	/* first name */
+	unsigned int len;
+	char *first = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
+	char *first2 = first;
 
-		/* debug info */
-		if (VM_DEBUG) {
+	/* get object */
+	object *f = namesGet(v->ctx->nt, first);
 
-			fprintf(debug_file, "[vm] set object '%s' with type %d in nameTable %p.\n", cn, val->type, ntc);
-		}
+	/* if it a struct pointer */
+	if ((n > 1) && (f != NULL) && ((f->type & 0x3) == OBJECT_STRUCT) && (f->type & OBJECT_POINTER)) {
+		f = O_OBJ(O_PTR(f)->val);
 	}
 
-	/* get a variable */
-	if (((((u8 *)v->bc)[i]) == 0xD6) || ((((u8 *)v->bc)[i]) == 0xD3) || ((((u8 *)v->bc)[i]) == 0xD4) || ((((u8 *)v->bc)[i]) == 0x9A)) {
+	int j = 1;
 
-		u8 _v = (((u8 *)v->bc)[i]);
+	nameTable *ntc = v->ctx->nt;
+	context *nctx = v->ctx;
 
-		/* increase byte number */
-		v->nofbytes += 2;
+	/* more names */
+	if (n > 1) {
 
-		/* get number of items */
-		unsigned int n = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 5;
-
-		/* first name */
-		char *first = &(((char *)v->bc)[v->lowbi + v->nofbytes]);
-		v->nofbytes += strlen(first) + 1;
-		char *first2 = first;
-
-		/* get object */
-		object *f = namesGet(v->ctx->nt, first);
+		/* loop through names */
+		for (int i = 1; i < n; i++) {
 
-		/* if it a struct pointer */
-		if ((n > 1) && (f != NULL) && ((f->type & 0x3) == OBJECT_STRUCT) && (f->type & OBJECT_POINTER)) {
-			f = O_OBJ(O_PTR(f)->val);
-		}
+			first = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
 
-		int j = 1;
+			vmFieldCache *fc = vmFieldEntry(v, v->bc_pos + v->lowbi + v->nofbytes, first);
+			v->nofbytes += len;
 
-		nameTable *ntc = v->ctx->nt;
-		context *nctx = v->ctx;
+			/* non-existant */
+			if (f == NULL)
+				continue;
 
-		/* more names */
-		if (n > 1) {
+			/* not a struct */
+			if ((f == NULL) || ((f->type & 0x3) != OBJECT_STRUCT)) {
 
-			/* loop through names */
-			for (int i = 1; i < n; i++) {
+				/* do nothing */
+			} else {
 
-				first = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-				v->nofbytes += strlen(first) + 1;
+				j++; /* advance */
 
-				/* non-existant */
+				/* struct pointer */
+				if (f->type & OBJECT_POINTER)
+					f = O_OBJ(O_PTR(f)->val);
+				
+				/* get next object */
+				ntc = O_STRUCT(f)->nt;
+				nctx = O_STRUCT(f)->ctx;
+
+				/* the tree works on objects, so inline fields get boxed */
+				unsigned int idx = vmFieldIndex(fc, f, first);
+				f = (idx < ntc->n_of_names)? structobjectBox(f, idx): namesGet(ntc, first);
+
+				/* skip if NULL */
 				if (f == NULL)
 					continue;
 
-				/* not a struct */
-				if ((f == NULL) || ((f->type & 0x3) != OBJECT_STRUCT)) {
+				/* if f is a pointer to a struct */
+				if (f->type == (OBJECT_STRUCT | OBJECT_POINTER) && i < n-1)
+					f = O_OBJ(O_PTR(f)->val);
+			}
+		}
+	}
 
-					/* do nothing */
-				} else {
+	/* get getitem values */
+	object *arr_idx;
 
-					j++; /* advance */
+	if (_v == 0x9A) {
 
-					/* struct pointer */
-					if (f->type & OBJECT_POINTER)
-						f = O_OBJ(O_PTR(f)->val);
-					
-					/* get next object */
-					ntc = O_STRUCT(f)->nt;
-					nctx = O_STRUCT(f)->ctx;
-					f = namesGet(ntc, first);
+		arr_idx = vmHandle(v, v->lowbi + v->nofbytes);
 
-					/* skip if NULL */
-					if (f == NULL)
-						continue;
+		/* error */
+		if (arr_idx == NULL || errorIsSet())
+			return NULL;
+	}
 
-					/* if f is a pointer to a struct */
-					if (f->type == (OBJECT_STRUCT | OBJECT_POINTER) && i < n-1)
-						f = O_OBJ(O_PTR(f)->val);
-				}
-			}
-		}
+	/* error info */
+	unsigned int pos = vmNodePos(v, i);
 
-		/* get getitem values */
-		object *arr_idx;
+	/* the object was not found */
+	if (f == NULL) {
 
-		if (_v == 0x9A) {
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined name");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
 
-			arr_idx = vmHandle(v, v->lowbi + v->nofbytes);
+	/* attempt to get something from a non-struct (illegal operation) */
+	if (j < n) {
 
-			/* error */
-			if (arr_idx == NULL || errorIsSet())
-				return NULL;
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	/* increment */
+	if (_v == 0xD3)
+		o = intobjectNew(O_INT(f)->val++);
+
+	/* decrement */
+	else if (_v == 0xD4)
+		o = intobjectNew(O_INT(f)->val--);
+
+	/* getitem */
+	else if (_v == 0x9A) {
+
+		object *a = f;
+
+		/* dereference object if it is a pointer */
+		if (a->type & OBJECT_POINTER) {
+
+			a = O_OBJ(O_PTR(a)->val);
 		}
 
-		/* error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+		/* no value */
+		if (a == NULL) {
+
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_ILLEGALOP,
+					 "Pointer value is null");
+			vmSetErrorPos(v, pos);
+			return NULL;
+		}
 
-		/* the object was not found */
-		if (f == NULL) {
+		/* check if it is an array */
+		if (!(a->type & OBJECT_ARRAY)) {
 
+			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_UNDEFINEDNAME,
-					 "Undefined name");
-			errorSetPos(lineno, colno, v->ctx->fn);
+					 ERROR_CODE_ILLEGALOP,
+					 "Illegal operation");
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
-		/* attempt to get something from a non-struct (illegal operation) */
-		if (j < n) {
+		/* check the array index */
+		if (arr_idx->type != OBJECT_INT) {
 
+			/* set error */
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_ILLEGALOP,
 					 "Illegal operation");
-			errorSetPos(lineno, colno, v->ctx->fn);
+			vmSetErrorPos(v, pos);
 			return NULL;
 		}
 
-		/* increment */
-		if (_v == 0xD3)
-			o = intobjectNew(O_INT(f)->val++);
+		/* "get" the item */
+		if (O_ARRAY(a)->a_type & OBJECT_POINTER) o = pointerobjectNew(a->type & 0x3, ((void **)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
+		else if (O_ARRAY(a)->a_type == OBJECT_INT) o = intobjectNew(((int *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
+		else if (O_ARRAY(a)->a_type == OBJECT_CHR) o = charobjectNew(((char *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
+	}
 
-		/* decrement */
-		else if (_v == 0xD4)
-			o = intobjectNew(O_INT(f)->val--);
+	/* otherwise, we have gotten the object */
+	else o = f;
 
-		/* getitem */
-		else if (_v == 0x9A) {
+	/* debug info */
+	if (VM_DEBUG) {
 
-			object *a = f;
+		if (_v == 0x9A) fprintf(debug_file, "[vm] retreived object '%s[%d]' with type %d.\n", first, O_INT(arr_idx)->val, o->type);
+		else fprintf(debug_file, "[vm] retreived object '%s' with type %d from nameTable %p(%d) and context '%s'.\n", first, o->type, ntc, ntc->id, nctx->sn);
+	}
 
-			/* dereference object if it is a pointer */
-			if (a->type & OBJECT_POINTER) {
+	return o;
+}
 
-				a = O_OBJ(O_PTR(a)->val);
-			}
+/* create an undefined variable */
+extern object *vmHandleVarUndefined(vm *v, unsigned int i) {
 
-			/* no value */
-			if (a == NULL) {
+	object *o = NULL;
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Pointer value is null");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	/* increase byte number */
+	v->nofbytes += 2;
 
-			/* check if it is an array */
-			if (!(a->type & OBJECT_ARRAY)) {
+	/* get variable type name */
+	unsigned int len;
+	char *tp_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
+	u8 ob_type = 0; /* object type value */
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	/* get object name */
+	char *ob_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
 
-			/* check the array index */
-			if (arr_idx->type != OBJECT_INT) {
+	/* array and pointer */
+	ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes]? OBJECT_ARRAY: 0);
+	ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes + 1]? OBJECT_POINTER: 0);
+	v->nofbytes += 2;
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Illegal operation");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	/* get error info */
+	unsigned int pos = vmNodePos(v, i);
 
-			/* "get" the item */
-			if (O_ARRAY(a)->a_type & OBJECT_POINTER) o = pointerobjectNew(a->type & 0x3, ((void **)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
-			else if (O_ARRAY(a)->a_type == OBJECT_INT) o = intobjectNew(((int *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
-			else if (O_ARRAY(a)->a_type == OBJECT_CHR) o = charobjectNew(((char *)O_ARRAY(a)->n_start)[O_INT(arr_idx)->val]);
-		}
+	/* get object type from name */
+	unsigned int tp_id = typeId(tp_name);
+	unsigned char tt = typeGetId(tp_id);
 
-		/* otherwise, we have gotten the object */
-		else o = f;
+	/* failed to get type */
+	if (tt == 0xFF) {
 
-		/* debug info */
-		if (VM_DEBUG) {
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Unknown type");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
+
+	/* set type */
+	ob_type = tt | ob_type;
 
-			if (_v == 0x9A) fprintf(debug_file, "[vm] retreived object '%s[%d]' with type %d.\n", first, O_INT(arr_idx)->val, o->type);
-			else fprintf(debug_file, "[vm] retreived object '%s' with type %d from nameTable %p(%d) and context '%s'.\n", first, o->type, ntc, ntc->id, nctx->sn);
+	/* get array object */
+	if (ob_type & OBJECT_ARRAY) {
+
+		object *asz = vmHandle(v, v->lowbi + v->nofbytes);
+
+		/* error */
+		if (asz == NULL || errorIsSet())
+			return NULL;
+
+		int nsz_arr;
+
+		/* array size should be an integer */
+		if (asz->type != OBJECT_INT) {
+
+			/* set error and exit */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_ILLEGALOP,
+					 "Array size must be an integer");
+			vmSetErrorPos(v, pos);
+			return NULL;
 		}
+
+		/* get array size */
+		nsz_arr = O_INT(asz)->val;
+
+		/* create an array object */
+		object *a = arrayobjectNew(nsz_arr, ob_type & 0x3);
+
+		o = pointerobjectNew(ob_type & 0x3, (void *)a);
 	}
 
-	/* create an undefined variable */
-	if (((u8 *)v->bc)[i] == 0xD7) {
+	/* pointer */
+	else if (ob_type & OBJECT_POINTER) {
 
-		/* increase byte number */
-		v->nofbytes += 3;
+		/* create pointer object */
+		o = pointerobjectNew(ob_type & 3, NULL);
+	}
 
-		/* get variable type name */
-		char *tp_name = &(((char *)v->bc)[i + 3]);
-		v->nofbytes += strlen(tp_name) + 2;
-		u8 ob_type = 0; /* object type value */
+	/* struct */
+	else if (ob_type == OBJECT_STRUCT) {
 
-		/* get object name */
-		char *ob_name = &(((char *)v->bc)[i + strlen(tp_name) + 5]);
-		v->nofbytes += strlen(ob_name) + 1;
+		/* get struct type object */
+		object *tp = typeobjectGetId(tp_id);
 
-		/* array and pointer */
-		ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes]? OBJECT_ARRAY: 0);
-		ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes + 1]? OBJECT_POINTER: 0);
-		v->nofbytes += 2;
+		/* copy struct */
+		o = structobjectInstance(O_TYPE(tp)->st);
+	}
 
-		/* get error info */
-		unsigned int f_ln;
-		unsigned int f_col;
-		vmGetErrorInfo(v, &f_ln, &f_col);
+	/* otherwise */
+	else {
 
-		/* get object type from name */
-		if (!strcmp(tp_name, "int")) ob_type = OBJECT_INT | ob_type;
-		else if (!strcmp(tp_name, "chr")) {
+		/* create an int or char */
+		o = intcharobjectNew(((ob_type & 3) != OBJECT_INT)? 1: 0, 0);
+	}
 
-			ob_type = OBJECT_CHR | ob_type;
-		}
-		else {
+	/* set name */
+	namesSet(v->ctx->nt, ob_name, o);
 
-			/* get type from list */
-			unsigned char tt = typeGet(tp_name);
+	/* debug info */
+	if (VM_DEBUG) {
+		
+		fprintf(debug_file, "[vm] created undefined variable with type '%s", tp_name);
+		if (ob_type & OBJECT_POINTER) fprintf(debug_file, " *");
+		if (ob_type & OBJECT_ARRAY) fprintf(debug_file, "[]");
+		fprintf(debug_file, "' and with name '%s'\n", ob_name);
+	}
 
-			/* failed to get type */
-			if (tt == 0xFF) {
+	return o;
+}
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Unknown type");
-				errorSetPos(f_ln, f_col, v->ctx->fn);
-				return NULL;
-			}
+/* create a variable */
+extern object *vmHandleVarNew(vm *v, unsigned int i) {
 
-			/* set type */
-			ob_type = tt | ob_type;
-		}
+	object *o = NULL;
 
-		/* get array object */
-		if (ob_type & OBJECT_ARRAY) {
+	/* increase byte number */
+	v->nofbytes += 2;
 
-			object *asz = vmHandle(v, v->lowbi + v->nofbytes);
+	/* get variable type name */
+	unsigned int len;
+	char *tp_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
+	u8 ob_type = 0; /* object type value */
 
-			/* error */
-			if (asz == NULL || errorIsSet())
-				return NULL;
+	/* get object name */
+	char *ob_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
 
-			int nsz_arr;
+	/* array and pointer */
+	ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes]? OBJECT_ARRAY: 0);
+	ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes + 1]? OBJECT_POINTER: 0);
+	v->nofbytes += 2;
 
-			/* array size should be an integer */
-			if (asz->type != OBJECT_INT) {
+	/* get array object */
+	if (ob_type & OBJECT_ARRAY) {
 
-				/* set error and exit */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Array size must be an integer");
-				errorSetPos(asz->lineno, asz->colno, v->ctx->fn);
-				return NULL;
-			}
+		object *asz = vmHandle(v, v->lowbi + v->nofbytes);
 
-			/* get array size */
-			nsz_arr = O_INT(asz)->val;
+		/* error */
+		if (asz == NULL || errorIsSet())
+			return NULL;
+	}
 
-			/* create an array object */
-			object *a = arrayobjectNew(nsz_arr, ob_type & 0x3);
+	/* get value object */
+	object *val = vmHandle(v, v->lowbi + v->nofbytes);
 
-			o = pointerobjectNew(ob_type & 0x3, (void *)a);
-		}
+	/* error */
+	if (val == NULL || errorIsSet())
+		return NULL;
 
-		/* pointer */
-		else if (ob_type & OBJECT_POINTER) {
+	/* get object type from name */
+	unsigned char tt = typeGet(tp_name);
 
-			/* create pointer object */
-			o = pointerobjectNew(ob_type & 3, NULL);
-		}
+	/* failed to get type */
+	if (tt == 0xFF) {
 
-		/* struct */
-		else if (ob_type == OBJECT_STRUCT) {
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Unknown type");
+		return NULL;
+	}
 
-			/* get struct type object */
-			object *tp = typeobjectGet(tp_name);
+	/* set type */
+	ob_type = tt | ob_type;
 
-			/* copy struct */
-			o = structobjectInstance(O_TYPE(tp)->st);
-		}
+	/* mismatched types */
+	if ((ob_type & 0x3) != (val->type & 0x3)) {
 
-		/* otherwise */
-		else {
+		/* create error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Mismatched types");
+		return NULL;
+	}
 
-			/* create an int or char */
-			o = intcharobjectNew(((ob_type & 3) != OBJECT_INT)? 1: 0, 0);
-		}
+	/* set the name value */
+	namesSet(v->ctx->nt, ob_name, val);
 
-		/* set name */
-		namesSet(v->ctx->nt, ob_name, o);
-		o->lineno = f_ln;
-		o->colno  = f_col;
+	/* set object */
+	o = val;
 
-		/* debug info */
-		if (VM_DEBUG) {
-			
-			fprintf(debug_file, "[vm] created undefined variable with type '%s", tp_name);
-			if (ob_type & OBJECT_POINTER) fprintf(debug_file, " *");
-			if (ob_type & OBJECT_ARRAY) fprintf(debug_file, "[]");
-			fprintf(debug_file, "' and with name '%s'\n", ob_name);
-		}
+	/* debug info */
+	if (VM_DEBUG) {
+		
+		fprintf(debug_file, "[vm] set object '%s' with type %02x", ob_name, o->type);
+		if ((ob_type & 0x3) == OBJECT_INT) fprintf(debug_file, " and with value %d", O_INT(o)->val);
+		//else if ((o->type == (OBJECT_CHR | OBJECT_ARRAY)) || (o->type == (OBJECT_CHR | OBJECT_POINTER))) printf(" and with value '%s'", O_ARRAY(o)->n_start);
+		fprintf(debug_file, ".\n");
 	}
 
-	/* create a variable */
-	if (((u8 *)v->bc)[i] == 0xD1) {
+	return o;
+}
 
-		/* increase byte number */
-		v->nofbytes += 3;
+/* release the function and arguments of a call and free argument list if it was allocated */
+static void vmCallRelease(object *fnc, object **ob_args, int n_of_args, object **ob_list) {
 
-		/* get variable type name */
-		char *tp_name = &(((char *)v->bc)[i + 3]);
-		v->nofbytes += strlen(tp_name) + 2;
-		u8 ob_type = 0; /* object type value */
+	for (int i = 0; i < n_of_args; i++)
+		objectUnref(ob_args[i]);
 
-		/* get object name */
-		char *ob_name = &(((char *)v->bc)[i + strlen(tp_name) + 5]);
-		v->nofbytes += strlen(ob_name) + 1;
+	objectUnref(fnc);
+	if (ob_args != ob_list) free(ob_args);
+}
 
-		/* array and pointer */
-		ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes]? OBJECT_ARRAY: 0);
-		ob_type |= (((u8 *)v->bc)[v->lowbi + v->nofbytes + 1]? OBJECT_POINTER: 0);
-		v->nofbytes += 2;
+/* function call */
+extern object *vmHandleCall(vm *v, unsigned int i) {
 
-		/* get array object */
-		if (ob_type & OBJECT_ARRAY) {
+	object *o = NULL;
 
-			object *asz = vmHandle(v, v->lowbi + v->nofbytes);
+	/* get function object */
+	object *fnc = vmHandle(v, v->lowbi + (++v->nofbytes));
 
-			/* error */
-			if (asz == NULL || errorIsSet())
-				return NULL;
-		}
+	/* error */
+	if (fnc == NULL || errorIsSet())
+		return NULL;
+
+	/* the function and arguments are kept until the call returns */
+	objectRef(fnc);
+
+	/* get the number of args */
+	int n_of_args = vmNextInt(v);
 
-		/* get value object */
-		object *val = vmHandle(v, v->lowbi + v->nofbytes);
+	/* make list of objects (short lists don't need to be allocated) */
+	object *ob_list[VM_CALL_ARGS];
+	object **ob_args = (n_of_args > VM_CALL_ARGS)? (object **)malloc(sizeof(object *) * n_of_args): ob_list;
+
+	/* get the objects */
+	for (int i = 0; i < n_of_args; i++) {
+
+		/* get the argument */
+		object *a = vmHandle(v, v->lowbi + v->nofbytes);
 
 		/* error */
-		if (val == NULL || errorIsSet())
+		if (a == NULL || errorIsSet()) {
+
+			vmCallRelease(fnc, ob_args, i, ob_list);
 			return NULL;
+		}
 
-		/* get object type from name */
-		if (!strcmp(tp_name, "int")) ob_type = OBJECT_INT | ob_type;
-		else if (!strcmp(tp_name, "chr")) ob_type = OBJECT_CHR | ob_type;
-		else {
+		/* add the object */
+		ob_args[i] = a;
+		objectRef(a);
+	}
 
-			/* get type from list */
-			unsigned char tt = typeGet(tp_name);
+	/* call function (the position is only looked up if an error doesn't have one) */
+	o = vmCall(v, fnc, ob_args, n_of_args, 0, 0, NULL);
 
-			/* failed to get type */
-			if (tt == 0xFF) {
+	if (o == NULL && errorIsSet() && !errorHasPos())
+		vmSetErrorPos(v, vmNodePos(v, i));
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Unknown type");
-				errorSetPos(val->lineno, val->colno, val->fname);
-				return NULL;
-			}
+	/* release arguments (the return value may be one of them) */
+	if (o != NULL) objectRef(o);
+	vmCallRelease(fnc, ob_args, n_of_args, ob_list);
+	if (o != NULL) objectDisown(o);
 
-			/* set type */
-			ob_type = tt | ob_type;
-		}
+	return o;
+}
+
+/* check that a function object can be called with a list of arguments (errors are set without a position) */
+extern int vmCallCheck(object *fnc, object **ob_args, int n_of_args) {
+
+	/* check the type */
+	if (fnc->type != OBJECT_FUNC) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		return -1;
+	}
+
+	/* check the argument count */
+	if (n_of_args != O_FUNC(fnc)->n_of_args) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Invalid number of arguments passed to function");
+		return -1;
+	}
+
+	/* match the types */
+	for (int i = 0; i < n_of_args; i++) {
 
 		/* mismatched types */
-		if ((ob_type & 0x3) != (val->type & 0x3)) {
+		if (ob_args[i]->type != O_FUNC(fnc)->fa_types[i]) {
 
-			/* create error */
+			/* set an error */
 			errorSet(ERROR_TYPE_RUNTIME,
 					 ERROR_CODE_ILLEGALOP,
 					 "Mismatched types");
-			errorSetPos(val->lineno, val->colno, val->fname);
-			return NULL;
+			return -1;
 		}
+	}
 
-		/* set the name value */
-		namesSet(v->ctx->nt, ob_name, val);
+	/* check if the reference is undefined */
+	if (O_FUNC(fnc)->fb_start == NULL) {
 
-		/* set object */
-		o = val;
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_UNDEFINEDNAME,
+				 "Undefined reference");
+		return -1;
+	}
 
-		/* debug info */
-		if (VM_DEBUG) {
-			
-			fprintf(debug_file, "[vm] set object '%s' with type %02x", ob_name, o->type);
-			if ((ob_type & 0x3) == OBJECT_INT) fprintf(debug_file, " and with value %d", O_INT(o)->val);
-			//else if ((o->type == (OBJECT_CHR | OBJECT_ARRAY)) || (o->type == (OBJECT_CHR | OBJECT_POINTER))) printf(" and with value '%s'", O_ARRAY(o)->n_start);
-			fprintf(debug_file, ".\n");
-		}
+	/* no room for another call */
+	if (!O_FUNC(fnc)->is_builtin && contextDepth() >= (unsigned int)vm_max_stack) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_STACKOVERFLOW,
+				 "Stack overflow");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* call a function object with a list of arguments (the result is returned without a reference, errors are left without a position if fname is NULL) */
+extern object *vmCall(vm *v, object *fnc, object **ob_args, int n_of_args, unsigned int lineno, unsigned int colno, char *fname) {
+
+	object *o = NULL;
+
+	/* check function and arguments */
+	if (vmCallCheck(fnc, ob_args, n_of_args) < 0) {
+
+		if (fname != NULL) errorSetPos(lineno, colno, fname);
+		return NULL;
 	}
 
-	/* function call */
-	if (((u8 *)v->bc)[i] == 0xD5) {
+	/* builtin functions run in the context of the caller */
+	if (O_FUNC(fnc)->is_builtin) {
+
+		/* get underlying function */
+		bfunc_handle_t bf = (bfunc_handle_t)(O_FUNC(fnc)->fb_start);
 
-		/* get function object */
-		object *fnc = vmHandle(v, v->lowbi + (++v->nofbytes));
+		/* call function */
+		o = bf(ob_args, v->ctx);
 
 		/* error */
-		if (fnc == NULL || errorIsSet())
-			return NULL;
+		if (o == NULL || errorIsSet()) {
 
-		/* get the number of args */
-		v->nofbytes++;
-		int n_of_args = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+			/* builtins report errors at the call */
+			if (!errorHasPos() && fname != NULL)
+				errorSetPos(lineno, colno, fname);
 
-		/* make list of objects */
-		object **ob_args = (object **)malloc(sizeof(object *) * n_of_args);
-		int err = 0;
-		object *errobj = NULL;
-		
-		/* get the objects */
-		for (int i = 0; i < n_of_args; i++) {
+			return NULL;
+		}
 
-			/* get the argument */
-			object *a = vmHandle(v, v->lowbi + v->nofbytes);
+		/* debug info */
+		if (VM_DEBUG) fprintf(debug_file, "[vm] called builtin function '%s'.\n", O_FUNC(fnc)->func_name);
 
-			/* error */
-			if (a == NULL || errorIsSet()) {
+		return o;
+	}
 
-				free(ob_args);
-				return NULL;
-			}
+	/* get a context for the function from the frame stack */
+	context *fctx = contextPush(O_FUNC(fnc)->fname, O_FUNC(fnc)->func_name);
+	fctx->nt->parent = v->ctx->nt;
 
-			/* if previously was an error */
-			if (err)
-				continue;
+	/* linear bytecode (the return value is referenced by interpRun) */
+	if (IS_LINEAR(O_FUNC(fnc)->ov->bcflags)) {
 
-			/* match the type */
-			if (a->type != O_FUNC(fnc)->fa_types[i]) {
+		vm *ov = O_FUNC(fnc)->ov;
 
-				err = 1;
-				errobj = a;
-			}
+		/* set values for arguments */
+		for (int i = 0; i < n_of_args; i++)
+			namesSet(fctx->nt, O_FUNC(fnc)->fa_names[i], ob_args[i]);
 
-			/* add the object */
-			ob_args[i] = a;
-		}
+		/* run function body */
+		context *ctx_old = ov->ctx;
+		ov->ctx = fctx;
 
-		/* get error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+		int res = interpRun(ov, O_FUNC(fnc)->fb_start, fnc, &o);
 
-		/* check the argument count */
-		if (n_of_args != O_FUNC(fnc)->n_of_args) {
+		ov->ctx = ctx_old;
 
-			/* set error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Invalid number of arguments passed to function");
-			errorSetPos(lineno, colno, v->ctx->fn);
-			free(ob_args);
-			return NULL;
-		}
+		/* error */
+		if (res != INTERP_RETURN) {
 
-		/* mismatched types */
-		if (err) {
-		
-			/* set an error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Mismatched types");
-			errorSetPos(errobj->lineno, errobj->colno, errobj->fname);
-			free(ob_args);
+			contextPop(fctx);
 			return NULL;
 		}
+	}
+	else {
 
-		/* check the type */
-		if (fnc->type != OBJECT_FUNC) {
+		/* backup variables from vm */
+		context *ctx_old = O_FUNC(fnc)->ov->ctx;
+		int nofbytes_old = O_FUNC(fnc)->ov->nofbytes;
+		int lowbi_old = O_FUNC(fnc)->ov->lowbi;
+		unsigned int pos_old = O_FUNC(fnc)->ov->pos;
+		void *bc_old = O_FUNC(fnc)->ov->bc;
+		unsigned int bc_pos_old = O_FUNC(fnc)->ov->bc_pos;
 
-			/* set error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Illegal operation");
-			errorSetPos(lineno, colno, v->ctx->fn);
-			free(ob_args);
-			return NULL;
-		}
+		/* set new values */
+		O_FUNC(fnc)->ov->ctx = fctx;
+		O_FUNC(fnc)->ov->nofbytes = 0;
+		O_FUNC(fnc)->ov->lowbi = 0;
+		O_FUNC(fnc)->ov->bc = O_FUNC(fnc)->fb_start;
+		O_FUNC(fnc)->ov->bc_pos += (u8 *)O_FUNC(fnc)->fb_start - (u8 *)bc_old;
 
-		/* check if the reference is undefined */
-		if (O_FUNC(fnc)->fb_start == NULL) {
+		/* set values for arguments */
+		for (int i = 0; i < n_of_args; i++)
+			namesSet(fctx->nt, O_FUNC(fnc)->fa_names[i], ob_args[i]);
 
-			/* set error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_UNDEFINEDNAME,
-					 "Undefined reference");
-			errorSetPos(lineno, colno, v->ctx->fn);
-			free(ob_args);
-			return NULL;
-		}
+		object *rt = NULL; /* return value */
+		int err = 0; /* error in function body */
 
-		/* create a context for the function */
-		context *fctx = contextNew(fnc->fname, O_FUNC(fnc)->func_name);
-		fctx->nt->parent = v->ctx->nt;
-		fctx->tp = CONTEXT_FUNC;
+		/* execute bytecode */
+		for (int i = 0; i < O_FUNC(fnc)->fb_n; i++) {
 
-		/* if it is a builtin function */
-		if (O_FUNC(fnc)->is_builtin) {
+			/* get object */
+			O_FUNC(fnc)->ov->lowbi += O_FUNC(fnc)->ov->nofbytes;
+			O_FUNC(fnc)->ov->nofbytes = 0;
+			object *res = vmHandle(O_FUNC(fnc)->ov, O_FUNC(fnc)->ov->lowbi);
 
-			/* get underlying function */
-			bfunc_handle_t bf = (bfunc_handle_t)(O_FUNC(fnc)->fb_start);
+			/* return value (no error if there is one) */
+			if (fctx->rt != NULL) {
 
-			/* call function */
-			object *a = bf(ob_args, fctx);
+				rt = fctx->rt;
 
-			/* error */
-			if (a == NULL || errorIsSet()) {
+				/* check types */
+				if (rt->type != O_FUNC(fnc)->rt_type) {
 
-				/* free values and exit */
-				free(ob_args);
-				contextFree(fctx);
-				return NULL;
+					/* set error */
+					errorSet(ERROR_TYPE_RUNTIME,
+							 ERROR_CODE_ILLEGALOP,
+							 "Mismatched types");
+					vmSetErrorPos(O_FUNC(fnc)->ov, O_FUNC(fnc)->ov->pos);
+					err = 1;
+				}
+
+				fctx->rt = NULL;
+				break;
 			}
 
-			/* set object */
-			o = a;
+			/* error */
+			if (res == NULL || errorIsSet()) {
+
+				err = 1;
+				break;
+			}
 		}
-		else {
 
-			/* backup variables from vm */
-			context *ctx_old = O_FUNC(fnc)->ov->ctx;
-			int nofbytes_old = O_FUNC(fnc)->ov->nofbytes;
-			int lowbi_old = O_FUNC(fnc)->ov->lowbi;
-			void *bc_old = O_FUNC(fnc)->ov->bc;
-	
-			/* set new values */
-			O_FUNC(fnc)->ov->ctx = fctx;
-			O_FUNC(fnc)->ov->nofbytes = 0;
-			O_FUNC(fnc)->ov->lowbi = 0;
-			O_FUNC(fnc)->ov->bc = O_FUNC(fnc)->fb_start;
-	
-			/* set values for arguments */
-			for (int i = 0; i < n_of_args; i++)
-				namesSet(fctx->nt, O_FUNC(fnc)->fa_names[i], ob_args[i]);
+		/* restore original values for vm */
+		O_FUNC(fnc)->ov->ctx = ctx_old;
+		O_FUNC(fnc)->ov->nofbytes = nofbytes_old;
+		O_FUNC(fnc)->ov->lowbi = lowbi_old;
+		O_FUNC(fnc)->ov->pos = pos_old;
+		O_FUNC(fnc)->ov->bc = bc_old;
+		O_FUNC(fnc)->ov->bc_pos = bc_pos_old;
 
-			object *rt = NULL; /* return value */
-	
-			/* execute bytecode */
-			for (int i = 0; i < O_FUNC(fnc)->fb_n; i++) {
-	
-				/* get object */
-				O_FUNC(fnc)->ov->lowbi += O_FUNC(fnc)->ov->nofbytes;
-				O_FUNC(fnc)->ov->nofbytes = 0;
-				object *res = vmHandle(O_FUNC(fnc)->ov, O_FUNC(fnc)->ov->lowbi);
-
-				/* return value (no error if there is one) */
-				if (fctx->rt != NULL) {
-
-					rt = fctx->rt;
-
-					/* check types */
-					if (rt->type != O_FUNC(fnc)->rt_type) {
-
-						/* set error */
-						errorSet(ERROR_TYPE_RUNTIME,
-								 ERROR_CODE_ILLEGALOP,
-								 "Mismatched types");
-						errorSetPos(rt->lineno, rt->colno, rt->fname);
-						return NULL;
-					}
-
-					res = rt;
-					fctx->rt = NULL;
-					break;
-				}
-	
-				/* error */
-				if (res == NULL || errorIsSet()) {
-	
-					contextFree(fctx); /* free the new context */
-	
-					/* restore values */
-					O_FUNC(fnc)->ov->ctx = ctx_old;
-					O_FUNC(fnc)->ov->nofbytes = nofbytes_old;
-					O_FUNC(fnc)->ov->lowbi = lowbi_old;
-					O_FUNC(fnc)->ov->bc = bc_old;
-	
-					free(ob_args);
-	
-					/* exit */
-					return NULL;
-				}
-			}
-	
-			/* restore original values for vm and free new context */
-			O_FUNC(fnc)->ov->ctx = ctx_old;
-			O_FUNC(fnc)->ov->nofbytes = nofbytes_old;
-			O_FUNC(fnc)->ov->lowbi = lowbi_old;
-			O_FUNC(fnc)->ov->bc = bc_old;
-
-			/* set return value */
-			if (rt != NULL) o = rt;
-			else o = intobjectNew(0);
+		/* error */
+		if (err) {
+
+			contextPop(fctx); /* release the new context */
+			return NULL;
 		}
 
-		contextFree(fctx);
+		/* set return value */
+		if (rt != NULL) o = rt;
+		else o = intobjectNew(0);
+
+		objectRef(o);
+	}
 
-		free(ob_args); /* free argument list because we don't need it anymore */
+	/* release context (the return value may be one of its names) */
+	contextPop(fctx);
+	objectDisown(o);
 
-		/* debug info */
-		if (VM_DEBUG) fprintf(debug_file, "[vm] called function '%s'.\n", O_FUNC(fnc)->func_name);
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[vm] called function '%s'.\n", O_FUNC(fnc)->func_name);
+
+	return o;
+}
+
+/* function definition */
+extern object *vmHandleFuncDef(vm *v, unsigned int i) {
+
+	object *o = NULL;
+
+	/* get declaration */
+	object *dec = vmHandle(v, v->lowbi + (++v->nofbytes));
+
+	/* error */
+	if (dec == NULL || errorIsSet())
+		return NULL;
+
+	/* check type */
+	if (dec->type != OBJECT_FUNC) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		return NULL;
 	}
 
-	/* function definition */
-	if (((u8 *)v->bc)[i] == 0xDC) {
+	/* get number of nodes */
+	int ncnt = vmNextInt(v);
 
-		/* get declaration */
-		object *dec = vmHandle(v, v->lowbi + (++v->nofbytes));
+	/* size of function body */
+	int nsz = vmNextInt(v);
 
-		/* error */
-		if (dec == NULL || errorIsSet())
-			return NULL;
+	/* get pointer to body and advance past it */
+	void *fb_start = (void *)&(((u8 *)v->bc)[v->lowbi + v->nofbytes]);
 
-		/* check type */
-		if (dec->type != OBJECT_FUNC) {
+	v->nofbytes += nsz;
 
-			/* set error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Illegal operation");
-			errorSetPos(dec->lineno, dec->colno, dec->fname);
-			return NULL;
-		}
+	/* set values */
+	O_FUNC(dec)->fb_start = fb_start;
+	O_FUNC(dec)->fb_n = ncnt;
+	O_FUNC(dec)->ov = v;
 
-		/* get number of nodes */
-		v->nofbytes++;
-		int ncnt = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+	o = dec;
 
-		/* size of function body */
-		v->nofbytes++;
-		int nsz = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+	/* debug info */
+	if (DEBUG) fprintf(debug_file, "[vm] set function body for '%s'.\n", O_FUNC(o)->func_name);
 
-		/* get pointer to body and advance past it */
-		void *fb_start = (void *)&(((u8 *)v->bc)[v->lowbi + v->nofbytes]);
+	return o;
+}
 
-		v->nofbytes += nsz;
+/* function declaration */
+extern object *vmHandleFuncDec(vm *v, unsigned int i) {
 
-		/* set values */
-		O_FUNC(dec)->fb_start = fb_start;
-		O_FUNC(dec)->fb_n = ncnt;
-		O_FUNC(dec)->ov = v;
+	object *o = NULL;
+
+	/* function type */
+	unsigned int len;
+	v->nofbytes++;
+	char *tp_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
+
+	/* name of function */
+	char *fn_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
+
+	/* pointer type */
+	int is_p = (((u8 *)v->bc)[v->lowbi + (v->nofbytes++)]);
+
+	/* number of arguments */
+	int n_of_args = vmNextInt(v);
+
+	int err = 0; /* error code (0 = none, 1 = unknown type name) */
+
+	/* list of argument names and argument types */
+	char **arg_names = FUNC_ARGNAME_LIST(n_of_args + 1);
+	u8 *arg_types = FUNC_ARGTYPE_LIST(n_of_args + 1);
+
+	/* loop and get argument types and names */
+	for (int i = 0; i < n_of_args; i++) {
+
+		/* arg type name */
+		char *at = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+		v->nofbytes += len;
+
+		/* arg name */
+		char *an = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+		v->nofbytes += len;
+
+		/* is a pointer */
+		int ap = (((u8 *)v->bc)[v->lowbi + (v->nofbytes++)]);
+
+		/* no error */
+		if (!err) {
+
+			/* add argument name */
+			arg_names[i] = an;
+
+			/* get argument type from string */
+			unsigned char tt = typeGet(at);
+
+			/* failed to get type */
+			if (tt == 0xFF) err = 1;
+
+			/* add argument type */
+			else arg_types[i] = tt | (ap? OBJECT_POINTER: 0);
+		}
+	}
+
+	/* get error info */
+	unsigned int pos = vmNodePos(v, i);
+
+	/* get return type from string */
+	u8 rt_type = typeGet(tp_name);
+
+	/* failed to get type */
+	if (rt_type == 0xFF) {
+
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Unknown type");
+		vmSetErrorPos(v, pos);
 
-		o = dec;
+		/* free args */
+		free(arg_names);
+		free(arg_types);
 
-		/* debug info */
-		if (DEBUG) fprintf(debug_file, "[vm] set function body for '%s'.\n", O_FUNC(o)->func_name);
+		return NULL;
 	}
 
-	/* function declaration */
-	if (((u8 *)v->bc)[i] == 0xDB) {
+	/* set type */
+	rt_type |= is_p? OBJECT_POINTER: 0;
 
-		/* function type */
-		v->nofbytes += 2;
-		char *tp_name = &(((char *)v->bc)[v->lowbi + v->nofbytes]);
-		v->nofbytes += strlen(tp_name) + 1;
+	/* error from previously */
+	if (err) {
 
-		/* name of function */
-		char *fn_name = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-		v->nofbytes += strlen(fn_name) + 1;
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		vmSetErrorPos(v, pos);
 
-		/* pointer type */
-		int is_p = (((u8 *)v->bc)[v->lowbi + (v->nofbytes++)]);
+		/* free args */
+		free(arg_names);
+		free(arg_types);
 
-		/* number of arguments */
-		v->nofbytes++;
-		int n_of_args = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+		return NULL;
+	}
 
-		int err = 0; /* error code (0 = none, 1 = unknown type name) */
+	/* create a function object */
+	o = functionobjectNew(fn_name, rt_type, arg_names, arg_types, n_of_args);
+	O_FUNC(o)->fname = v->ctx->fn;
 
-		/* list of argument names and argument types */
-		char **arg_names = FUNC_ARGNAME_LIST(n_of_args + 1);
-		u8 *arg_types = FUNC_ARGTYPE_LIST(n_of_args + 1);
+	/* set the function name */
+	namesSet(v->ctx->nt, fn_name, o);
 
-		/* loop and get argument types and names */
-		for (int i = 0; i < n_of_args; i++) {
+	/* debug info */
+	if (DEBUG) fprintf(debug_file, "[vm] created function reference '%s'.\n", fn_name);
 
-			/* arg type name */
-			char *at = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-			v->nofbytes += strlen(at) + 1;
+	return o;
+}
 
-			/* arg name */
-			char *an = &(((char *)v->bc)[v->lowbi + (++v->nofbytes)]);
-			v->nofbytes += strlen(an) + 1;
+/* extern */
+extern object *vmHandleExtern(vm *v, unsigned int i) {
 
-			/* is a pointer */
-			int ap = (((u8 *)v->bc)[v->lowbi + (v->nofbytes++)]);
+	object *o = NULL;
 
-			/* no error */
-			if (!err) {
+	v->nofbytes++;
 
-				/* add argument name */
-				arg_names[i] = an;
+	/* set up scope */
+	nameTable *nt_old = v->ctx->nt;
+	v->ctx->nt = vmdctx->nt;
 
-				/* get argument type from string */
-				u8 att = ap? OBJECT_POINTER: 0;
+	/* get object */
+	object *a = vmHandle(v, v->lowbi + v->nofbytes);
 
-				if (!strcmp(at, "int")) att = OBJECT_INT | att;
-				else if (!strcmp(at, "chr")) att = OBJECT_CHR | att;
-				else {
+	/* restore context */
+	v->ctx->nt = nt_old;
 
-					/* get type from list */
-					unsigned char tt = typeGet(at);
+	/* error */
+	if (a == NULL || errorIsSet())
+		return NULL;
 
-					/* failed to get type */
-					if (tt == 0xFF) {
+	/* set object */
+	o = a;
 
-						err = 1;
-					} else att = tt | att;
-				}
+	return o;
+}
 
-				/* add argument type */
-				arg_types[i] = att;
-			}
-		}
+/* return value */
+extern object *vmHandleReturn(vm *v, unsigned int i) {
 
-		/* get error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+	object *o = NULL;
 
-		/* get return type from string */
-		u8 rt_type = is_p? OBJECT_POINTER: 0;
+	/* get value */
+	object *rt = vmHandle(v, v->lowbi + (++v->nofbytes));
 
-		if (!strcmp(tp_name, "int")) rt_type = OBJECT_INT | rt_type;
-		else if (!strcmp(tp_name, "chr")) rt_type = OBJECT_CHR | rt_type;
-		else {
+	/* error */
+	if (rt == NULL || errorIsSet())
+		return NULL;
 
-			/* get type from list */
-			unsigned char tt = typeGet(tp_name);
+	/* get error info */
+	unsigned int pos = vmNodePos(v, i);
 
-			/* failed to get type */
-			if (tt == 0xFF) {
+	/* if we are not in a function */
+	if (v->ctx->tp != CONTEXT_FUNC) {
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Unknown type");
-				errorSetPos(lineno, colno, v->ctx->fn);
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Illegal operation");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
 
-				/* free args */
-				free(arg_names);
-				free(arg_types);
+	/* set the return object */
+	v->ctx->rt = rt;
+	o = NULL; /* set to NULL so that no other code will be executed */
 
-				return NULL;
-			}
+	return o;
+}
 
-			/* set type */
-			rt_type = tt | rt_type;
-		}
+/* if statement */
+extern object *vmHandleIfStatement(vm *v, unsigned int i) {
 
-		/* error from previously */
-		if (err) {
+	object *o = NULL;
 
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Illegal operation");
-			errorSetPos(lineno, colno, v->ctx->fn);
+	/* advance and get condition */
+	object *cond = vmHandle(v, v->lowbi + (++v->nofbytes));
 
-			/* free args */
-			free(arg_names);
-			free(arg_types);
+	/* error */
+	if (cond == NULL || errorIsSet())
+		return NULL;
 
-			return NULL;
-		}
+	/* get number of nodes */
+	int nch = vmNextInt(v);
 
-		/* create a function object */
-		o = functionobjectNew(fn_name, rt_type, arg_names, arg_types, n_of_args);
+	/* get length of if node body */
+	int nofbytes = vmNextInt(v);
+	nofbytes += v->nofbytes;
 
-		/* set the function name */
-		namesSet(v->ctx->nt, fn_name, o);
+	/* if condition is true */
+	if (!((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))) {
 
-		/* debug info */
-		if (DEBUG) fprintf(debug_file, "[vm] created function reference '%s'.\n", fn_name);
-	}
+		/* execute nodes */
+		for (int i = 0; i < nch; i++) {
 
-	/* extern */
-	if (((u8 *)v->bc)[i] == 0xC1) {
+			/* error */
+			if (vmHandle(v, v->lowbi + v->nofbytes) == NULL || errorIsSet())
+				return NULL;
+		}
+	}
 
-		v->nofbytes++;
+	/* set number of bytes and return value */
+	v->nofbytes = nofbytes;
 
-		/* set up scope */
-		nameTable *nt_old = v->ctx->nt;
-		v->ctx->nt = vmdctx->nt;
+	/* else block */
+	int eb = ((u8*)v->bc)[v->lowbi + v->nofbytes++];
 
-		/* get object */
-		object *a = vmHandle(v, v->lowbi + v->nofbytes);
+	if (eb) {
 
-		/* restore context */
-		v->ctx->nt = nt_old;
+		/* get number */
+		nofbytes = vmNextInt(v);
+		nofbytes += v->nofbytes;
 
-		/* error */
-		if (a == NULL || errorIsSet())
+		/* handle node */
+		if (vmHandle(v, v->lowbi + v->nofbytes) == NULL || errorIsSet())
 			return NULL;
 
-		/* set object */
-		o = a;
+		/* set number of bytes */
+		v->nofbytes = nofbytes;
 	}
 
-	/* return value */
-	if (((u8 *)v->bc)[i] == 0xC0) {
+	o = intobjectNew(0);
 
-		/* get value */
-		object *rt = vmHandle(v, v->lowbi + (++v->nofbytes));
+	return o;
+}
 
-		/* error */
-		if (rt == NULL || errorIsSet())
-			return NULL;
+/* for loop */
+extern object *vmHandleFor(vm *v, unsigned int i) {
+
+	object *o = NULL;
 
-		/* get error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+	/* advance */
+	v->nofbytes++;
 
-		/* if we are not in a function */
-		if (v->ctx->tp != CONTEXT_FUNC) {
+	/* get start node */
+	object *start = vmHandle(v, v->lowbi + v->nofbytes);
 
-			/* set error */
-			errorSet(ERROR_TYPE_RUNTIME,
-					 ERROR_CODE_ILLEGALOP,
-					 "Illegal operation");
-			errorSetPos(lineno, colno, v->ctx->fn);
-			return NULL;
-		}
+	/* error */
+	if (start == NULL || errorIsSet())
+		return NULL;
 
-		/* set the return object */
-		v->ctx->rt = rt;
-		o = NULL; /* set to NULL so that no other code will be executed */
-	}
+	/* store values */
+	int nofbytes_old = (v->nofbytes);
+	int nofbytes;
 
-	/* if statement */
-	if ((((u8 *)v->bc)[i]) == 0xD8) {
+	/* loop */
+	while (1) {
 
-		/* advance and get condition */
-		object *cond = vmHandle(v, v->lowbi + (++v->nofbytes));
+		/* get condition */
+		object *cond = vmHandle(v, v->lowbi + v->nofbytes);
 
 		/* error */
 		if (cond == NULL || errorIsSet())
 			return NULL;
 
-		/* get number of nodes */
-		v->nofbytes++;
-		int nch = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
+		/* number of nodes */
+		int nch = vmNextInt(v);
 
-		/* get length of if node body */
-		v->nofbytes++;
-		int nofbytes = (vmGetInt(v, v->lowbi + v->nofbytes)) + v->nofbytes + 4;
-		v->nofbytes += 4;
+		/* number of bytes */
+		nofbytes = vmNextInt(v);
+		nofbytes += v->nofbytes;
 
-		/* if condition is true */
-		if (!((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))) {
+		/* condition isn't true */
+		if ((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))
+			break;
 
-			/* execute nodes */
-			for (int i = 0; i < nch; i++) {
+		object *rt;
 
-				/* error */
-				if (vmHandle(v, v->lowbi + v->nofbytes) == NULL || errorIsSet())
-					return NULL;
-			}
-		}
+		/* loop through nodes */
+		for (int i = 0; i < nch; i++) {
 
-		/* set number of bytes and return value */
-		v->nofbytes = nofbytes;
+			/* error */
+			if ((rt = vmHandle(v, v->lowbi + v->nofbytes)) == NULL || errorIsSet())
+				return NULL;
+		}
 
-		/* else block */
-		int eb = ((u8*)v->bc)[v->lowbi + v->nofbytes++];
+		/* increment */
+		object *inc = vmHandle(v, v->lowbi + v->nofbytes);
 
-		if (eb) {
+		/* error */
+		if (inc == NULL || errorIsSet())
+			return NULL;
 
-			/* get number */
-			v->nofbytes++;
-			nofbytes = (vmGetInt(v, v->lowbi + v->nofbytes)) + v->nofbytes + 4;
-			v->nofbytes += 4;
+		/* keyboard interrupt */
+		if (INT_SIGNAL) {
 
-			/* handle node */
-			if (vmHandle(v, v->lowbi + v->nofbytes) == NULL || errorIsSet())
-				return NULL;
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_KBINT,
+					 "Keyboard interrupt");
 
-			/* set number of bytes */
-			v->nofbytes = nofbytes;
+			INT_SIGNAL = 0;
+			return NULL;
 		}
 
-		o = intobjectNew(0);
-	}
+		/* reset value */
+		v->nofbytes = nofbytes_old;
 
-	/* for loop */
-	if ((((u8 *)v->bc)[i]) == 0xDA) {
+		/* garbage collect */
+		vmCollect();
+	}
 
-		/* advance */
-		v->nofbytes++;
+	/* skip past body */
+	v->nofbytes = nofbytes;
 
-		/* get start node */
-		object *start = vmHandle(v, v->lowbi + v->nofbytes);
+	/* set return value */
+	o = intobjectNew(0);
 
-		/* error */
-		if (start == NULL || errorIsSet())
-			return NULL;
+	return o;
+}
 
-		/* store values */
-		int nofbytes_old = (v->nofbytes);
-		int nofbytes;
+/* while loop */
+extern object *vmHandleWhile(vm *v, unsigned int i) {
 
-		/* loop */
-		while (1) {
+	object *o = NULL;
 
-			/* get condition */
-			object *cond = vmHandle(v, v->lowbi + v->nofbytes);
+	int nofbytes_old = (++v->nofbytes);
+	int nofbytes;
 
-			/* error */
-			if (cond == NULL || errorIsSet())
-				return NULL;
+	/* loop */
+	while (1) {
 
-			/* number of nodes */
-			v->nofbytes++;
-			int nch = vmGetInt(v, v->lowbi + v->nofbytes);
-			v->nofbytes += 4;
+		/* get condition */
+		object *cond = vmHandle(v, v->lowbi + v->nofbytes);
 
-			/* number of bytes */
-			v->nofbytes++;
-			nofbytes = (vmGetInt(v, v->lowbi + v->nofbytes)) + 4 + v->nofbytes;
-			v->nofbytes += 4;
+		/* couldn't get condition value */
+		if (cond == NULL || errorIsSet())
+			return NULL;
 
-			/* condition isn't true */
-			if ((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))
-				break;
+		/* get number of children */
+		int nch = vmNextInt(v);
 
-			object *rt;
+		/* get size of while node body */
+		nofbytes = vmNextInt(v);
+		nofbytes += v->nofbytes;
 
-			/* loop through nodes */
-			for (int i = 0; i < nch; i++) {
+		/* leave if condition says so */
+		if ((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))
+			break;
 
-				/* error */
-				if ((rt = vmHandle(v, v->lowbi + v->nofbytes)) == NULL || errorIsSet())
-					return NULL;
-			}
+		object *rt;
 
-			/* increment */
-			object *inc = vmHandle(v, v->lowbi + v->nofbytes);
+		/* loop through body nodes */
+		for (int i = 0; i < nch; i++) {
 
 			/* error */
-			if (inc == NULL || errorIsSet())
-				return NULL;
+			if ((rt = vmHandle(v, v->lowbi + v->nofbytes)) == NULL || errorIsSet()) {
 
-			/* keyboard interrupt */
-			if (INT_SIGNAL) {
-
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_KBINT,
-						 "Keyboard interrupt");
-				errorSetPos(rt->lineno, rt->colno, rt->fname);
-
-				INT_SIGNAL = 0;
 				return NULL;
 			}
-
-			/* reset value */
-			v->nofbytes = nofbytes_old;
-
-			/* garbage collect */
-			objectCollect();
 		}
 
-		/* skip past body */
-		v->nofbytes = nofbytes;
-
-		/* set return value */
-		o = intobjectNew(0);
-	}
+		/* interrupt */
+		if (INT_SIGNAL) {
 
-	/* while loop */
-	if ((((u8 *)v->bc)[i]) == 0xD9) {
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_KBINT,
+					 "Keyboard interrupt");
 
-		int nofbytes_old = (++v->nofbytes);
-		int nofbytes;
+			INT_SIGNAL = 0;
+			return NULL;
+		}
 
-		/* loop */
-		while (1) {
+		/* reset pos */
+		v->nofbytes = nofbytes_old;
 
-			/* get condition */
-			object *cond = vmHandle(v, v->lowbi + v->nofbytes);
+		/* garbage collect */
+		vmCollect();
+	}
 
-			/* couldn't get condition value */
-			if (cond == NULL || errorIsSet())
-				return NULL;
+	/* skip past */
+	v->nofbytes = nofbytes;
 
-			/* get number of children */
-			v->nofbytes++;
-			int nch = vmGetInt(v, v->lowbi + v->nofbytes);
-			v->nofbytes += 4;
+	/* set object */
+	o = intobjectNew(0);
 
-			/* get size of while node body */
-			v->nofbytes++;
-			nofbytes = v->nofbytes + 4 + (vmGetInt(v, v->lowbi + v->nofbytes));
-			v->nofbytes += 4;
+	return o;
+}
 
-			/* leave if condition says so */
-			if ((cond->type == OBJECT_INT) && (O_INT(cond)->val == 0))
-				break;
+/* struct */
+extern object *vmHandleStruct(vm *v, unsigned int i) {
 
-			object *rt;
+	object *o = NULL;
 
-			/* loop through body nodes */
-			for (int i = 0; i < nch; i++) {
+	/* get struct name */
+	unsigned int len;
+	v->nofbytes++;
+	char *struct_name = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
 
-				/* error */
-				if ((rt = vmHandle(v, v->lowbi + v->nofbytes)) == NULL || errorIsSet()) {
+	/* get number of nodes */
+	int nch = vmNextInt(v);
 
-					return NULL;
-				}
-			}
+	/* create struct */
+	context *myctx = contextNew(v->ctx->fn, struct_name);
+	myctx->tp = CONTEXT_STRUCT;
 
-			/* interrupt */
-			if (INT_SIGNAL) {
+	/* backup ctx */
+	context *octx = v->ctx;
+	v->ctx = myctx;
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_KBINT,
-						 "Keyboard interrupt");
-				errorSetPos(rt->lineno, rt->colno, rt->fname);
+	/* execute bytecode */
+	for (int i = 0; i < nch; i++) {
 
-				INT_SIGNAL = 0;
-				return NULL;
-			}
+		/* get object */
+		object *c = vmHandle(v, v->lowbi + v->nofbytes);
 
-			/* reset pos */
-			v->nofbytes = nofbytes_old;
+		/* error */
+		if (c == NULL || errorIsSet()) {
 
-			/* garbage collect */
-			objectCollect();
+			/* return */
+			v->ctx = octx;
+			return NULL;
 		}
-
-		/* skip past */
-		v->nofbytes = nofbytes;
-
-		/* set object */
-		o = intobjectNew(0);
 	}
 
-	/* struct */
-	if ((((u8 *)v->bc)[i]) == 0xC2) {
-
-		/* get struct name */
-		v->nofbytes += 2;
-		char *struct_name = &(((char *)v->bc)[v->lowbi + v->nofbytes]);
-		v->nofbytes += strlen(struct_name) + 1;
-
-		/* get number of nodes */
-		v->nofbytes++;
-		int nch = vmGetInt(v, v->lowbi + v->nofbytes);
-		v->nofbytes += 4;
-
-		/* create struct */
-		context *myctx = contextNew(v->ctx->fn, struct_name);
-		myctx->tp = CONTEXT_STRUCT;
-
-		/* backup ctx */
-		context *octx = v->ctx;
-		v->ctx = myctx;
+	object *st = structobjectNew(myctx, struct_name);
 
-		/* execute bytecode */
-		for (int i = 0; i < nch; i++) {
-
-			/* get object */
-			object *c = vmHandle(v, v->lowbi + v->nofbytes);
+	/* set old ctx */
+	v->ctx = octx;
 
-			/* error */
-			if (c == NULL || errorIsSet()) {
+	/* set struct */
+	namesSet(v->ctx->nt, struct_name, st);
+	typeRegisterStruct(struct_name, st);
 
-				/* return */
-				v->ctx = octx;
-				return NULL;
-			}
-		}
+	o = st;
 
-		object *st = structobjectNew(myctx, struct_name);
+	return o;
+}
 
-		/* set old ctx */
-		v->ctx = octx;
+/* typedef */
+extern object *vmHandleTypeDef(vm *v, unsigned int i) {
 
-		/* set struct */
-		namesSet(v->ctx->nt, struct_name, st);
-		typeRegisterStruct(struct_name, st);
+	object *o = NULL;
 
-		o = st;
-	}
+	/* get pointer value */
+	int is_p = (((u8 *)v->bc)[++v->nofbytes]);
+	v->nofbytes++;
 
-	/* typedef */
-	if ((((u8 *)v->bc)[i]) == 0xC3) {
+	/* get name of old type */
+	unsigned int len;
+	char *otp = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
 
-		/* get pointer value */
-		int is_p = (((u8 *)v->bc)[++v->nofbytes]);
-		v->nofbytes += 2;
+	/* get name of new type */
+	char *ntp = vmGetIdt(v, v->lowbi + v->nofbytes, &len);
+	v->nofbytes += len;
 
-		/* get name of old type */
-		char *otp = &(((char *)v->bc)[v->lowbi + v->nofbytes]);
-		v->nofbytes += strlen(otp) + 2;
+	/* get error info */
+	unsigned int pos = vmNodePos(v, i);
 
-		/* get name of new type */
-		char *ntp = &(((char *)v->bc)[v->lowbi + v->nofbytes]);
-		v->nofbytes += strlen(ntp) + 1;
+	/* get type type */
+	unsigned char tp_type = typeGet(otp);
 
-		/* get error info */
-		int lineno, colno;
-		vmGetErrorInfo(v, &lineno, &colno);
+	/* failed to get type */
+	if (tp_type == 0xFF) {
 
-		/* get type type */
-		unsigned char tp_type = is_p? OBJECT_POINTER: 0;
-		if (!strcmp(otp, "int")) tp_type = OBJECT_INT | tp_type;
-		else if (!strcmp(otp, "chr")) tp_type = OBJECT_CHR | tp_type;
-		else {
+		/* set error */
+		errorSet(ERROR_TYPE_RUNTIME,
+				 ERROR_CODE_ILLEGALOP,
+				 "Unknown type");
+		vmSetErrorPos(v, pos);
+		return NULL;
+	}
 
-			/* get type from list */
-			unsigned char tt = typeGet(otp);
+	/* set type */
+	tp_type |= is_p? OBJECT_POINTER: 0;
 
-			/* failed to get type */
-			if (tt == 0xFF) {
+	/* set object and type */
+	typeRegister(ntp, tp_type);
+	o = intobjectNew(0);
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_ILLEGALOP,
-						 "Unknown type");
-				errorSetPos(lineno, colno, v->ctx->fn);
-				return NULL;
-			}
+	/* debug */
+	if (VM_DEBUG) fprintf(debug_file, "[vm] created type '%s' based off of '%s'\n", ntp, otp);
 
-			/* set type */
-			tp_type = tt | tp_type;
-		}
+	return o;
+}
+#ifndef VM_COMPUTED_GOTO
+
+/* dispatch table for vmHandle, indexed by node type byte */
+static vm_handler_t vm_handlers[256] = {
+	[0x9A] = vmHandleVarAcc,
+	[0x9B] = vmHandleInt,
+	[0x9C] = vmHandleUnOp,
+	[0x9D] = vmHandleBinOp,
+	[0x9E] = vmHandleString,
+	[0xC0] = vmHandleReturn,
+	[0xC1] = vmHandleExtern,
+	[0xC2] = vmHandleStruct,
+	[0xC3] = vmHandleTypeDef,
+	[0xD1] = vmHandleVarNew,
+	[0xD2] = vmHandleVarAsg,
+	[0xD3] = vmHandleVarAcc,
+	[0xD4] = vmHandleVarAcc,
+	[0xD5] = vmHandleCall,
+	[0xD6] = vmHandleVarAcc,
+	[0xD7] = vmHandleVarUndefined,
+	[0xD8] = vmHandleIfStatement,
+	[0xD9] = vmHandleWhile,
+	[0xDA] = vmHandleFor,
+	[0xDB] = vmHandleFuncDec,
+	[0xDC] = vmHandleFuncDef,
+	[0xDD] = vmHandleVarAsg,
+};
+
+#endif
 
-		/* set object and type */
-		typeRegister(ntp, tp_type);
-		o = intobjectNew(0);
+/* return an object from handler */
+extern object *vmHandle(vm *v, unsigned int i) {
 
-		/* debug */
-		if (VM_DEBUG) fprintf(debug_file, "[vm] created type '%s' based off of '%s'\n", ntp, otp);
-	}
+	object *o = NULL;
+	u8 op = ((u8 *)v->bc)[i];
+
+	if (VM_DEBUG) fprintf(debug_file, "[vm] node type %02x\n", op);
+
+#ifdef VM_COMPUTED_GOTO
+
+	/* label table (gcc/clang extension); unknown node types fall through to vm_op_none */
+	static void *vm_labels[256] = {
+		[0 ... 255] = &&vm_op_none,
+		[0x9A] = &&vm_op_varacc,
+		[0x9B] = &&vm_op_int,
+		[0x9C] = &&vm_op_unop,
+		[0x9D] = &&vm_op_binop,
+		[0x9E] = &&vm_op_string,
+		[0xC0] = &&vm_op_return,
+		[0xC1] = &&vm_op_extern,
+		[0xC2] = &&vm_op_struct,
+		[0xC3] = &&vm_op_typedef,
+		[0xD1] = &&vm_op_varnew,
+		[0xD2] = &&vm_op_varasg,
+		[0xD3] = &&vm_op_varacc,
+		[0xD4] = &&vm_op_varacc,
+		[0xD5] = &&vm_op_call,
+		[0xD6] = &&vm_op_varacc,
+		[0xD7] = &&vm_op_varundefined,
+		[0xD8] = &&vm_op_ifstatement,
+		[0xD9] = &&vm_op_while,
+		[0xDA] = &&vm_op_for,
+		[0xDB] = &&vm_op_funcdec,
+		[0xDC] = &&vm_op_funcdef,
+		[0xDD] = &&vm_op_varasg,
+	};
+
+	goto *vm_labels[op];
+
+	vm_op_varacc: o = vmHandleVarAcc(v, i); goto vm_op_done;
+	vm_op_int: o = vmHandleInt(v, i); goto vm_op_done;
+	vm_op_unop: o = vmHandleUnOp(v, i); goto vm_op_done;
+	vm_op_binop: o = vmHandleBinOp(v, i); goto vm_op_done;
+	vm_op_string: o = vmHandleString(v, i); goto vm_op_done;
+	vm_op_return: o = vmHandleReturn(v, i); goto vm_op_done;
+	vm_op_extern: o = vmHandleExtern(v, i); goto vm_op_done;
+	vm_op_struct: o = vmHandleStruct(v, i); goto vm_op_done;
+	vm_op_typedef: o = vmHandleTypeDef(v, i); goto vm_op_done;
+	vm_op_varnew: o = vmHandleVarNew(v, i); goto vm_op_done;
+	vm_op_varasg: o = vmHandleVarAsg(v, i); goto vm_op_done;
+	vm_op_call: o = vmHandleCall(v, i); goto vm_op_done;
+	vm_op_varundefined: o = vmHandleVarUndefined(v, i); goto vm_op_done;
+	vm_op_ifstatement: o = vmHandleIfStatement(v, i); goto vm_op_done;
+	vm_op_while: o = vmHandleWhile(v, i); goto vm_op_done;
+	vm_op_for: o = vmHandleFor(v, i); goto vm_op_done;
+	vm_op_funcdec: o = vmHandleFuncDec(v, i); goto vm_op_done;
+	vm_op_funcdef: o = vmHandleFuncDef(v, i); goto vm_op_done;
+	vm_op_none: o = NULL;
+	vm_op_done:
+
+#else
+
+	/* call handler from table */
+	if (vm_handlers[op] != NULL)
+		o = vm_handlers[op](v, i);
+
+#endif
+
+	/* errors without a position are reported at the last node that finished */
+	if (errorIsSet() && !errorHasPos())
+		vmSetErrorPos(v, v->pos);
 
 	if (VM_DEBUG) fprintf(debug_file, "[vm] vm scope is '%s' in file '%s'\n", v->ctx->sn, v->ctx->fn);
 
@@ -1711,57 +2049,117 @@ extern object *vmHandle(vm *v, unsigned int i) {
 
 	else {
 
-		memcpy(debug_trace, &debug_trace[1], 7 * sizeof(object *));
+		memmove(debug_trace, &debug_trace[1], 7 * sizeof(object *));
 		debug_trace[7] = o;
 	}
 
-	/* get error info */
-	vmGetErrorInfo(v, &o->lineno, &o->colno);
-	if (o->fname == NULL) o->fname = v->ctx->fn;
+	/* position of node, it is only looked up if an error occurs later */
+	v->pos = vmNodePos(v, i);
 
 	if (VM_DEBUG) fprintf(debug_file, "[vm] finished interpreting object.\n");
 
 	return o; /* object */
 }
 
-/* load idata table */
-extern void vmLoadIdataTable(vm *v) {
+/* load the constant pool of tree bytecode */
+extern int vmLoadPool(vm *v) {
 
-	/* more debug info */
-	if (VM_DEBUG) fprintf(debug_file, "[vm] idata table: %p\n", v->idata);
+	u8 *bc = (u8 *)v->bc;
 
-	v->nidat = 0;
+	/* pool section */
+	unsigned int i, size;
 
-	/* search for idata table */
-	unsigned int i;
-	for (i = 8; i < v->bc_len; i++) {
+	if (bytecodeGetSection(bc, v->bc_len, BYTECODE_SECT_POOL, &i, &size) < 0 || size == 0) {
 
-		/* search for 0xfd */
-		if (((u8 *)v->bc)[i] == 0xFD) {
+		fprintf(stderr, "Invalid bytecode in file '%s'!\n", v->ctx->fn);
+		return -1;
+	}
 
-			i++; /* advance i to beginning of table */
+	/* number of entries */
+	unsigned int len;
+	v->n_pool = bytecodeGetVarint(&bc[i], &len);
+	i += len;
 
-			/* loop until we find '0x9b' is not a second character in a 6 byte sequence */
-			while ((i < (v->bc_len - 1)) && (((u8 *)v->bc)[i + 1] == 0x9B)) {
+	v->pool = (u8 **)malloc(sizeof(u8 *) * (v->n_pool + 1));
 
-				/* get position in idata */
-				unsigned int loc = (((u8*)v->bc)[i+2]<<24)|(((u8*)v->bc)[i+3]<<16)|(((u8*)v->bc)[i+4]<<8)|(((u8*)v->bc)[i+5]);
-			
-				/* set entry */
-				char *idt = &(((char *)v->bc)[loc]);
-				v->idata[v->nidat++] = idt;
-				if (VM_DEBUG) fprintf(debug_file, "[vm] idata: '%s'\n", idt);
+	unsigned int end = i + size;
 
-				/* advance i */
-				i += 6;
-			}
+	for (unsigned int k = 0; k < v->n_pool; k++) {
 
-			break;
+		/* every entry ends inside the section */
+		if (i >= end || (bc[i] == 0x9B && i + 1 >= end) || (bc[i] != 0x9B && memchr(&bc[i], 0, end - i) == NULL)) {
+
+			fprintf(stderr, "Invalid bytecode in file '%s'!\n", v->ctx->fn);
+			return -1;
+		}
+
+		v->pool[k] = &bc[i];
+		if (VM_DEBUG && bc[i] != 0x9B) fprintf(debug_file, "[vm] constant %u: '%s'\n", k, (char *)&bc[i + 1]);
+
+		if (bc[i] == 0x9B) {
+
+			bytecodeGetVarint(&bc[i + 1], &len);
+			i += len + 1;
 		}
+		else i += strlen((char *)&bc[i + 1]) + 2;
 	}
 
+	/* string objects by pool index */
+	if (IS_IDAT(v->bcflags))
+		v->strings = (object **)calloc(v->n_pool + 1, sizeof(object *));
+
 	/* debug */
-	if (VM_DEBUG) fprintf(debug_file, "[vm] loaded idata table successfully.\n");
+	if (VM_DEBUG) fprintf(debug_file, "[vm] loaded constant pool (%u entries).\n", v->n_pool);
+
+	return 0;
+}
+
+/* load the libraries in the library section */
+extern int vmLoadLibs(vm *v) {
+
+	unsigned int i, size;
+
+	if (bytecodeGetSection((u8 *)v->bc, v->bc_len, BYTECODE_SECT_LIBS, &i, &size) < 0 || (size && ((u8 *)v->bc)[i + size - 1] != 0)) {
+
+		fprintf(stderr, "Invalid bytecode in file '%s'!\n", v->ctx->fn);
+		return -1;
+	}
+
+	for (unsigned int end = i + size; i < end; ) {
+
+		/* interrupt */
+		if (INT_SIGNAL) {
+
+			/* set error */
+			errorSet(ERROR_TYPE_RUNTIME,
+					 ERROR_CODE_KBINT,
+					 "Keyboard interrupt");
+			errorSetPos(0, 0, v->ctx->fn);
+
+			INT_SIGNAL = 0;
+			return -1;
+		}
+
+		/* get name of library */
+		char *lib = &(((char *)v->bc)[i]);
+		i += strlen(lib) + 1;
+
+		/* load library */
+		if (vmLoadLib(lib) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* get an identifier (0x9F) and the number of bytes it takes */
+extern char *vmGetIdt(vm *v, unsigned int i, unsigned int *len) {
+
+	u8 *p = &((u8 *)v->bc)[i];
+
+	unsigned int k = bytecodeGetVarint(p, len);
+
+	return (char *)v->pool[k] + 1;
 }
 
 int _vmloadeddata = 0;
@@ -1902,16 +2300,33 @@ extern void vmExec(vm *v) {
 
 	if (VM_DEBUG) fprintf(debug_file, "[vm] flags for '%p': %02x\n", v, v->bcflags);
 
-	/* idata mode */
-	if (IS_IDAT(v->bcflags)) {
+	/* libraries */
+	if (vmLoadLibs(v) < 0)
+		return;
+
+	/* linear bytecode */
+	if (IS_LINEAR(v->bcflags)) {
+
+		interpExec(v);
+		return;
+	}
+
+	/* code section */
+	unsigned int i, size;
+
+	if (bytecodeGetSection((u8 *)v->bc, v->bc_len, BYTECODE_SECT_CODE, &i, &size) < 0) {
 
-		/* idata */
-		vmLoadIdataTable(v);
+		fprintf(stderr, "Invalid bytecode in file '%s'!\n", v->ctx->fn);
+		return;
 	}
 
+	/* constant pool */
+	if (v->pool == NULL && vmLoadPool(v) < 0)
+		return;
+
 	/* go through bytecode */
-	unsigned int i = 8;
-	while (i < v->bc_len && ((u8 *)v->bc)[i] != 0x00) {
+	unsigned int end = i + size;
+	while (i < end) {
 
 		/* set lowbi */
 		v->lowbi = i;
@@ -1920,117 +2335,184 @@ extern void vmExec(vm *v) {
 		if (((u8 *)v->bc)[i] == 0xFF) {
 
 			/* set filename */
-			v->ctx->fn = &((char *)v->bc)[i + 2];
+			unsigned int len;
+			v->ctx->fn = vmGetIdt(v, i + 1, &len);
 
 			/* debug info */
 			if (VM_DEBUG) fprintf(debug_file, "[vm] changed filename of scope '%s' to '%s'\n", v->ctx->sn, v->ctx->fn);
 
-			i += strlen(v->ctx->fn) + 3;
+			i += len + 1;
 		}
 
-		/* exit because we've reached the end with the idata table */
-		else if (((u8 *)v->bc)[i] == 0xFD) {
+		/* otherwise */
+		else {
 
-			break;
+			v->nofbytes = 0; /* reset the number of bytes recorded */
+			co = vmHandle(v, i); /* handle object */
+			i += v->nofbytes; /* advance number of bytes */
+
+			/* error */
+			if (co == NULL || errorIsSet()) {
+
+				if (VM_DEBUG) fprintf(debug_file, "[vm] error here\n");
+				return;
+			}
+
+			/* debug */
+			if (VM_DEBUG) fprintf(debug_file, "[vm] ----\n");
 		}
 
-		/* library reference */
-		else if (((u8 *)v->bc)[i] == 0xE0) {
+		vmCollect();
+	}
+}
 
-			/* interrupt */
-			if (INT_SIGNAL) {
+/* check if garbage should be collected at this point */
+extern int vmCollectDue() {
 
-				/* set error */
-				errorSet(ERROR_TYPE_RUNTIME,
-						 ERROR_CODE_KBINT,
-						 "Keyboard interrupt");
-				errorSetPos(0, 0, v->ctx->fn);
+	/* collection is running, or enough objects were created to start one
+	   (at least half as many as are alive, so sweeps stay proportional to allocation) */
+	return gbc_iter >= 0 || (n_new_objects >= gbc_len && n_new_objects * 2 >= n_of_objects - n_free_objects);
+}
 
-				INT_SIGNAL = 0;
-				return;
-			}
+/* collect garbage in steps of at most gbc_step slots */
+extern void vmCollect() {
 
-			char *fn = vmdctx->fn;
+	if (!vmCollectDue())
+		return;
 
-			/* get name of library */
-			char *lib = &(((char *)v->bc)[i + 1]);
-			i += strlen(lib) + 2;
+	/* start a new collection */
+	if (gbc_iter < 0) {
 
-			/* create vm from file */
-			vm *sv = vmNewFromFile(lib);
+		if (VM_DEBUG) fprintf(debug_file, "[vm] collecting (%d new, %d slots)\n", n_new_objects, n_of_objects);
+		gbc_iter = 0;
+	}
 
-			if (sv == NULL) {
+	int end = (gbc_step > 0)? gbc_iter + gbc_step: n_of_objects;
 
-				char *nm = (char *)malloc(strlen(lib));
-				strncpy(nm, lib, strlen(lib) - 3);
+	objectCollectRange(gbc_iter, end);
+	gbc_iter = end;
 
-				/* print and error and exit */
-				fprintf(stderr, "Failed to load mango library '%s'.\n", nm);
-				free(nm);
-				return;
-			}
+	/* reached the end of the object list */
+	if (gbc_iter >= n_of_objects) {
 
-			/* execute code */
-			vmExec(sv);
-			vmdctx->fn = fn;
+		objectCollectDone();
+		gbc_iter = -1;
+	}
+}
 
-			/* error */
-			if (errorIsSet()) {
+/* load and run a library */
+extern int vmLoadLib(char *lib) {
 
-				/* print the error and exit */
-				errorPrint();
-				return;
-			}
-		}
+	char *fn = vmdctx->fn;
 
-		/* otherwise */
-		else {
+	/* create vm from file */
+	vm *sv = vmNewFromFile(lib);
 
-			v->nofbytes = 0; /* reset the number of bytes recorded */
-			co = vmHandle(v, i); /* handle object */
-			i += v->nofbytes; /* advance number of bytes */
+	if (sv == NULL) {
 
-			/* error */
-			if (co == NULL || errorIsSet()) {
+		char *nm = (char *)malloc(strlen(lib) + 1);
+		strcpy(nm, lib);
 
-				if (VM_DEBUG) fprintf(debug_file, "[vm] error here\n");
-				return;
-			}
+		/* strip extension */
+		if (strlen(nm) > 3) nm[strlen(nm) - 3] = 0;
 
-			/* debug */
-			if (VM_DEBUG) fprintf(debug_file, "[vm] ----\n");
-		}
+		/* print and error and exit */
+		fprintf(stderr, "Failed to load mango library '%s'.\n", nm);
+		free(nm);
+		return -1;
+	}
+
+	/* execute code */
+	vmExec(sv);
+	vmdctx->fn = fn;
 
-		objectCollect();
+	/* error */
+	if (errorIsSet()) {
+
+		/* print the error and exit */
+		errorPrint();
+		return -1;
 	}
+
+	return 0;
 }
 
-/* get error info */
-extern void vmGetErrorInfo(vm *v, unsigned int *lineno, unsigned int *colno) {
+/* get object type from a type name (0xFF if the type doesn't exist) */
+extern unsigned char vmGetType(char *tp_name) {
 
-	/* get error info */
-	if (((u8 *)v->bc)[v->lowbi + v->nofbytes] == 0xFE) {
+	return typeGet(tp_name);
+}
 
-		/* get line and column numbers */
-		int pos = v->lowbi + v->nofbytes + 1;
-		unsigned int l = (((u8 *)v->bc)[pos] << 24) | (((u8 *)v->bc)[pos + 1] << 16) | (((u8 *)v->bc)[pos + 2] << 8) | (((u8 *)v->bc)[pos + 3]);
-		unsigned int c = (((u8 *)v->bc)[pos + 4] << 24) | (((u8 *)v->bc)[pos + 5] << 16) | (((u8 *)v->bc)[pos + 6] << 8) | (((u8 *)v->bc)[pos + 7]);
+/* get the position of the node at i (its offset in the bytecode, looked up in the line table if an error occurs) */
+extern unsigned int vmNodePos(vm *v, unsigned int i) {
 
-		/* set values */
-		*lineno = l;
-		*colno = c;
+	return v->bc_pos + i;
+}
 
-		/* debug info */
-		if (VM_DEBUG) fprintf(debug_file, "[vm] line and column numbers: %d, %d\n", l, c);
+/* read an unsigned integer (LEB128) at the current position and advance past it */
+extern unsigned int vmNextInt(vm *v) {
+
+	unsigned int len;
+	unsigned int n = bytecodeGetVarint(&((u8 *)v->bc)[v->lowbi + v->nofbytes], &len);
+
+	v->nofbytes += len;
+	return n;
+}
 
-		/* advance v->nofbytes */
-		v->nofbytes += 9;
+/* get line and column numbers of a position */
+extern void vmGetPos(vm *v, unsigned int pos, unsigned int *lineno, unsigned int *colno) {
+
+	/* no position */
+	if (pos == 0)
+		return;
+
+	/* line table of the file (bc points into it while a function runs) */
+	u8 *bc = (u8 *)v->bc - v->bc_pos;
+	unsigned int off, size;
+
+	if (bytecodeGetSection(bc, v->bc_len, BYTECODE_SECT_LINES, &off, &size) < 0)
+		return;
+
+	/* entries are in order of offset, each relative to the one before it */
+	unsigned int at = 0, line = 0, len;
+
+	for (u8 *p = &bc[off], *end = &bc[off + size]; p < end && at < pos; ) {
+
+		at += bytecodeGetVarint(p, &len);
+		p += len;
+		line += bytecodeGetInt(p, &len);
+		p += len;
+		unsigned int col = bytecodeGetVarint(p, &len);
+		p += len;
+
+		if (at == pos) {
+
+			*lineno = line;
+			*colno = col;
+		}
 	}
+
+	/* debug info */
+	if (VM_DEBUG) fprintf(debug_file, "[vm] line and column numbers: %d, %d\n", *lineno, *colno);
+}
+
+/* set the position of an error from a position (0 uses the last node that finished) */
+extern void vmSetErrorPos(vm *v, unsigned int pos) {
+
+	unsigned int lineno = 0, colno = 0;
+
+	vmGetPos(v, pos? pos: v->pos, &lineno, &colno);
+	errorSetPos(lineno, colno, v->ctx->fn);
 }
 
 /* free a vm */
 extern void vmFree(vm *v) {
 	
+	free(v->atoms);
+	free(v->strings);
+	free(v->pool);
+	free(v->fcache);
+	jitFree(v);
 	free(v->bc);
 	free(v);
 }
@@ -2052,6 +2534,10 @@ extern void vmFreeAll() {
 		if (vmdctx == NULL)
 			free(vmdctx);
 
+		/* free call frames and interpreter stacks */
+		contextFreeFrames();
+		interpFree();
+
 		/* free the list */
 		free(vm_list);
 	}
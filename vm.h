@@ -30,32 +30,98 @@
 
 /* macros */
 #define IS_IDAT(fl) (fl & 0x01)
+#define IS_LINEAR(fl) (fl & 0x02)
+
+/* use computed goto for node dispatch if the compiler supports it (define VM_NO_COMPUTED_GOTO to use the handler table instead) */
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+/* default maximum depth of function calls */
+#define VM_MAX_STACK 10000
+
+/* number of arguments a call node can pass without allocating a list */
+#define VM_CALL_ARGS 8
+
+/* number of struct field inline cache entries (power of two) */
+#define VM_FIELD_CACHE 1024
+
+/* struct field inline cache entry */
+typedef struct {
+	unsigned int pos; /* position of the field name in the code (0 = unused) */
+	void *templ; /* struct template the slot belongs to */
+	char *atom; /* interned field name */
+	unsigned int slot; /* index of the field in the struct's table of names */
+} vmFieldCache;
 
 /* vm struct */
 typedef struct {
 	context *ctx; /* context info */
 	void *bc; /* for running code */
 	unsigned int bc_len; /* length of bc */
+	unsigned int bc_pos; /* position of bc in the bytecode (function bodies in tree bytecode run with bc pointing to them) */
 	int fromf; /* if it was from a file, then we can free it's bytecode struct */
 	unsigned int nofbytes; /* number of bytes that an instruction took */
 	unsigned int lowbi; /* lowest byte index: the index of a byte when VM calls vmHandle directly */
 	unsigned char bcflags; /* flag values for bytecode */
-	char *idata[256]; /* 256 entries for idata */
-	unsigned char nidat; /* number of idata table entries added */
+	unsigned char **pool; /* constant pool entries of tree bytecode (pointers to their signature bytes) */
+	unsigned int n_pool; /* number of constant pool entries */
+	unsigned char *code; /* code section of linear bytecode */
+	unsigned int code_len; /* length of code section */
+	char *strs; /* string table of linear bytecode */
+	unsigned char *lines; /* line table of linear bytecode */
+	unsigned int n_lines; /* number of line table entries */
+	char **atoms; /* interned names by string table offset */
+	object **strings; /* constant objects of string literals by string table offset (position in tree bytecode) */
+	unsigned int pos; /* offset of the last node that finished, looked up in the line table if an error occurs */
+	vmFieldCache *fcache; /* inline caches of struct field slots */
+	void *jit; /* jit state (NULL until a region of code is counted) */
 } vm;
 
+/* node handler */
+typedef object *(*vm_handler_t)(vm *, unsigned int);
+
 /* functions */
 extern vm *vmNew(bytecode *bc); /* from existing bytecode */
 extern vm *vmNewFromFile(char *f); /* file */
 extern void vmExec(vm *v); /* execute code in a vm */
 extern void vmLoadBuiltins(); /* initialise builtin functions for VM */
-extern void vmLoadIdataTable(vm *v); /* load a vm's idata table if necessary */
+extern int vmLoadLibs(vm *v); /* load the libraries in the library section */
+extern int vmLoadPool(vm *v); /* load the constant pool of tree bytecode (-1 if it is invalid) */
+extern char *vmGetIdt(vm *v, unsigned int i, unsigned int *len); /* get an identifier (0x9F) and the number of bytes it takes */
 extern object *vmHandle(vm *v, unsigned int i); /* return an object from an instruction */
-extern void vmGetErrorInfo(vm *v, unsigned int *lineno, unsigned int *colno); /* get error information if there is any */
+extern object *vmStringNew(char *s); /* create the constant object of a string literal */
+extern object *vmHandleString(vm *v, unsigned int i); /* string (0x9E) */
+extern object *vmHandleInt(vm *v, unsigned int i); /* integer (0x9B) */
+extern object *vmHandleUnOp(vm *v, unsigned int i); /* unary operation (0x9C) */
+extern object *vmHandleBinOp(vm *v, unsigned int i); /* binary operation (0x9D) */
+extern object *vmHandleVarAsg(vm *v, unsigned int i); /* variable assignment and setitem (0xD2, 0xDD) */
+extern object *vmHandleVarAcc(vm *v, unsigned int i); /* variable access, increment, decrement and getitem (0xD6, 0xD3, 0xD4, 0x9A) */
+extern object *vmHandleVarUndefined(vm *v, unsigned int i); /* undefined variable (0xD7) */
+extern object *vmHandleVarNew(vm *v, unsigned int i); /* new variable (0xD1) */
+extern object *vmHandleCall(vm *v, unsigned int i); /* function call (0xD5) */
+extern int vmCallCheck(object *fnc, object **ob_args, int n_of_args); /* check that a function can be called with a list of arguments */
+extern object *vmCall(vm *v, object *fnc, object **ob_args, int n_of_args, unsigned int lineno, unsigned int colno, char *fname); /* call a function object */
+extern object *vmHandleFuncDef(vm *v, unsigned int i); /* function definition (0xDC) */
+extern object *vmHandleFuncDec(vm *v, unsigned int i); /* function declaration (0xDB) */
+extern object *vmHandleExtern(vm *v, unsigned int i); /* extern (0xC1) */
+extern object *vmHandleReturn(vm *v, unsigned int i); /* return (0xC0) */
+extern object *vmHandleIfStatement(vm *v, unsigned int i); /* if statement (0xD8) */
+extern object *vmHandleFor(vm *v, unsigned int i); /* for loop (0xDA) */
+extern object *vmHandleWhile(vm *v, unsigned int i); /* while loop (0xD9) */
+extern object *vmHandleStruct(vm *v, unsigned int i); /* struct (0xC2) */
+extern object *vmHandleTypeDef(vm *v, unsigned int i); /* typedef (0xC3) */
+extern vmFieldCache *vmFieldEntry(vm *v, unsigned int pos, char *name); /* get the inline cache entry of a field name in the code */
+extern unsigned int vmFieldIndex(vmFieldCache *c, object *s, char *name); /* get the slot of a field in a struct (n_of_names if it does not exist) */
+extern int vmCollectDue(); /* check if garbage should be collected at this point */
+extern void vmCollect(); /* collect garbage in steps once enough objects were created */
+extern int vmLoadLib(char *lib); /* load and run a library */
+extern unsigned char vmGetType(char *tp_name); /* get object type from a type name */
+extern unsigned int vmNodePos(vm *v, unsigned int i); /* get the position of the node at i */
+extern unsigned int vmNextInt(vm *v); /* read an unsigned integer (LEB128) at the current position and advance past it */
+extern void vmGetPos(vm *v, unsigned int pos, unsigned int *lineno, unsigned int *colno); /* get line and column numbers of a position */
+extern void vmSetErrorPos(vm *v, unsigned int pos); /* set the position of an error from a position (0 uses the last node that finished) */
 extern void vmFree(vm *v); /* free a vm */
 extern void vmFreeAll(); /* free all created vms */
 
-/* macros */
-#define vmGetInt(v, p) (((u8*)(v)->bc)[(p)+0]<<24)|(((u8*)(v)->bc)[(p)+1]<<16)|(((u8*)(v)->bc)[(p)+2]<<8)|(((u8*)(v)->bc)[(p)+3]<<0)
-
 #endif /* _VM_H */
\ No newline at end of file